@@ -7,6 +7,7 @@
 // Released under GPL license: see LICENSE.html for more information.
 // -------------------------------------------------------------------------
 
+#include <algorithm>
 #include <math.h>
 #include <stdarg.h>
 #include <time.h>
@@ -21,6 +22,9 @@
 #include "AAIBuildTask.h"
 #include "AAIConstructor.h"
 #include "AAIAttackManager.h"
+#include "AAIScheduler.h"
+#include "AAIUnitSnapshot.h"
+#include "AAIFrameArena.h"
 #include "AIExport.h"
 #include "AAIConfig.h"
 #include "AAIGroup.h"
@@ -62,7 +66,10 @@ AAI::AAI(int skirmishAIId, const struct SSkirmishAICallback* callback) :
 	m_unitTable(nullptr),
 	m_buildTable(nullptr),
 	m_airForceManager(nullptr),
+	m_unitSnapshot(nullptr),
+	m_frameArena(nullptr),
 	m_attackManager(nullptr),
+	m_scheduler(nullptr),
 	profiler(nullptr),
 	m_side(0),
 	m_logFile(nullptr),
@@ -131,6 +138,11 @@ AAI::~AAI()
 		Log("\n");
 	}
 
+	// time spent in the different parts of AAI (as measured by AAI_SCOPED_TIMER) to allow comparison of performance between games/versions
+	Log("\nProfiling results after %i frames:\n%s\n", m_aiCallback->GetCurrentFrame(), profiler->ToString().c_str());
+
+	m_scheduler->PrintStatistics();
+
 	// delete buildtasks
 	for(std::list<AAIBuildTask*>::iterator task = build_tasks.begin(); task != build_tasks.end(); ++task)
 	{
@@ -138,10 +150,10 @@ AAI::~AAI()
 	}
 	build_tasks.clear();
 
-	// save game learning data
-	if(GetAAIInstance() == 1)
-		m_buildTable->SaveModLearnData(gamePhase, m_brain->GetAttackedByRates(), m_map->GetMapType());
+	// save game learning data (if last user)
+	m_buildTable->ReleaseModLearnData(gamePhase, m_brain->GetAttackedByRates(), m_map->GetMapType());
 
+	spring::SafeDelete(m_scheduler);
 	spring::SafeDelete(m_attackManager);
 	spring::SafeDelete(m_airForceManager);
 
@@ -157,19 +169,19 @@ AAI::~AAI()
 	spring::SafeDelete(m_brain);
 	spring::SafeDelete(m_execute);
 	spring::SafeDelete(m_unitTable);
+	spring::SafeDelete(m_unitSnapshot);
+	spring::SafeDelete(m_frameArena);
 	spring::SafeDelete(m_map);
 	spring::SafeDelete(m_buildTable);
 	spring::SafeDelete(profiler);
 
-	m_initialized = false;
-	fclose(m_logFile);
-	m_logFile = nullptr;
-
 	// last instance of AAI shall clean up config
 	if(s_aaiInstances == 0)
-	{
 		AAIConfig::Delete();
-	}
+
+	m_initialized = false;
+	fclose(m_logFile);
+	m_logFile = nullptr;
 }
 
 //void AAI::EnemyDamaged(int damaged,int attacker,float damage,float3 dir) {}
@@ -228,6 +240,10 @@ void AAI::InitAI(IGlobalAICallback* callback, int team)
 	// init unit table
 	m_unitTable = new AAIUnitTable(this);
 
+	m_unitSnapshot = new AAIUnitSnapshot(m_aiCallback, cfg->MAX_UNITS);
+
+	m_frameArena = new AAIFrameArena(AAIConstants::frameArenaBlockSize);
+
 	// init map
 	m_map = new AAIMap(this, m_aiCallback->GetMapWidth(), m_aiCallback->GetMapHeight(), std::sqrt(m_aiCallback->GetLosMapResolution()) );
 
@@ -237,13 +253,9 @@ void AAI::InitAI(IGlobalAICallback* callback, int team)
 	// init brain
 	m_brain = new AAIBrain(this, m_map->GetMaxSectorDistanceToBase());
 
-	if(GetAAIInstance() == 1)
-	{
-		std::string filename = cfg->GetFileName(m_aiCallback, cfg->GetUniqueName(m_aiCallback, true, true, false, false), AILOG_PATH, "_buildtree.txt", true);
-		s_buildTree.PrintSummaryToFile(filename, m_aiCallback);
-
+	// attacked by rates are shared by all instances -> initialized by instance that loaded the mod learn data
+	if(m_buildTable->IsFirstModLearnDataUser())
 		m_brain->InitAttackedByRates( m_buildTable->GetAttackedByRates(m_map->GetMapType()) );
-	}
 
 	m_execute = new AAIExecute(this);
 
@@ -256,6 +268,10 @@ void AAI::InitAI(IGlobalAICallback* callback, int team)
 	// init attack manager
 	m_attackManager = new AAIAttackManager(this);
 
+	// init scheduler for periodic tasks
+	m_scheduler = new AAIScheduler(this);
+	RegisterScheduledTasks();
+
 	Log("Tidal/Wind strength: %f / %f\n", m_aiCallback->GetTidalStrength(), (m_aiCallback->GetMaxWind() + m_aiCallback->GetMinWind()) * 0.5f);
 
 	LogConsole("AAI loaded");
@@ -263,69 +279,119 @@ void AAI::InitAI(IGlobalAICallback* callback, int team)
 
 void AAI::UnitDamaged(int damaged, int attacker, float /*damage*/, float3 /*dir*/)
 {
-	AAI_SCOPED_TIMER("UnitDamaged")
+	// events are processed once per frame (see ProcessUnitDamagedEvents())
+	m_unitDamagedEvents.push_back( std::pair<int, int>(damaged, attacker) );
+}
 
-	const springLegacyAI::UnitDef* attackedDef = m_aiCallback->GetUnitDef(damaged);
-	if(attackedDef == nullptr)
+void AAI::ProcessUnitDamagedEvents()
+{
+	if(m_unitDamagedEvents.empty())
 		return;
-		
-	const UnitDefId unitDefId(attackedDef->id);
-	const AAIUnitCategory& category = s_buildTree.GetUnitCategory(unitDefId);
 
-	if(category.IsCommander())
-		m_brain->DefendCommander(attacker);
+	AAI_SCOPED_TIMER("UnitDamaged")
 
-	const springLegacyAI::UnitDef* attackerDef = m_aiCallback->GetUnitDef(attacker);
+	// coalesce events - several hits of the same unit by the same attacker only need to be handled once
+	std::sort(m_unitDamagedEvents.begin(), m_unitDamagedEvents.end());
+	m_unitDamagedEvents.erase( std::unique(m_unitDamagedEvents.begin(), m_unitDamagedEvents.end()), m_unitDamagedEvents.end() );
 
-	if(attackerDef == nullptr)
-	{
-		// ------------------------------------------------------------------------------------------------------------
-		// unknown attacker
-		// ------------------------------------------------------------------------------------------------------------
+	m_defenceRequests.clear();
 
-		// retreat builders
-		if (category.IsMobileConstructor() && m_unitTable->units[damaged].cons)
-			m_unitTable->units[damaged].cons->CheckRetreatFromAttackBy(EUnitCategory::UNKNOWN);	
-	}
-	else 
+	// events are sorted by damaged unit -> unit def of damaged unit only needs to be looked up once per unit
+	int lastDamaged(-1);
+	const springLegacyAI::UnitDef* attackedDef(nullptr);
+
+	for(const auto& event : m_unitDamagedEvents)
 	{
-		// ------------------------------------------------------------------------------------------------------------
-		// known attacker
-		// ------------------------------------------------------------------------------------------------------------
+		const int damaged  = event.first;
+		const int attacker = event.second;
+
+		if(damaged != lastDamaged)
+		{
+			attackedDef = m_unitSnapshot->GetUnitDef(UnitId(damaged));
+			lastDamaged = damaged;
+		}
 
-		// filter out friendly fire
-		if (m_aiCallback->GetUnitAllyTeam(attacker) == m_aiCallback->GetMyAllyTeam())
-			return;
+		if(attackedDef == nullptr)
+			continue;
+		
+		const UnitDefId unitDefId(attackedDef->id);
+		const AAIUnitCategory& category = s_buildTree.GetUnitCategory(unitDefId);
 
-		const UnitId    unit(damaged);
-		const UnitDefId enemyDefId(attackerDef->id);
+		if(category.IsCommander())
+			m_brain->DefendCommander(attacker);
 
-		if (category.IsCombatUnit())
-			m_execute->CheckKeepDistanceToEnemy(unit, unitDefId, enemyDefId);
+		const springLegacyAI::UnitDef* attackerDef = m_unitSnapshot->GetUnitDef(UnitId(attacker));
 
-		const AAITargetType&  enemyTargetType = s_buildTree.GetTargetType(enemyDefId);
-		const float3          pos = m_aiCallback->GetUnitPos(attacker);
-		
-		// building has been attacked
-		if (category.IsBuilding() )
-			m_execute->DefendUnitVS(unit, enemyTargetType, pos, AAIConstants::defendBaseUrgency);
-		// builder
-		else if ( category.IsMobileConstructor() )
+		if(attackerDef == nullptr)
 		{
-			const AAIUnitCategory&  enemyCategory = s_buildTree.GetUnitCategory(enemyDefId);
-
-			m_execute->DefendUnitVS(unit, enemyTargetType, pos, AAIConstants::defendConstructorsUrgency);
+			// ------------------------------------------------------------------------------------------------------------
+			// unknown attacker
+			// ------------------------------------------------------------------------------------------------------------
 
-			if(m_unitTable->units[damaged].cons)
-				m_unitTable->units[damaged].cons->CheckRetreatFromAttackBy(enemyCategory);
+			// retreat builders
+			if (category.IsMobileConstructor() && m_unitTable->units[damaged].cons)
+				m_unitTable->units[damaged].cons->CheckRetreatFromAttackBy(EUnitCategory::UNKNOWN);	
 		}
-		// normal units
-		else
+		else 
 		{
-			if(enemyTargetType.IsAir() && (s_buildTree.GetUnitType(unitDefId).CanFightTargetType(enemyTargetType) == false) ) 
-				m_execute->DefendUnitVS(unit, enemyTargetType, pos, AAIConstants::defendUnitsUrgency);
-		}	
-		
+			// ------------------------------------------------------------------------------------------------------------
+			// known attacker
+			// ------------------------------------------------------------------------------------------------------------
+
+			// filter out friendly fire
+			if (m_unitSnapshot->GetUnitAllyTeam(UnitId(attacker)) == m_aiCallback->GetMyAllyTeam())
+				continue;
+
+			const UnitId    unit(damaged);
+			const UnitDefId enemyDefId(attackerDef->id);
+
+			if (category.IsCombatUnit())
+				m_execute->CheckKeepDistanceToEnemy(unit, unitDefId, enemyDefId);
+
+			const AAITargetType&  enemyTargetType = s_buildTree.GetTargetType(enemyDefId);
+			const float3          pos = m_unitSnapshot->GetUnitPos(UnitId(attacker));
+			
+			// building has been attacked
+			if (category.IsBuilding() )
+				m_defenceRequests.push_back( DefenceRequest(attacker, unit, enemyTargetType, pos, AAIConstants::defendBaseUrgency) );
+			// builder
+			else if ( category.IsMobileConstructor() )
+			{
+				const AAIUnitCategory&  enemyCategory = s_buildTree.GetUnitCategory(enemyDefId);
+
+				m_defenceRequests.push_back( DefenceRequest(attacker, unit, enemyTargetType, pos, AAIConstants::defendConstructorsUrgency) );
+
+				if(m_unitTable->units[damaged].cons)
+					m_unitTable->units[damaged].cons->CheckRetreatFromAttackBy(enemyCategory);
+			}
+			// normal units
+			else
+			{
+				if(enemyTargetType.IsAir() && (s_buildTree.GetUnitType(unitDefId).CanFightTargetType(enemyTargetType) == false) ) 
+					m_defenceRequests.push_back( DefenceRequest(attacker, unit, enemyTargetType, pos, AAIConstants::defendUnitsUrgency) );
+			}	
+		}
+	}
+
+	m_unitDamagedEvents.clear();
+
+	// ------------------------------------------------------------------------------------------------------------
+	// dispatch defence - only one request per attacker (the one with the highest urgency)
+	// ------------------------------------------------------------------------------------------------------------
+	std::sort(m_defenceRequests.begin(), m_defenceRequests.end(), [](const DefenceRequest& lhs, const DefenceRequest& rhs)
+	{
+		if(lhs.attacker != rhs.attacker)
+			return (lhs.attacker < rhs.attacker);
+
+		return (lhs.urgency > rhs.urgency);
+	} );
+
+	for(size_t i = 0; i < m_defenceRequests.size(); ++i)
+	{
+		const DefenceRequest& request = m_defenceRequests[i];
+
+		if( (i == 0) || (request.attacker != m_defenceRequests[i-1].attacker) )
+			m_execute->DefendUnitVS(request.unitId, request.attackerTargetType, request.attackerPosition, request.urgency);
 	}
 }
 
@@ -335,6 +401,8 @@ void AAI::UnitCreated(int unit, int builder)
 	if (m_configLoaded == false)
 		return;
 
+	m_unitSnapshot->InvalidateUnit(UnitId(unit));
+
 	// get unit's id
 	const springLegacyAI::UnitDef* def = m_aiCallback->GetUnitDef(unit);
 	const UnitDefId unitDefId(def->id);
@@ -427,6 +495,8 @@ void AAI::UnitFinished(int unit)
 	if (m_initialized == false)
         return;
 
+	m_unitSnapshot->InvalidateUnit(UnitId(unit));
+
 	// get unit's id
 	const springLegacyAI::UnitDef* def = m_aiCallback->GetUnitDef(unit);
 	const UnitDefId unitDefId(def->id);
@@ -436,6 +506,7 @@ void AAI::UnitFinished(int unit)
 
 	m_unitTable->UnitFinished(category);
 	m_buildTable->ConstructionFinished(unitDefId);
+	m_map->FriendlyUnitFinished(unitId, unitDefId);
 
 	// building was completed
 	if (s_buildTree.GetMovementType(unitDefId).IsStatic())
@@ -544,6 +615,8 @@ void AAI::UnitFinished(int unit)
 void AAI::UnitDestroyed(int unit, int attacker)
 {
 	AAI_SCOPED_TIMER("UnitDestroyed")
+	m_unitSnapshot->InvalidateUnit(UnitId(unit));
+
 	// get unit's id
 	const springLegacyAI::UnitDef* def = m_aiCallback->GetUnitDef(unit);
 	UnitDefId unitDefId(def->id);
@@ -561,6 +634,8 @@ void AAI::UnitDestroyed(int unit, int attacker)
 			sector->UpdateThreatValues(unitDefId, UnitDefId(att_def->id));
 	}
 
+	m_map->FriendlyUnitDestroyed(UnitId(unit));
+
 	// unfinished unit has been killed
 	if (m_aiCallback->UnitBeingBuilt(unit))
 	{
@@ -770,17 +845,54 @@ void AAI::UnitMoveFailed(int unit)
 		m_execute->SendUnitToPosition(UnitId(unit), pos);
 }
 
-void AAI::EnemyEnterLOS(int /*enemy*/) {}
-void AAI::EnemyLeaveLOS(int /*enemy*/) {}
-void AAI::EnemyEnterRadar(int /*enemy*/) {}
-void AAI::EnemyLeaveRadar(int /*enemy*/) {}
+// unit definition of enemy units is only available within LOS -> discard cached values when visibility changes
+void AAI::EnemyEnterLOS(int enemy)
+{
+	if(m_initialized == false)
+		return;
+
+	AAI_SCOPED_TIMER("EnemyEnterLOS")
+	m_unitSnapshot->InvalidateUnit(UnitId(enemy));
+	m_map->EnemyEnteredLOS(UnitId(enemy));
+}
+
+void AAI::EnemyLeaveLOS(int enemy)
+{
+	if(m_initialized == false)
+		return;
+
+	m_unitSnapshot->InvalidateUnit(UnitId(enemy));
+	m_map->EnemyLeftLOS(UnitId(enemy));
+}
+
+void AAI::EnemyEnterRadar(int enemy)
+{
+	if(m_initialized == false)
+		return;
+
+	m_unitSnapshot->InvalidateUnit(UnitId(enemy));
+	m_map->EnemyEnteredRadar(UnitId(enemy));
+}
+
+void AAI::EnemyLeaveRadar(int enemy)
+{
+	if(m_initialized == false)
+		return;
+
+	m_unitSnapshot->InvalidateUnit(UnitId(enemy));
+	m_map->EnemyLeftRadar(UnitId(enemy));
+}
 
 void AAI::EnemyDestroyed(int enemy, int attacker)
 {
 	AAI_SCOPED_TIMER("EnemyDestroyed")
 	// remove enemy from unittable
 	if(UnitId(enemy).IsValid())
+	{
 		m_unitTable->EnemyKilled(enemy);
+		m_unitSnapshot->InvalidateUnit(UnitId(enemy));
+		m_map->EnemyDestroyed(UnitId(enemy));
+	}
 
 	if(UnitId(attacker).IsValid())
 	{
@@ -817,130 +929,160 @@ void AAI::Update()
 			LogConsole("Failed to initialize AAI! Please view ai log for further information and check if AAI supports this game");
 		}
 
+		m_unitDamagedEvents.clear();
 		return;
 	}
 
-	// scouting
-	if (!((tick + 2 * GetAAIInstance()) % 45))
+	m_unitSnapshot->SetFrame(tick);
+
+	ProcessUnitDamagedEvents();
+
+	m_scheduler->Update(tick);
+
+	// transient containers of planning code are not used beyond the current update
+	m_frameArena->Reset();
+}
+
+void AAI::RegisterScheduledTasks()
+{
+	// task name, period, offset, priority, expected execution time (microseconds), function
+	m_scheduler->AddTask("Scouting_1", 45, 45 - (2 * GetAAIInstance()) % 45, 4, 1000, [this]()
 	{
 		AAI_SCOPED_TIMER("Scouting_1")
 		m_map->CheckUnitsInLOSUpdate();
-	}
+		return true;
+	} );
 
-	// update groups
-	if (!((tick+7) % 150))
+	// update groups (one combat unit category per call)
+	int nextCombatCategoryIndex(0);
+	m_scheduler->AddTask("Groups", 150, 143, 3, 500, [this, nextCombatCategoryIndex]() mutable
 	{
 		AAI_SCOPED_TIMER("Groups")
-		for (const auto& category : s_buildTree.GetCombatUnitCatgegories())
+		const auto& combatCategories = s_buildTree.GetCombatUnitCatgegories();
+
+		for (auto group : GetUnitGroupsList(combatCategories[nextCombatCategoryIndex]))
 		{
-			for (auto group : GetUnitGroupsList(category))
-			{
-				group->Update();
-			}
+			group->Update();
 		}
 
-		return;
-	}
+		++nextCombatCategoryIndex;
+
+		if(nextCombatCategoryIndex < static_cast<int>(combatCategories.size()))
+			return false;
 
-	// unit management
-	if (!(tick % 650))
+		nextCombatCategoryIndex = 0;
+		return true;
+	} );
+
+	m_scheduler->AddTask("Unit-Management", 650, 0, 2, 1000, [this]()
 	{
 		AAI_SCOPED_TIMER("Unit-Management")
 		m_execute->AdjustUnitProductionRate();
 		m_brain->BuildUnits();
 		m_execute->BuildScouts();
-	}
+		return true;
+	} );
 
-	if (!((tick+39) % 500))
+	m_scheduler->AddTask("Check-Attack", 500, 461, 2, 1500, [this]()
 	{
 		AAI_SCOPED_TIMER("Check-Attack")
-		// check attack
-		m_attackManager->Update(*m_threatMap);
+		// check attacks (one per call), continue in next frame until new attack has been considered
+		if(m_attackManager->Update(*m_threatMap) == false)
+			return false;
 
 		//! @todo refactor storage/handling of threat map
-		m_threatMap->UpdateLocalEnemyCombatPower(ETargetType::AIR, Map()->GetSectorMap());
+		m_threatMap->UpdateLocalEnemyCombatPower(ETargetType::AIR, Map()->GetSectorGrid());
 		m_airForceManager->CheckStaticBombTargets(*m_threatMap);
 		m_airForceManager->AirRaidBestTarget(2.0f);
-		return;
-	}
+		return true;
+	} );
 
 	// ressource management
-	if (!(tick % 200))
+	m_scheduler->AddTask("Resource-Management", 200, 0, 2, 300, [this]()
 	{
 		AAI_SCOPED_TIMER("Resource-Management")
 		m_execute->CheckRessources();
-	}
+		return true;
+	} );
 
-	// update sectors
-	if (!((tick+15) % 120))
+	m_scheduler->AddTask("Update-Sectors", 120, 105, 3, 500, [this]()
 	{
 		AAI_SCOPED_TIMER("Update-Sectors")
+		// sectors are updated in several steps, remaining values only updated once all sectors have been processed
+		if(m_map->UpdateSectors(m_threatMap) == false)
+			return false;
+
 		m_brain->UpdateAttackedByValues();
-		m_map->UpdateSectors(m_threatMap);
 		m_brain->UpdatePressureByEnemy(m_map->GetSectorMap());
-	}
+		return true;
+	} );
 
-	// builder management
-	if (!(tick % 917))
+	m_scheduler->AddTask("Builder-Management", 917, 0, 1, 300, [this]()
 	{
 		AAI_SCOPED_TIMER("Builder-Management")
 		m_brain->UpdateDefenceCapabilities();
-	}
+		return true;
+	} );
 
-	// update income
-	if (!(tick % 30))
+	m_scheduler->AddTask("Update-Income", 30, 0, 5, 100, [this]()
 	{
 		AAI_SCOPED_TIMER("Update-Income")
 		m_brain->UpdateResources(m_aiCallback);
-	}
+		return true;
+	} );
 
-	// building management
-	if (!(tick % 97))
+	m_scheduler->AddTask("Building-Management", 97, 0, 3, 1500, [this]()
 	{
 		AAI_SCOPED_TIMER("Building-Management")
 		m_execute->CheckConstruction();
-	}
+		return true;
+	} );
 
-	// builder/factory management
-	if (!(tick % 677))
+	m_scheduler->AddTask("BuilderAndFactory-Management", 677, 0, 1, 1000, [this]()
 	{
 		AAI_SCOPED_TIMER("BuilderAndFactory-Management")
 		m_unitTable->UpdateConstructors();
 		m_execute->CheckConstructionOfNanoTurret();
-	}
+		return true;
+	} );
 
-	if (!(tick % 337))
+	m_scheduler->AddTask("Check-Factories", 337, 0, 1, 500, [this]()
 	{
 		AAI_SCOPED_TIMER("Check-Factories")
 		m_execute->CheckFactories();
-	}
+		return true;
+	} );
 
-	if (!(tick % 1079))
+	m_scheduler->AddTask("Check-Defenses", 1079, 0, 1, 1500, [this]()
 	{
 		AAI_SCOPED_TIMER("Check-Defenses")
 		m_execute->CheckDefences();
-	}
+		return true;
+	} );
 
 	// build radar/jammer
-	if (!((tick+77) % 1200))
+	m_scheduler->AddTask("Check-Recon", 1200, 1123, 0, 1000, [this]()
 	{
+		AAI_SCOPED_TIMER("Check-Recon")
 		m_execute->CheckRecon();
 		//execute->CheckJammer();
 		m_execute->CheckStationaryArty();
 		//execute->CheckAirBase();
-	}
+		return true;
+	} );
 
 	// upgrade mexes
-	if (!((tick+11) % 300))
+	m_scheduler->AddTask("Check Upgrades", 300, 289, 1, 500, [this]()
 	{
 		AAI_SCOPED_TIMER("Check Upgrades")
 		m_execute->CheckExtractorUpgrade();
 		m_execute->CheckRadarUpgrade();
 		//execute->CheckJammerUpgrade();
-	}
+		return true;
+	} );
 
 	// recheck rally points
-	if (!(tick % 1877))
+	m_scheduler->AddTask("Recheck-Rally-Points", 1877, 0, 0, 500, [this]()
 	{
 		AAI_SCOPED_TIMER("Recheck-Rally-Points")
 		for (auto category = s_buildTree.GetCombatUnitCatgegories().begin();  category != s_buildTree.GetCombatUnitCatgegories().end(); ++category)
@@ -950,7 +1092,8 @@ void AAI::Update()
 				(*group)->CheckUpdateOfRallyPoint();
 			}
 		}
-	}
+		return true;
+	} );
 }
 
 const int* AAI::GetLosMap()
@@ -984,6 +1127,9 @@ int AAI::HandleEvent(int msg, const void* data)
 			{
 				const IGlobalAI::ChangeTeamEvent* cte = (const IGlobalAI::ChangeTeamEvent*) data;
 
+				if(m_unitSnapshot)
+					m_unitSnapshot->InvalidateUnit(UnitId(cte->unit));
+
 				const int myAllyTeamId = m_aiCallback->GetMyAllyTeam();
 				const bool oldEnemy = !m_aiCallback->IsAllied(myAllyTeamId, m_aiCallback->GetTeamAllyTeam(cte->oldteam));
 				const bool newEnemy = !m_aiCallback->IsAllied(myAllyTeamId, m_aiCallback->GetTeamAllyTeam(cte->newteam));
@@ -11,6 +11,7 @@
 #define AAI_H
 
 #include <list>
+#include <utility>
 #include <vector>
 
 #include "ExternalAI/Interface/SSkirmishAICallback.h"
@@ -36,6 +37,9 @@ class AAIUnitTable;
 class AAIMap;
 class AAIThreatMap;
 class AAIGroup;
+class AAIScheduler;
+class AAIUnitSnapshot;
+class AAIFrameArena;
 
 class AAI : public IGlobalAI
 {
@@ -115,6 +119,8 @@ public:
 	AAIUnitTable* const       UnitTable()   { return m_unitTable; }
 	AAIBuildTable* const      BuildTable()  { return m_buildTable; }
 	AAIAirForceManager* const AirForceMgr() { return m_airForceManager; }
+	AAIUnitSnapshot* const    UnitSnapshot() { return m_unitSnapshot; }
+	AAIFrameArena* const      FrameArena()  { return m_frameArena; }
 
 	//! The buildtree (who builds what, which unit belongs to which side, ...)
 	static AAIBuildTree s_buildTree;
@@ -122,6 +128,25 @@ public:
 private:
 	Profiler* GetProfiler(){ return profiler; }
 
+	//! @brief Registers the periodic tasks (executed by the scheduler)
+	void RegisterScheduledTasks();
+
+	//! @brief Handles all unit damaged events received since the last update (several hits of the same unit by the same attacker are handled only once)
+	void ProcessUnitDamagedEvents();
+
+	//! A request to support a unit attacked by an enemy (collected while processing unit damaged events)
+	struct DefenceRequest
+	{
+		DefenceRequest(int attacker, UnitId unitId, const AAITargetType& attackerTargetType, const float3& attackerPosition, float urgency) :
+			attacker(attacker), unitId(unitId), attackerTargetType(attackerTargetType), attackerPosition(attackerPosition), urgency(urgency) {}
+
+		int           attacker;
+		UnitId        unitId;
+		AAITargetType attackerTargetType;
+		float3        attackerPosition;
+		float         urgency;
+	};
+
 	//! Pointer to AI callback
 	IAICallback* m_aiCallback;
 
@@ -157,6 +182,12 @@ private:
 	
 	//! The air force manager coordinates combat air units
 	AAIAirForceManager* m_airForceManager;
+
+	//! Caches position, unit definition, team, etc. of units queried from the engine within the current frame
+	AAIUnitSnapshot*    m_unitSnapshot;
+
+	//! Memory for transient containers used within one update (reset at the end of every update)
+	AAIFrameArena*      m_frameArena;
 public:	
 	//! The attack manager coordinates attakcs by ground and sea units
 	AAIAttackManager*   m_attackManager;
@@ -164,6 +195,15 @@ private:
 	//! List of groups of unit of the different categories
 	std::vector< std::list<AAIGroup*> > m_unitGroupsOfCategoryLists;
 
+	//! The scheduler executes periodic tasks and distributes them over several frames to avoid load peaks
+	AAIScheduler*       m_scheduler;
+
+	//! Unit damaged events (damaged unit, attacker) received since the last update
+	std::vector< std::pair<int, int> > m_unitDamagedEvents;
+
+	//! Buffer for the defence requests resulting from the unit damaged events of the current frame (kept to avoid reallocation every frame)
+	std::vector<DefenceRequest> m_defenceRequests;
+
 	Profiler* profiler;
 
 	//! Id of the team (not ally team) of the AAI instance
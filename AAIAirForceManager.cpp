@@ -21,6 +21,7 @@
 #include "AAIBrain.h"
 #include "AAIAttackManager.h"
 #include "AAIThreatMap.h"
+#include "AAIUnitSnapshot.h"
 
 #include "LegacyCpp/UnitDef.h"
 
@@ -36,9 +37,9 @@ AAIAirForceManager::~AAIAirForceManager(void)
 void AAIAirForceManager::CheckTarget(const UnitId& unitId, const AAITargetType& targetType, float health)
 {
 	// do not attack own units
-	if(ai->GetAICallback()->GetUnitTeam(unitId.id) != ai->GetMyTeamId()) 
+	if(ai->UnitSnapshot()->GetUnitTeam(unitId) != ai->GetMyTeamId()) 
 	{
-		const float3     position = ai->GetAICallback()->GetUnitPos(unitId.id);
+		const float3     position = ai->UnitSnapshot()->GetUnitPos(unitId);
 		const AAISector* sector   = ai->Map()->GetSectorOfPos(position);
 
 		// check if unit is within the map
@@ -65,12 +66,12 @@ bool AAIAirForceManager::CheckIfStaticBombTarget(UnitId unitId, UnitDefId unitDe
 	const AAIUnitCategory&    category = ai->s_buildTree.GetUnitCategory(unitDefId);
 	int maximumNumberOfTargets;
 
-	if(category.IsStaticArtillery() || category.IsStaticSupport())
+	if(IsMilitaryBombTarget(category))
 	{
 		targets = &m_militaryTargets;
 		maximumNumberOfTargets = cfg->MAX_MILITARY_TARGETS;
 	}
-	else if(category.IsPowerPlant() || category.IsMetalExtractor() || category.IsMetalMaker())
+	else if(IsEconomyBombTarget(category))
 	{
 		targets = &m_economyTargets;
 		maximumNumberOfTargets = cfg->MAX_ECONOMY_TARGETS;
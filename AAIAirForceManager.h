@@ -52,6 +52,15 @@ public:
 	//! @brief Checks if target is possible bombing target and adds to list of bomb targets (used for buildings e.g. stationary arty, nuke launchers..)
 	bool CheckIfStaticBombTarget(UnitId unitId, UnitDefId unitDefId, const float3& position);
 
+	//! @brief Returns true if buildings of the given category may be added as static bomb targets
+	static bool IsPossibleStaticBombTarget(const AAIUnitCategory& category) { return IsMilitaryBombTarget(category) || IsEconomyBombTarget(category); }
+
+	//! @brief Returns true if buildings of the given category are added to the military bomb targets
+	static bool IsMilitaryBombTarget(const AAIUnitCategory& category) { return category.IsStaticArtillery() || category.IsStaticSupport(); }
+
+	//! @brief Returns true if buildings of the given category are added to the economy bomb targets
+	static bool IsEconomyBombTarget(const AAIUnitCategory& category) { return category.IsPowerPlant() || category.IsMetalExtractor() || category.IsMetalMaker(); }
+
 	//! @brief Checks all current bomb targets if they are still valid
 	void CheckStaticBombTargets(const AAIThreatMap& threatMap);
 
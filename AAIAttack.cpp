@@ -234,7 +234,7 @@ void AAIAttack::DetermineTargetTypeOfInvolvedUnits(MobileTargetTypeValues& targe
 		targetTypesOfUnits.AddValueForTargetType( group->GetTargetType(), static_cast<float>( group->GetCurrentSize() ) );
 }
 
-void AAIAttack::AddGroupsOfTargetType(const std::list<AAIGroup*>& groupList, const AAITargetType& targetType)
+void AAIAttack::AddGroupsOfTargetType(const AAIFrameVector<AAIGroup*>& groupList, const AAITargetType& targetType)
 {
 	for(auto group : groupList)
 	{
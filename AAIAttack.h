@@ -12,6 +12,7 @@
 
 #include <set>
 #include "AAITypes.h"
+#include "AAIFrameArena.h"
 
 class AAI;
 class AAISector;
@@ -24,7 +25,7 @@ public:
 	~AAIAttack(void);
 
 	//! @brief Adds all groups in the list of specified target type
-	void AddGroupsOfTargetType(const std::list<AAIGroup*>& groupList, const AAITargetType& targetType);
+	void AddGroupsOfTargetType(const AAIFrameVector<AAIGroup*>& groupList, const AAITargetType& targetType);
 
 	//! @brief Removes group from the attack (e.g. if group is deleted)
 	void RemoveGroup(AAIGroup *group);
@@ -16,9 +16,12 @@
 #include "AAIMap.h"
 #include "AAISector.h"
 
+#include <array>
+
 AAIAttackManager::AAIAttackManager(AAI *ai) :
 	ai(ai),
-	m_activeAttacks(AAIConstants::maxNumberOfAttacks, nullptr)
+	m_activeAttacks(AAIConstants::maxNumberOfAttacks, nullptr),
+	m_nextAttackIdToCheck(0)
 {
 }
 
@@ -33,30 +36,36 @@ AAIAttackManager::~AAIAttackManager(void)
 	m_activeAttacks.clear();
 }
 
-void AAIAttackManager::Update(AAIThreatMap& threatMap)
+bool AAIAttackManager::Update(AAIThreatMap& threatMap)
 {
+	if(m_nextAttackIdToCheck < static_cast<int>(m_activeAttacks.size()))
+	{
+		AAIAttack* attack = m_activeAttacks[m_nextAttackIdToCheck];
+
+		// drop failed attacks or check if sector cleared
+		if( attack && (AbortAttackIfFailed(attack) == false) && attack->HasTargetBeenCleared() )
+			AttackNextSectorOrAbort(attack);
+
+		++m_nextAttackIdToCheck;
+		return false;
+	}
+
+	m_nextAttackIdToCheck = 0;
+
+	// attacks may have been aborted since they have been checked -> look for available attack id now
 	int availableAttackId(-1);
 
-	for(int attackId = 0; attackId < m_activeAttacks.size(); ++attackId)
+	for(int attackId = 0; attackId < static_cast<int>(m_activeAttacks.size()); ++attackId)
 	{
-		AAIAttack* attack = m_activeAttacks[attackId];
-
-		if(attack)
-		{
-			// drop failed attacks
-			if( AbortAttackIfFailed(attack) )
-				availableAttackId = attackId;
-			// check if sector cleared
-			else if( attack->HasTargetBeenCleared() )
-				AttackNextSectorOrAbort(attack);
-		}
-		else
+		if(m_activeAttacks[attackId] == nullptr)
 			availableAttackId = attackId;
 	}
 
 	// at least one attack id is available -> check if new attack should be launched
 	if(availableAttackId >= 0)
 		TryToLaunchAttack(availableAttackId, threatMap);
+
+	return true;
 }
 
 void AAIAttackManager::TryToLaunchAttack(int availableAttackId, AAIThreatMap& threatMap)
@@ -65,12 +74,14 @@ void AAIAttackManager::TryToLaunchAttack(int availableAttackId, AAIThreatMap& th
 	// get all available combat/aa/arty groups for attack
 	//////////////////////////////////////////////////////////////////////////////////////////////
 	
+	const AAIFrameAllocator<AAIGroup*> allocator(ai->FrameArena());
+
 	const int numberOfContinents( AAIMap::GetNumberOfContinents() );
-	std::vector< std::list<AAIGroup*> > availableAssaultGroupsOnContinent(numberOfContinents);
-	std::vector< std::list<AAIGroup*> > availableAAGroupsOnContinent(numberOfContinents);
+	AAIFrameVector< AAIFrameVector<AAIGroup*> > availableAssaultGroupsOnContinent(numberOfContinents, AAIFrameVector<AAIGroup*>(allocator), allocator);
+	AAIFrameVector< AAIFrameVector<AAIGroup*> > availableAAGroupsOnContinent(numberOfContinents, AAIFrameVector<AAIGroup*>(allocator), allocator);
 
-	std::list<AAIGroup*> availableAssaultGroupsGlobal;
-	std::list<AAIGroup*> availableAAGroupsGlobal;
+	AAIFrameVector<AAIGroup*> availableAssaultGroupsGlobal(allocator);
+	AAIFrameVector<AAIGroup*> availableAAGroupsGlobal(allocator);
 
 	const int numberOfAssaultUnitGroups = DetermineCombatUnitGroupsAvailableForattack(availableAssaultGroupsGlobal, availableAAGroupsGlobal,
 																				availableAssaultGroupsOnContinent, availableAAGroupsOnContinent);
@@ -102,7 +113,7 @@ void AAIAttackManager::TryToLaunchAttack(int availableAttackId, AAIThreatMap& th
 	// determine target types of attackers
 	//////////////////////////////////////////////////////////////////////////////////////////////
 
-	std::list<AAITargetType> attackerTargetTypes;
+	AAIFrameVector<AAITargetType> attackerTargetTypes(allocator);
 
 	for(auto targetType : AAITargetType::m_mobileTargetTypes)
 	{
@@ -117,7 +128,7 @@ void AAIAttackManager::TryToLaunchAttack(int availableAttackId, AAIThreatMap& th
 
 	for(auto targetType : attackerTargetTypes)
 	{
-		threatMap.UpdateLocalEnemyCombatPower(targetType, ai->Map()->GetSectorMap());
+		threatMap.UpdateLocalEnemyCombatPower(targetType, ai->Map()->GetSectorGrid());
 
 		const MapPos baseCenter = ai->Brain()->GetCenterOfBase();
 		const AAISector* targetSector = threatMap.DetermineSectorToAttack(targetType, baseCenter, ai->Map()->GetSectorMap());
@@ -138,7 +149,7 @@ void AAIAttackManager::TryToLaunchAttack(int availableAttackId, AAIThreatMap& th
 			if(    (ai->Brain()->m_maxSpottedCombatUnitsOfTargetType.GetValueOfTargetType(ETargetType::AIR) > 0.2f)
 				|| (ai->Brain()->GetRecentAttacksBy(ETargetType::AIR) > 0.9f) )
 			{
-				std::list<AAIGroup*> antiAirGroups;
+				AAIFrameVector<AAIGroup*> antiAirGroups(allocator);
 				SelectNumberOfGroups(antiAirGroups, 1, availableAAGroupsOnContinent[continentId], availableAAGroupsGlobal);
 
 				attack->AddGroupsOfTargetType(antiAirGroups, targetType);
@@ -159,7 +170,7 @@ void AAIAttackManager::TryToLaunchAttack(int availableAttackId, AAIThreatMap& th
 	}
 }
 
-void AAIAttackManager::SelectNumberOfGroups(std::list<AAIGroup*> selectedGroupList, int maxNumberOfGroups, std::list<AAIGroup*> groupList1, std::list<AAIGroup*> groupList2)
+void AAIAttackManager::SelectNumberOfGroups(AAIFrameVector<AAIGroup*>& selectedGroupList, int maxNumberOfGroups, const AAIFrameVector<AAIGroup*>& groupList1, const AAIFrameVector<AAIGroup*>& groupList2) const
 {
 	int numberOfSelectedGroups(0);
 
@@ -182,12 +193,12 @@ void AAIAttackManager::SelectNumberOfGroups(std::list<AAIGroup*> selectedGroupLi
 	}
 }
 
-int AAIAttackManager::DetermineCombatUnitGroupsAvailableForattack(  std::list<AAIGroup*>&                availableAssaultGroupsGlobal,
-																	std::list<AAIGroup*>&                availableAAGroupsGlobal,
-																	std::vector< std::list<AAIGroup*> >& availableAssaultGroupsOnContinent,
-																	std::vector< std::list<AAIGroup*> >& availableAAGroupsOnContinent) const
+int AAIAttackManager::DetermineCombatUnitGroupsAvailableForattack(  AAIFrameVector<AAIGroup*>&                   availableAssaultGroupsGlobal,
+																	AAIFrameVector<AAIGroup*>&                   availableAAGroupsGlobal,
+																	AAIFrameVector< AAIFrameVector<AAIGroup*> >& availableAssaultGroupsOnContinent,
+																	AAIFrameVector< AAIFrameVector<AAIGroup*> >& availableAAGroupsOnContinent) const
 {
-	const std::vector<AAIUnitCategory> combatUnitCategories = { AAIUnitCategory(EUnitCategory::GROUND_COMBAT), 
+	const std::array<AAIUnitCategory, 4> combatUnitCategories = { AAIUnitCategory(EUnitCategory::GROUND_COMBAT), 
 															AAIUnitCategory(EUnitCategory::HOVER_COMBAT), 
 															AAIUnitCategory(EUnitCategory::SEA_COMBAT),
 															AAIUnitCategory(EUnitCategory::SUBMARINE_COMBAT) };
@@ -13,6 +13,7 @@
 #include "aidef.h"
 #include "AAITypes.h"
 #include "AAIThreatMap.h"
+#include "AAIFrameArena.h"
 #include <set>
 #include <list>
 #include <vector>
@@ -28,8 +29,9 @@ public:
 
 	~AAIAttackManager(void);
 
-	//! @brief Checks all active attacks whether they should be aborted or continue with a different destination
-	void Update(AAIThreatMap& threatMap);
+	//! @brief Checks one active attack per call whether it should be aborted or continue with a different destination; after all attacks
+	//!        have been checked, the next call checks if a new attack shall be launched. Returns true if finished, false if update shall be continued
+	bool Update(AAIThreatMap& threatMap);
 
 	//! @brief Stops the given attack if it is no longer reasonable (because of lacking combat power or attacking units)
 	//!        Returns whether attack has been aborted.
@@ -40,11 +42,11 @@ public:
 
 private:
 	//! @brief Selects given number of groups from the two given lists (list1 has priority)
-	void SelectNumberOfGroups(std::list<AAIGroup*> selectedGroupList, int maxNumberOfGroups, std::list<AAIGroup*> groupList1, std::list<AAIGroup*> groupList2);
+	void SelectNumberOfGroups(AAIFrameVector<AAIGroup*>& selectedGroupList, int maxNumberOfGroups, const AAIFrameVector<AAIGroup*>& groupList1, const AAIFrameVector<AAIGroup*>& groupList2) const;
 
 	//! @brief Determines which groups would be available for an attack globally/on each continent and returns the total number of available assault groups
-	int DetermineCombatUnitGroupsAvailableForattack(std::list<AAIGroup*>& availableAssaultGroupsGlobal, std::list<AAIGroup*>& availableAAGroupsGlobal,
-													std::vector< std::list<AAIGroup*> >& availableAssaultGroupsOnContinent, std::vector< std::list<AAIGroup*> >& availableAAGroupsOnContinent) const;
+	int DetermineCombatUnitGroupsAvailableForattack(AAIFrameVector<AAIGroup*>& availableAssaultGroupsGlobal, AAIFrameVector<AAIGroup*>& availableAAGroupsGlobal,
+													AAIFrameVector< AAIFrameVector<AAIGroup*> >& availableAssaultGroupsOnContinent, AAIFrameVector< AAIFrameVector<AAIGroup*> >& availableAAGroupsOnContinent) const;
 
 	//! @brief Checks which combat unit groups are available for to attack a target (for each continent), 
 	//!        selects a possible target and launches attack if it seems reasonable (i.e. sufficient combat power available)
@@ -58,6 +60,9 @@ private:
 
 	//! The currently active attacks (nullptr if no active attack)
 	std::vector<AAIAttack*> m_activeAttacks;
+
+	//! Id of the attack to be checked by the next call of Update() (number of attacks if all have been checked)
+	int m_nextAttackIdToCheck;
 };
 
 #endif
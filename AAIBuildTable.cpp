@@ -15,6 +15,7 @@
 #include "AAIUnitTable.h"
 #include "AAIConfig.h"
 #include "AAIMap.h"
+#include "AAIFileWriter.h"
 
 #include "LegacyCpp/UnitDef.h"
 #include "LegacyCpp/MoveData.h"
@@ -22,6 +23,8 @@ using namespace springLegacyAI;
 
 AttackedByRatesPerGamePhaseAndMapType AAIBuildTable::s_attackedByRates;
 
+int AAIBuildTable::s_modLearnDataUsers = 0;
+
 AAIBuildTable::AAIBuildTable(AAI* ai)
 {
 	this->ai = ai;
@@ -31,6 +34,7 @@ AAIBuildTable::AAIBuildTable(AAI* ai)
 
 	// one more than needed because 0 is dummy object (so UnitDef->id can be used to adress that unit in the array)
 	units_dynamic.resize(numOfUnits+1);
+	m_constructorAvailabilityVersion = 0u;
 
 	for(int i = 0; i <= numOfUnits; ++i)
 	{
@@ -58,15 +62,35 @@ AAIBuildTable::AAIBuildTable(AAI* ai)
 
 	m_buildqueues.resize( ai->s_buildTree.GetNumberOfFactories() );
 
-	// If first instance of AAI: Try to load combat power&attacked by rates; if no stored data availble init with default values
-	// (combat power and attacked by rates are both static)
-	if(ai->GetAAIInstance() == 1)
+	// If first user of the mod learn data: Try to load combat power&attacked by rates; if no stored data availble init with default values
+	// (combat power and attacked by rates are both static and updated by all AAI instances until the last one saves them)
+	m_firstModLearnDataUser = (s_modLearnDataUsers == 0);
+
+	if(m_firstModLearnDataUser)
 	{
 		if(LoadModLearnData() == false)
 		{
 			ai->s_buildTree.InitCombatPowerOfUnits(ai->GetAICallback());
 			ai->LogConsole("New BuildTable has been created");
 		}
+
+		const std::string filename = cfg->GetFileName(ai->GetAICallback(), cfg->GetUniqueName(ai->GetAICallback(), true, true, false, false), AILOG_PATH, "_buildtree.txt", true);
+		ai->s_buildTree.PrintSummaryToFile(filename, ai->GetAICallback());
+	}
+
+	++s_modLearnDataUsers;
+
+	// set up candidate tables for selection of units
+	const int numberOfSides = ai->s_buildTree.GetNumberOfSides();
+	m_candidateTables.resize(numberOfSides * AAIUnitCategory::numberOfUnitCategories);
+
+	for(int side = 1; side <= numberOfSides; ++side)
+	{
+		for(int category = 0; category < AAIUnitCategory::numberOfUnitCategories; ++category)
+		{
+			const AAIUnitCategory unitCategory(static_cast<EUnitCategory>(category));
+			m_candidateTables[(side-1) * AAIUnitCategory::numberOfUnitCategories + category].Init(ai->s_buildTree, *this, unitCategory, side);
+		}
 	}
 }
 
@@ -90,6 +114,8 @@ void AAIBuildTable::ConstructorFinished(UnitDefId constructor)
 		++units_dynamic[unitDefId.id].constructorsAvailable;
 		--units_dynamic[unitDefId.id].constructorsRequested;
 	}
+
+	++m_constructorAvailabilityVersion;
 }
 
 void AAIBuildTable::ConstructorKilled(UnitDefId constructor)
@@ -98,6 +124,8 @@ void AAIBuildTable::ConstructorKilled(UnitDefId constructor)
 	{
 		--units_dynamic[unitDefId.id].constructorsAvailable;
 	}
+
+	++m_constructorAvailabilityVersion;
 }
 
 void AAIBuildTable::UnfinishedConstructorKilled(UnitDefId constructor)
@@ -117,6 +145,16 @@ bool AAIBuildTable::IsBuildingSelectable(UnitDefId building, bool water, bool mu
 	return constructablePassed && (landCheckPassed || seaCheckPassed );
 }
 
+const AAIUnitCandidateTable& AAIBuildTable::GetCandidateTable(const AAIUnitCategory& category, int side) const
+{
+	AAIUnitCandidateTable& candidateTable = m_candidateTables[(side-1) * AAIUnitCategory::numberOfUnitCategories + category.GetArrayIndex()];
+
+	candidateTable.UpdateCombatPower(ai->s_buildTree);
+	candidateTable.UpdateConstructable(*this, m_constructorAvailabilityVersion);
+
+	return candidateTable;
+}
+
 UnitDefId AAIBuildTable::SelectPowerPlant(int side, const PowerPlantSelectionCriteria& selectionCriteria, bool water)
 {
 	UnitDefId powerPlant = SelectPowerPlant(side, selectionCriteria, water, false);
@@ -132,6 +170,13 @@ UnitDefId AAIBuildTable::SelectPowerPlant(int side, const PowerPlantSelectionCri
 
 UnitDefId AAIBuildTable::SelectPowerPlant(int side, const PowerPlantSelectionCriteria& selectionCriteria, bool water, bool mustBeConstructable) const
 {
+	const AAIUnitCandidateTable& powerPlants = GetCandidateTable(EUnitCategory::POWER_PLANT, side);
+	const int        numberOfPowerPlants = powerPlants.GetNumberOfUnits();
+	const UnitDefId* powerPlantDefIds    = powerPlants.GetUnitDefIds();
+	const float*     generatedEnergies   = powerPlants.GetPrimaryAbilities();
+	const float*     costs               = powerPlants.GetTotalCosts();
+	const float*     buildtimes          = powerPlants.GetBuildtimes();
+
 	//-----------------------------------------------------------------------------------------------------------------
 	// determine the power plant whose generated energy exceeds the current total energy generation the least (-> to
 	// discard more advanced plants in the beginning)
@@ -141,47 +186,34 @@ UnitDefId AAIBuildTable::SelectPowerPlant(int side, const PowerPlantSelectionCri
 	const AAIUnitStatistics& unitStatistics = ai->s_buildTree.GetUnitStatistics(ai->GetSide());
 	float maxPower = unitStatistics.GetUnitPrimaryAbilityStatistics(EUnitCategory::POWER_PLANT).GetMaxValue();
 
-	for(auto powerPlant : ai->s_buildTree.GetUnitsInCategory(EUnitCategory::POWER_PLANT, side))
+	for(int i = 0; i < numberOfPowerPlants; ++i)
 	{
-		if( IsBuildingSelectable(powerPlant, water, false) )
-		{
-			const float generatedEnergy = ai->s_buildTree.GetPrimaryAbility(powerPlant);
-
-			if( (generatedEnergy > energyGenerationLimit) && (generatedEnergy < maxPower) )
-				maxPower = generatedEnergy;
-		}
+		if( powerPlants.IsBuildingSelectable(i, water, false) && (generatedEnergies[i] > energyGenerationLimit) && (generatedEnergies[i] < maxPower) )
+			maxPower = generatedEnergies[i];
 	}
 
 	//-----------------------------------------------------------------------------------------------------------------
-	// calculate statistics for remaining plants
+	// calculate statistics for remaining plants (energy capped at current energy production to avoid jumping to
+	// very advanced power plants to fast -> depends on current income and thus cannot be cached)
 	//-----------------------------------------------------------------------------------------------------------------
 
-	StatisticalData generatedEnergies;
-	StatisticalData buildtimes;
-	StatisticalData costs;
-	std::list<UnitDefId> powerPlants;
+	StatisticalData generatedEnergyStatistics;
+	StatisticalData buildtimeStatistics;
+	StatisticalData costStatistics;
 
-	for(auto powerPlant : ai->s_buildTree.GetUnitsInCategory(EUnitCategory::POWER_PLANT, side))
+	for(int i = 0; i < numberOfPowerPlants; ++i)
 	{
-		if( IsBuildingSelectable(powerPlant, water, false))
+		if( powerPlants.IsBuildingSelectable(i, water, false) && (generatedEnergies[i] < (maxPower+1.0f)) )
 		{
-			if(ai->s_buildTree.GetPrimaryAbility(powerPlant) < (maxPower+1.0f))
-			{
-				powerPlants.push_back(powerPlant);
-
-				// cap energy at current energy production (to avoid jumping to very advanced power plants to fast)
-				const float cappedEnergy = std::min(ai->s_buildTree.GetPrimaryAbility(powerPlant), energyGenerationLimit);
-
-				generatedEnergies.AddValue(cappedEnergy);
-				buildtimes.AddValue( ai->s_buildTree.GetBuildtime(powerPlant) );
-				costs.AddValue(      ai->s_buildTree.GetTotalCost(powerPlant) );
-			}
+			generatedEnergyStatistics.AddValue( std::min(generatedEnergies[i], energyGenerationLimit) );
+			buildtimeStatistics.AddValue(buildtimes[i]);
+			costStatistics.AddValue(costs[i]);
 		}
 	}
 
-	generatedEnergies.Finalize();
-	buildtimes.Finalize();
-	costs.Finalize();
+	generatedEnergyStatistics.Finalize();
+	buildtimeStatistics.Finalize();
+	costStatistics.Finalize();
 
 	//-----------------------------------------------------------------------------------------------------------------
 	// select power plant
@@ -190,20 +222,20 @@ UnitDefId AAIBuildTable::SelectPowerPlant(int side, const PowerPlantSelectionCri
 	UnitDefId selectedPowerPlant;
 	float     bestRating(0.0f);
 
-	for(auto powerPlant : powerPlants)
+	for(int i = 0; i < numberOfPowerPlants; ++i)
 	{
-		if(!mustBeConstructable || (units_dynamic[powerPlant.id].constructorsAvailable > 0) )
+		if( powerPlants.IsBuildingSelectable(i, water, mustBeConstructable) && (generatedEnergies[i] < (maxPower+1.0f)) )
 		{
-			const float cappedEnergy = std::min(ai->s_buildTree.GetPrimaryAbility(powerPlant), energyGenerationLimit);
+			const float cappedEnergy = std::min(generatedEnergies[i], energyGenerationLimit);
 
-			const float rating =  selectionCriteria.powerProduction * generatedEnergies.GetDeviationFromZero(cappedEnergy)
-								+ selectionCriteria.cost            * costs.GetDeviationFromMax(ai->s_buildTree.GetTotalCost(powerPlant))
-								+ selectionCriteria.buildtime       * buildtimes.GetDeviationFromMax(ai->s_buildTree.GetBuildtime(powerPlant));
+			const float rating =  selectionCriteria.powerProduction * generatedEnergyStatistics.GetDeviationFromZero(cappedEnergy)
+								+ selectionCriteria.cost            * costStatistics.GetDeviationFromMax(costs[i])
+								+ selectionCriteria.buildtime       * buildtimeStatistics.GetDeviationFromMax(buildtimes[i]);
 
 			if(rating > bestRating)
 			{
 				bestRating = rating;
-				selectedPowerPlant = powerPlant;
+				selectedPowerPlant = powerPlantDefIds[i];
 			}
 		}
 	}
@@ -226,29 +258,28 @@ UnitDefId AAIBuildTable::SelectExtractor(int side, const ExtractorSelectionCrite
 
 UnitDefId AAIBuildTable::SelectExtractor(int side, const ExtractorSelectionCriteria& selectionCriteria, bool water, bool mustBeConstructable) const
 {
+	const AAIUnitCandidateTable& extractors = GetCandidateTable(EUnitCategory::METAL_EXTRACTOR, side);
+	const UnitDefId* extractorDefIds       = extractors.GetUnitDefIds();
+	const float*     extractedMetalRatings = extractors.GetPrimaryAbilityRatings();
+	const float*     costRatings           = extractors.GetCostRatings();
+	const float*     armed                 = extractors.GetArmed();
+
 	UnitDefId selectedExtractorDefId;
 	float     bestRating(0.0f);
 
-	const AAIUnitStatistics& unitStatistics           = ai->s_buildTree.GetUnitStatistics(side);
-	const StatisticalData&   extractedMetalStatistics = unitStatistics.GetUnitPrimaryAbilityStatistics(EUnitCategory::METAL_EXTRACTOR);
-	const StatisticalData&   costStatistics           = unitStatistics.GetUnitCostStatistics(EUnitCategory::METAL_EXTRACTOR);
-
-	for(auto extractorDefId : ai->s_buildTree.GetUnitsInCategory(EUnitCategory::METAL_EXTRACTOR, side))
+	for(int i = 0; i < extractors.GetNumberOfUnits(); ++i)
 	{
 		// check if under water or ground || water = true and building under water
-		if( IsBuildingSelectable(extractorDefId, water, mustBeConstructable) )
+		if( extractors.IsBuildingSelectable(i, water, mustBeConstructable) )
 		{
-			const float metalExtraction = ai->s_buildTree.GetMaxRange(extractorDefId);
-			const float isArmed         = GetUnitDef(extractorDefId.id).weapons.empty() ? 0.0f : 1.0f;
-
-			const float myRating =   selectionCriteria.extractedMetal * extractedMetalStatistics.GetDeviationFromZero(metalExtraction)
-						           + selectionCriteria.cost           * costStatistics.GetDeviationFromMax(ai->s_buildTree.GetTotalCost(extractorDefId));
-								   + selectionCriteria.armed          * isArmed;
+			const float myRating =   selectionCriteria.extractedMetal * extractedMetalRatings[i]
+			                       + selectionCriteria.cost           * costRatings[i]
+			                       + selectionCriteria.armed          * armed[i];
 
 			if(myRating > bestRating)
 			{
 				bestRating             = myRating;
-				selectedExtractorDefId = extractorDefId;
+				selectedExtractorDefId = extractorDefIds[i];
 			}
 		}
 	}
@@ -273,29 +304,29 @@ UnitDefId AAIBuildTable::SelectStorage(int side, const StorageSelectionCriteria&
 
 UnitDefId AAIBuildTable::SelectStorage(int side, const StorageSelectionCriteria& selectionCriteria, bool water, bool mustBeConstructable) const
 {
-	const AAIUnitStatistics& unitStatistics  = ai->s_buildTree.GetUnitStatistics(side);
-	const StatisticalData&   costs           = unitStatistics.GetUnitCostStatistics(EUnitCategory::STORAGE);
-	const StatisticalData&   buildtimes      = unitStatistics.GetUnitBuildtimeStatistics(EUnitCategory::STORAGE);
-	const StatisticalData&   metalStored     = unitStatistics.GetUnitPrimaryAbilityStatistics(EUnitCategory::STORAGE);
-	const StatisticalData&   energyStored    = unitStatistics.GetUnitSecondaryAbilityStatistics(EUnitCategory::STORAGE);
+	const AAIUnitCandidateTable& storages = GetCandidateTable(EUnitCategory::STORAGE, side);
+	const UnitDefId* storageDefIds      = storages.GetUnitDefIds();
+	const float*     costRatings        = storages.GetCostRatings();
+	const float*     buildtimeRatings   = storages.GetBuildtimeRatings();
+	const float*     storedMetalRatings = storages.GetPrimaryAbilityRatings();
+	const float*     storedEnergyRatings = storages.GetSecondaryAbilityRatings();
 
 	UnitDefId selectedStorage;
 	float highestRating(0.0f);
 
-	for(auto storage : ai->s_buildTree.GetUnitsInCategory(EUnitCategory::STORAGE, side))
+	for(int i = 0; i < storages.GetNumberOfUnits(); ++i)
 	{
-		
-		if( IsBuildingSelectable(storage.id, water, mustBeConstructable) )
+		if( storages.IsBuildingSelectable(i, water, mustBeConstructable) )
 		{
-			const float rating =      selectionCriteria.cost         * costs.GetDeviationFromMax( ai->s_buildTree.GetTotalCost(storage) )
-									+ selectionCriteria.buildtime    * buildtimes.GetDeviationFromMax( ai->s_buildTree.GetBuildtime(storage) )
-									+ selectionCriteria.storedMetal  * metalStored.GetDeviationFromZero( ai->s_buildTree.GetMaxRange(storage) )
-									+ selectionCriteria.storedEnergy * energyStored.GetDeviationFromZero( ai->s_buildTree.GetMaxSpeed(storage) );
+			const float rating =      selectionCriteria.cost         * costRatings[i]
+									+ selectionCriteria.buildtime    * buildtimeRatings[i]
+									+ selectionCriteria.storedMetal  * storedMetalRatings[i]
+									+ selectionCriteria.storedEnergy * storedEnergyRatings[i];
 
 			if(rating > highestRating)
 			{
 				highestRating   = rating;
-				selectedStorage = storage;
+				selectedStorage = storageDefIds[i];
 			}
 		}
 	}
@@ -578,46 +609,31 @@ UnitDefId AAIBuildTable::SelectStaticDefence(int side, const StaticDefenceSelect
 UnitDefId AAIBuildTable::SelectStaticDefence(int side, const StaticDefenceSelectionCriteria& selectionCriteria, bool water, bool mustBeConstructable) const
 {
 	// get data needed for selection
-	AAIUnitCategory category(EUnitCategory::STATIC_DEFENCE);
-	const std::list<UnitDefId> unitList = ai->s_buildTree.GetUnitsInCategory(category, side);
-
-	const StatisticalData& costs      = ai->s_buildTree.GetUnitStatistics(side).GetUnitCostStatistics(category);
-	const StatisticalData& ranges     = ai->s_buildTree.GetUnitStatistics(side).GetUnitPrimaryAbilityStatistics(category);
-	const StatisticalData& buildtimes = ai->s_buildTree.GetUnitStatistics(side).GetUnitBuildtimeStatistics(category);
-
-	// calculate combat power
-	StatisticalData combatPowerStat;		
-
-	for(auto defence : unitList)
-	{
-		const float defenceCombatPower = ai->s_buildTree.GetCombatPower(defence).GetValue(selectionCriteria.targetType);
-		combatPowerStat.AddValue(defenceCombatPower);
-	}
-
-	combatPowerStat.Finalize();
+	const AAIUnitCandidateTable& defences = GetCandidateTable(EUnitCategory::STATIC_DEFENCE, side);
+	const UnitDefId* defenceDefIds      = defences.GetUnitDefIds();
+	const float*     costRatings        = defences.GetCostRatings();
+	const float*     buildtimeRatings   = defences.GetBuildtimeRatings();
+	const float*     rangeRatings       = defences.GetPrimaryAbilityRatings();
+	const float*     combatPowerRatings = defences.GetCombatPowerRatings(selectionCriteria.targetType);
 
 	// start with selection
 	UnitDefId selectedDefence;
 	float bestRating(0.0f);
 
-	for(auto defence : unitList)
+	for(int i = 0; i < defences.GetNumberOfUnits(); ++i)
 	{
-		if( IsBuildingSelectable(defence, water, mustBeConstructable) )
+		if( defences.IsBuildingSelectable(i, water, mustBeConstructable) )
 		{
-			const UnitTypeProperties& unitData = ai->s_buildTree.GetUnitTypeProperties(defence);
-
-			const float myCombatPower = ai->s_buildTree.GetCombatPower(defence).GetValue(selectionCriteria.targetType);
-
-			float myRating =  selectionCriteria.cost        * costs.GetDeviationFromMax( unitData.m_totalCost )
-							+ selectionCriteria.buildtime   * buildtimes.GetDeviationFromMax( unitData.m_buildtime )
-							+ selectionCriteria.range       * ranges.GetDeviationFromZero( unitData.m_primaryAbility )
-							+ selectionCriteria.combatPower * combatPowerStat.GetDeviationFromZero( myCombatPower )
+			float myRating =  selectionCriteria.cost        * costRatings[i]
+							+ selectionCriteria.buildtime   * buildtimeRatings[i]
+							+ selectionCriteria.range       * rangeRatings[i]
+							+ selectionCriteria.combatPower * combatPowerRatings[i]
 							+ 0.05f * ((float)(rand()%(selectionCriteria.randomness+1)));
 
 			if(myRating > bestRating)
 			{
 				bestRating = myRating;
-				selectedDefence = defence;
+				selectedDefence = defenceDefIds[i];
 			}
 		}
 	}
@@ -722,21 +738,23 @@ UnitDefId AAIBuildTable::SelectRadar(int side, float cost, float range, bool wat
 	const StatisticalData& costs  = ai->s_buildTree.GetUnitStatistics(side).GetSensorStatistics().m_radarCosts;
 	const StatisticalData& ranges = ai->s_buildTree.GetUnitStatistics(side).GetSensorStatistics().m_radarRanges;
 
-	for(auto sensor = ai->s_buildTree.GetUnitsInCategory(EUnitCategory::STATIC_SENSOR, side).begin(); sensor != ai->s_buildTree.GetUnitsInCategory(EUnitCategory::STATIC_SENSOR, side).end(); ++sensor)
+	const AAIUnitCandidateTable& sensors = GetCandidateTable(EUnitCategory::STATIC_SENSOR, side);
+	const UnitDefId* sensorDefIds = sensors.GetUnitDefIds();
+	const float*     sensorCosts  = sensors.GetTotalCosts();
+	const float*     sensorRanges = sensors.GetPrimaryAbilities();
+
+	for(int i = 0; i < sensors.GetNumberOfUnits(); ++i)
 	{
 		//! @todo replace by checking unit type for radar when implemented.
-		if( ai->s_buildTree.GetUnitType(sensor->id).IsRadar() )
+		if( ai->s_buildTree.GetUnitType(sensorDefIds[i]).IsRadar() && sensors.IsBuildingSelectable(i, water, mustBeConstructable) )
 		{
-			if(IsBuildingSelectable(*sensor, water, mustBeConstructable))
-			{
-				const float myRating =   cost * costs.GetNormalizedDeviationFromMax(ai->s_buildTree.GetTotalCost(sensor->id))
-				                       + range * ranges.GetNormalizedDeviationFromMin(ai->s_buildTree.GetMaxRange(sensor->id));
+			const float myRating =   cost  * costs.GetNormalizedDeviationFromMax(sensorCosts[i])
+			                       + range * ranges.GetNormalizedDeviationFromMin(sensorRanges[i]);
 
-				if(myRating > bestRating)
-				{
-					selectedRadar = *sensor;
-					bestRating    = myRating;
-				}
+			if(myRating > bestRating)
+			{
+				selectedRadar = sensorDefIds[i];
+				bestRating    = myRating;
 			}
 		}
 	}
@@ -771,23 +789,26 @@ UnitDefId AAIBuildTable::SelectScout(int side, const ScoutSelectionCriteria& sco
 	float highestRating(0.0f);
 	UnitDefId selectedScout;
 
-	const StatisticalData& costs       = ai->s_buildTree.GetUnitStatistics(side).GetUnitCostStatistics(EUnitCategory::SCOUT);
-	const StatisticalData& sightRanges = ai->s_buildTree.GetUnitStatistics(side).GetUnitPrimaryAbilityStatistics(EUnitCategory::SCOUT);
-	const StatisticalData& speeds      = ai->s_buildTree.GetUnitStatistics(side).GetUnitSecondaryAbilityStatistics(EUnitCategory::SCOUT);
+	const AAIUnitCandidateTable& scouts = GetCandidateTable(EUnitCategory::SCOUT, side);
+	const UnitDefId*       scoutDefIds       = scouts.GetUnitDefIds();
+	const AAIMovementType* movementTypes     = scouts.GetMovementTypes();
+	const uint8_t*         constructable     = scouts.GetConstructable();
+	const float*           sightRangeRatings = scouts.GetPrimaryAbilityRatings();
+	const float*           costRatings       = scouts.GetCostRatings();
+	const float*           speedRatings      = scouts.GetSecondaryAbilityRatings();
+	const float*           cloakable         = scouts.GetCloakable();
 
-	for(auto scoutUnitDefId : ai->s_buildTree.GetUnitsInCategory(EUnitCategory::SCOUT, side))
+	for(int i = 0; i < scouts.GetNumberOfUnits(); ++i)
 	{
-		const AAIMovementType& moveType    = ai->s_buildTree.GetMovementType(scoutUnitDefId);
-		const bool factoryPrerequisitesMet = !factoryAvailable || (units_dynamic[scoutUnitDefId.id].constructorsAvailable > 0);
+		const AAIMovementType& moveType    = movementTypes[i];
+		const bool factoryPrerequisitesMet = !factoryAvailable || (constructable[i] != 0);
 
 		if( moveType.IsIncludedIn(movementType) && factoryPrerequisitesMet )
 		{
-			const float cloakable = GetUnitDef(scoutUnitDefId.id).canCloak ? 1.0f : 0.0f;
-
-			float rating =    scoutSelectionCriteria.sightRange * sightRanges.GetDeviationFromZero(ai->s_buildTree.GetMaxRange(scoutUnitDefId))
-							+ scoutSelectionCriteria.cost       * costs.GetDeviationFromMax(ai->s_buildTree.GetTotalCost(scoutUnitDefId))
-							+ scoutSelectionCriteria.speed      * speeds.GetDeviationFromZero(ai->s_buildTree.GetMaxSpeed(scoutUnitDefId))
-							+ scoutSelectionCriteria.cloakable  * cloakable
+			float rating =    scoutSelectionCriteria.sightRange * sightRangeRatings[i]
+							+ scoutSelectionCriteria.cost       * costRatings[i]
+							+ scoutSelectionCriteria.speed      * speedRatings[i]
+							+ scoutSelectionCriteria.cloakable  * cloakable[i]
 							+ (0.03f * ((float)(rand()%randomness)));
 			
 			if(moveType.IsMobileSea())
@@ -798,7 +819,7 @@ UnitDefId AAIBuildTable::SelectScout(int side, const ScoutSelectionCriteria& sco
 			if(rating > highestRating)
 			{
 				highestRating = rating;
-				selectedScout = scoutUnitDefId;
+				selectedScout = scoutDefIds[i];
 			}
 		}
 	}
@@ -806,11 +827,10 @@ UnitDefId AAIBuildTable::SelectScout(int side, const ScoutSelectionCriteria& sco
 	return selectedScout;
 }
 
-void AAIBuildTable::SelectCombatUnits(std::list<UnitDefId>& unitList, int side, const AAIMovementType& allowedMoveTypes, bool constructorAvailable) const
+std::array<bool, 5> AAIBuildTable::DetermineCombatUnitCategoriesToCheck(const AAIMovementType& allowedMoveTypes) const
 {
-	const auto& combatUnitCategories = ai->s_buildTree.GetCombatUnitCatgegories();
-
-	std::vector<bool> checkCategory(combatUnitCategories.size(), false);
+	std::array<bool, 5> checkCategory;
+	checkCategory.fill(false);
 
 	if(allowedMoveTypes.IsAir())
 		checkCategory[1] = true;
@@ -833,56 +853,66 @@ void AAIBuildTable::SelectCombatUnits(std::list<UnitDefId>& unitList, int side,
 	if(allowedMoveTypes.Includes(EMovementType::MOVEMENT_TYPE_SEA_SUBMERGED))
 		checkCategory[4] = true;
 
-	int i(0);
-	for(auto unitCategory : combatUnitCategories)
-	{
-		if(checkCategory[i])
-		{
-			for(auto unitDefId : ai->s_buildTree.GetUnitsInCategory(unitCategory, side) )
-			{
-				const bool constructorAvailabilityCheckPassed = (constructorAvailable == false) || (units_dynamic[unitDefId.id].constructorsAvailable > 0);
-				
-				if(constructorAvailabilityCheckPassed && ai->s_buildTree.GetMovementType(unitDefId).IsIncludedIn(allowedMoveTypes))
-					unitList.push_back(unitDefId);
-			}
-		}
-
-		++i;
-	}
+	return checkCategory;
 }
 
 UnitDefId AAIBuildTable::SelectCombatUnit(int side, const AAIMovementType& allowedMoveTypes, const TargetTypeValues& combatPowerCriteria, const UnitSelectionCriteria& unitCriteria, const std::vector<float>& factoryUtilization, int randomness, bool constructorAvailable) const
 {
 	//-----------------------------------------------------------------------------------------------------------------
-	// get data needed for selection
+	// gather candidates from the tables of the relevant combat unit categories (statistics depend on the given criteria
+	// and the selected subset of units and thus have to be determined for every call)
 	//-----------------------------------------------------------------------------------------------------------------
 
-	std::list<UnitDefId> unitList;
-	SelectCombatUnits(unitList, side, allowedMoveTypes, constructorAvailable);
+	const auto& combatUnitCategories = ai->s_buildTree.GetCombatUnitCatgegories();
+	const std::array<bool, 5> checkCategory = DetermineCombatUnitCategoriesToCheck(allowedMoveTypes);
+
+	AAIFrameVector<UnitDefId> unitList( AAIFrameAllocator<UnitDefId>(ai->FrameArena()) );
+	AAIFrameVector<float> costs( AAIFrameAllocator<float>(ai->FrameArena()) );
+	AAIFrameVector<float> ranges( AAIFrameAllocator<float>(ai->FrameArena()) );
+	AAIFrameVector<float> speeds( AAIFrameAllocator<float>(ai->FrameArena()) );
+	AAIFrameVector<float> combatPowerValues( AAIFrameAllocator<float>(ai->FrameArena()) );
+
+	for(int category = 0; category < static_cast<int>(combatUnitCategories.size()); ++category)
+	{
+		if(checkCategory[category])
+		{
+			const AAIUnitCandidateTable& combatUnits = GetCandidateTable(combatUnitCategories[category], side);
+			const UnitDefId*        unitDefIds         = combatUnits.GetUnitDefIds();
+			const AAIMovementType*  movementTypes      = combatUnits.GetMovementTypes();
+			const uint8_t*          constructable      = combatUnits.GetConstructable();
+			const TargetTypeValues* combatPower        = combatUnits.GetCombatPower();
+
+			for(int i = 0; i < combatUnits.GetNumberOfUnits(); ++i)
+			{
+				const bool constructorAvailabilityCheckPassed = (constructorAvailable == false) || (constructable[i] != 0);
+
+				if(constructorAvailabilityCheckPassed && movementTypes[i].IsIncludedIn(allowedMoveTypes))
+				{
+					unitList.push_back(unitDefIds[i]);
+					costs.push_back(combatUnits.GetTotalCosts()[i]);
+					ranges.push_back(combatUnits.GetPrimaryAbilities()[i]);
+					speeds.push_back(combatUnits.GetSecondaryAbilities()[i]);
+					combatPowerValues.push_back(combatPowerCriteria.CalculateWeightedSum(combatPower[i]));
+				}
+			}
+		}
+	}
+
+	const int numberOfUnits = static_cast<int>(unitList.size());
 
 	StatisticalData costStatistics;
 	StatisticalData rangeStatistics;
 	StatisticalData speedStatistics;
 	StatisticalData combatPowerStat;
 	StatisticalData combatEfficiencyStat;
-	std::vector<float> combatPowerValues(unitList.size()); // values for individual units (in order of appearance in unitList)
 
-	int i = 0;
-	for(auto unitDefId : unitList)
+	for(int i = 0; i < numberOfUnits; ++i)
 	{
-		const UnitTypeProperties& unitData = ai->s_buildTree.GetUnitTypeProperties(unitDefId);
-
-		const float combatPower = combatPowerCriteria.CalculateWeightedSum(ai->s_buildTree.GetCombatPower(unitDefId)); 
-		const float combatEff   = combatPower / unitData.m_totalCost;
-
-		costStatistics.AddValue(unitData.m_totalCost);
-		rangeStatistics.AddValue(unitData.m_primaryAbility);
-		speedStatistics.AddValue(unitData.m_secondaryAbility);
-		combatPowerStat.AddValue(combatPower);
-		combatEfficiencyStat.AddValue(combatEff);
-		combatPowerValues[i] = combatPower;
-
-		++i;
+		costStatistics.AddValue(costs[i]);
+		rangeStatistics.AddValue(ranges[i]);
+		speedStatistics.AddValue(speeds[i]);
+		combatPowerStat.AddValue(combatPowerValues[i]);
+		combatEfficiencyStat.AddValue(combatPowerValues[i] / costs[i]);
 	}
 
 	costStatistics.Finalize();
@@ -901,13 +931,11 @@ UnitDefId AAIBuildTable::SelectCombatUnit(int side, const AAIMovementType& allow
 
 	UnitDefId selectedUnitType;
 	float highestRating(0.0f);
-	i = 0;
-	for(const auto& unitDefId : unitList)
-	{
-		const UnitTypeProperties& unitData = ai->s_buildTree.GetUnitTypeProperties(unitDefId);
 
+	for(int i = 0; i < numberOfUnits; ++i)
+	{
 		float minFactoryUtilization(0.0f);
-		for(const auto& factory : ai->s_buildTree.GetConstructedByList(unitDefId))
+		for(const auto& factory : ai->s_buildTree.GetConstructedByList(unitList[i]))
 		{
 			const float utilization = factoryUtilization[ai->s_buildTree.GetUnitTypeProperties(factory).m_factoryId.id];
 
@@ -915,31 +943,21 @@ UnitDefId AAIBuildTable::SelectCombatUnit(int side, const AAIMovementType& allow
 				minFactoryUtilization = utilization;
 		}
 			
-		const float combatEff = combatPowerValues[i] / unitData.m_totalCost;
+		const float combatEff = combatPowerValues[i] / costs[i];
 
-		const float rating =  unitCriteria.cost  * costStatistics.GetDeviationFromMax( unitData.m_totalCost )
-							+ unitCriteria.range * rangeStatistics.GetDeviationFromZero( unitData.m_primaryAbility )
-							+ unitCriteria.speed * speedStatistics.GetDeviationFromZero( unitData.m_secondaryAbility )
+		const float rating =  unitCriteria.cost  * costStatistics.GetDeviationFromMax( costs[i] )
+							+ unitCriteria.range * rangeStatistics.GetDeviationFromZero( ranges[i] )
+							+ unitCriteria.speed * speedStatistics.GetDeviationFromZero( speeds[i] )
 							+ unitCriteria.power * combatPowerStat.GetDeviationFromZero( combatPowerValues[i] )
 							+ unitCriteria.efficiency * combatEfficiencyStat.GetDeviationFromZero( combatEff )
 							+ unitCriteria.factoryUtilization * minFactoryUtilization
 							+ 0.1f * ((float)(rand()%randomness));
 
-		/*ai->Log("%s: %f  -  %f %f %f %f %f %f\n", unitData.m_name.c_str(), rating, 
-												unitCriteria.cost * costStatistics.GetDeviationFromMax(unitData.m_totalCost), 
-												unitCriteria.range * rangeStatistics.GetDeviationFromZero(unitData.m_primaryAbility),
-												unitCriteria.speed * speedStatistics.GetDeviationFromZero(unitData.m_secondaryAbility),
-												unitCriteria.power * combatPowerStat.GetDeviationFromZero(combatPowerValues[i]),
-												unitCriteria.efficiency * combatEfficiencyStat.GetDeviationFromZero(combatEff),
-												minFactoryUtilization);*/
-
 		if(rating > highestRating)
 		{
 			highestRating       = rating;
-			selectedUnitType.id = unitDefId.id;
+			selectedUnitType.id = unitList[i].id;
 		}
-		
-		++i;
 	}
 
 	//ai->Log("Selected: %s\n", ai->s_buildTree.GetUnitTypeProperties(selectedUnitType).m_name.c_str() );
@@ -993,13 +1011,21 @@ bool AAIBuildTable::LoadModLearnData()
 	return false;
 }
 
+void AAIBuildTable::ReleaseModLearnData(const GamePhase& gamePhase, const AttackedByRatesPerGamePhase& attackedByRates, const AAIMapType& mapType)
+{
+	--s_modLearnDataUsers;
+
+	// learn data contains the attacks/combat results of all AAI instances -> save when last user is deleted
+	if(s_modLearnDataUsers == 0)
+		SaveModLearnData(gamePhase, attackedByRates, mapType);
+}
+
 void AAIBuildTable::SaveModLearnData(const GamePhase& gamePhase, const AttackedByRatesPerGamePhase& attackedByRates, const AAIMapType& mapType) const
 {
-	const std::string filename = GetBuildCacheFileName();
-	FILE *saveFile = fopen(filename.c_str(), "w+");
+	AAITextBuffer buffer;
 
 	// file version
-	fprintf(saveFile, "%s \n", MOD_LEARN_VERSION);
+	buffer.Printf("%s \n", MOD_LEARN_VERSION);
 
 	// update attacked_by values
 	AttackedByRatesPerGamePhase& updateRates = s_attackedByRates.GetAttackedByRates(mapType);
@@ -1013,15 +1039,18 @@ void AAIBuildTable::SaveModLearnData(const GamePhase& gamePhase, const AttackedB
 		{
 			for(const auto& targetType : AAITargetType::m_mobileTargetTypes)
 			{
-				fprintf(saveFile, "%f ", s_attackedByRates.GetAttackedByRate(mapTypeIterator, gamePhaseIterator, targetType));
+				buffer.Printf("%f ", s_attackedByRates.GetAttackedByRate(mapTypeIterator, gamePhaseIterator, targetType));
 			}
-			fprintf(saveFile, "\n");
+			buffer.Printf("\n");
 		}
 	}
 
-	ai->s_buildTree.SaveCombatPowerOfUnits(saveFile);
+	ai->s_buildTree.SaveCombatPowerOfUnits(buffer);
+
+	const std::string filename = GetBuildCacheFileName();
 
-	fclose(saveFile);
+	if(AAIFileWriter::WriteFileAtomically(filename, buffer.GetText()) == false)
+		ai->Log("Error: Writing file %s failed\n", filename.c_str());
 }
 
 UnitDefId AAIBuildTable::SelectConstructorFor(UnitDefId unitDefId) const
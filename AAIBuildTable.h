@@ -15,7 +15,10 @@ class AAI;
 #include "aidef.h"
 #include "AAIBuildTree.h"
 #include "AAIUnitTypes.h"
+#include "AAIFrameArena.h"
+#include "AAIUnitCandidateTable.h"
 #include <assert.h>
+#include <array>
 #include <list>
 #include <vector>
 #include <string>
@@ -120,8 +123,11 @@ public:
 	AAIBuildTable(AAI* ai);
 	~AAIBuildTable(void);
 
-	//! @brief Updates the stored combat efficiencies and attack frequencies by enemy target types for the given map type
-	void SaveModLearnData(const GamePhase& gamePhase, const AttackedByRatesPerGamePhase& atackedByRates, const AAIMapType& mapType) const;
+	//! @brief Shall be called when the AAI instance is deleted; last user of the mod learn data saves it (see SaveModLearnData())
+	void ReleaseModLearnData(const GamePhase& gamePhase, const AttackedByRatesPerGamePhase& atackedByRates, const AAIMapType& mapType);
+
+	//! @brief Returns true if this instance has loaded/initialized the mod learn data shared by all AAI instances
+	bool IsFirstModLearnDataUser() const { return m_firstModLearnDataUser; }
 
 	//! @brief Updates counters for requested constructors for units that can be built by given construction unit
 	void ConstructorRequested(UnitDefId constructor);
@@ -193,6 +199,9 @@ public:
 	//! @brief Returns the number of available constructors for the given unit type
 	int GetNumberOfAvailableConstructorsForUnit(UnitDefId unitDefId) const { return units_dynamic[unitDefId.id].constructorsAvailable; }
 
+	//! @brief Returns a counter that is increased whenever the number of available constructors of any unit type changes
+	uint32_t GetConstructorAvailabilityVersion() const { return m_constructorAvailabilityVersion; }
+
 	// ******************************************************************************************************
 	// the following functions are used to determine units that suit a certain purpose
 	// if water == true, only water based units/buildings will be returned
@@ -253,14 +262,20 @@ public:
 private:
 	std::string GetBuildCacheFileName() const;
 
+	//! @brief Updates the stored combat efficiencies and attack frequencies by enemy target types for the given map type
+	void SaveModLearnData(const GamePhase& gamePhase, const AttackedByRatesPerGamePhase& atackedByRates, const AAIMapType& mapType) const;
+
 	//! @brief Loads mod learn data from file
 	bool LoadModLearnData();
 
 	//! @brief Helper function used for building selection
 	bool IsBuildingSelectable(UnitDefId building, bool water, bool mustBeConstructable) const;
 
-	//! @brief Adds combat units matching the given criteria to the list
-	void SelectCombatUnits(std::list<UnitDefId>& unitList, int side, const AAIMovementType& allowedMoveTypes, bool constructorAvailable) const;
+	//! @brief Returns the candidate table for the given category and side (updated if combat power or availability of constructors has changed)
+	const AAIUnitCandidateTable& GetCandidateTable(const AAIUnitCategory& category, int side) const;
+
+	//! @brief Returns which combat unit categories may contain units of the given movement types
+	std::array<bool, 5> DetermineCombatUnitCategoriesToCheck(const AAIMovementType& allowedMoveTypes) const;
 
 	//! @brief Returns a power plant based on the given criteria
 	UnitDefId SelectPowerPlant(int side, const PowerPlantSelectionCriteria& selectionCriteria, bool water, bool mustBeConstructable) const;
@@ -295,6 +310,18 @@ private:
 	//! Rates of attacks by different combat categories per map and game phase
 	static AttackedByRatesPerGamePhaseAndMapType s_attackedByRates;
 
+	//! Number of AAIBuildTable instances using the mod learn data (loaded by first user and saved by last one)
+	static int s_modLearnDataUsers;
+
+	//! True if this instance loaded the mod learn data (i.e. shall initialize data derived from it)
+	bool m_firstModLearnDataUser;
+
+	//! Candidate tables used for unit selection (one per side and unit category, order: m_candidateTables[(side-1) * numberOfUnitCategories + category])
+	mutable std::vector<AAIUnitCandidateTable> m_candidateTables;
+
+	//! Increased whenever the number of available constructors changes (i.e. constructable flags of candidate tables need to be updated)
+	uint32_t m_constructorAvailabilityVersion;
+
 	AAI *ai;
 
 	// all the unit defs, FIXME: this can't be made static as spring seems to free the memory returned by GetUnitDefList()
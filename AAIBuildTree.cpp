@@ -10,6 +10,8 @@
 #include "System/SafeUtil.h"
 #include "aidef.h"
 #include "AAIBuildTree.h"
+#include "AAICacheFile.h"
+#include "AAIFileWriter.h"
 #include "AAIConfig.h"
 #include "AAIUnitTypes.h"
 
@@ -27,7 +29,9 @@ using namespace springLegacyAI;
 
 AAIBuildTree::AAIBuildTree() :
 	m_initialized(false),
-	m_numberOfSides(0)
+	m_wordsPerBuilderRow(0),
+	m_numberOfSides(0),
+	m_combatPowerVersion(0)
 {
 	m_unitCategoryNames.resize(AAIUnitCategory::numberOfUnitCategories);
 	m_unitCategoryNames[AAIUnitCategory(EUnitCategory::UNKNOWN).GetArrayIndex()].append("Unknown");
@@ -63,25 +67,30 @@ AAIBuildTree::AAIBuildTree() :
 AAIBuildTree::~AAIBuildTree(void)
 {
 	m_initialized = false;
-	m_unitTypeCanBeConstructedtByLists.clear();
-	m_unitTypeCanConstructLists.clear();
+	m_constructedByUnitTypes.clear();
+	m_constructedByOffsets.clear();
+	m_canConstructUnitTypes.clear();
+	m_canConstructOffsets.clear();
+	m_builderRowOfUnitType.clear();
+	m_canConstructBitmatrix.clear();
+	m_canEventuallyConstructBitmatrix.clear();
 	m_unitTypeProperties.clear();
 	m_sideOfUnitType.clear();
 	m_startUnitsOfSide.clear();
 	m_unitCategoryNames.clear();
 }
 
-void AAIBuildTree::SaveCombatPowerOfUnits(FILE* saveFile) const
+void AAIBuildTree::SaveCombatPowerOfUnits(AAITextBuffer& buffer) const
 {
-	fprintf(saveFile, "%i\n", static_cast<int>(m_combatPowerOfUnits.size()));
+	buffer.Printf("%i\n", static_cast<int>(m_combatPowerOfUnits.size()));
 
 	for(int id = 1; id < m_combatPowerOfUnits.size(); ++id)
 	{
-		fprintf(saveFile, "%f %f %f %f %f\n", m_combatPowerOfUnits[id].GetValue(ETargetType::SURFACE),
-											  m_combatPowerOfUnits[id].GetValue(ETargetType::AIR),
-											  m_combatPowerOfUnits[id].GetValue(ETargetType::FLOATER),
-											  m_combatPowerOfUnits[id].GetValue(ETargetType::SUBMERGED),
-											  m_combatPowerOfUnits[id].GetValue(ETargetType::STATIC));
+		buffer.Printf("%f %f %f %f %f\n", m_combatPowerOfUnits[id].GetValue(ETargetType::SURFACE),
+										  m_combatPowerOfUnits[id].GetValue(ETargetType::AIR),
+										  m_combatPowerOfUnits[id].GetValue(ETargetType::FLOATER),
+										  m_combatPowerOfUnits[id].GetValue(ETargetType::SUBMERGED),
+										  m_combatPowerOfUnits[id].GetValue(ETargetType::STATIC));
 	}
 }
 
@@ -109,6 +118,8 @@ bool AAIBuildTree::LoadCombatPowerOfUnits(FILE* inputFile)
 
 	UpdateUnitTypesOfCombatUnits();
 
+	++m_combatPowerVersion;
+
 	return true;
 }
 
@@ -225,6 +236,8 @@ void AAIBuildTree::InitCombatPowerOfUnits(springLegacyAI::IAICallback* cb)
 	}
 
 	UpdateUnitTypesOfCombatUnits();
+
+	++m_combatPowerVersion;
 }
 
 void AAIBuildTree::UpdateUnitTypesOfCombatUnits()
@@ -304,12 +317,17 @@ void AAIBuildTree::UpdateCombatPowerStatistics(UnitDefId attackerUnitDefId, Unit
 			m_combatPowerOfUnits[attackerUnitDefId.id].IncreaseCombatPower(GetTargetType(killedUnitDefId), combatPowerChange);
 			m_combatPowerOfUnits[killedUnitDefId.id].DecreaseCombatPower(GetTargetType(attackerUnitDefId), combatPowerChange);
 		}
+
+		++m_combatPowerVersion;
 	}
 	else if(attackerCategory.IsAirCombat() &&  killedCategory.IsBuilding())
 	{
 		// special bonus for aircraft when killing buildings
 		if(m_combatPowerOfUnits[attackerUnitDefId.id].GetValue(ETargetType::STATIC) < 0.75f * AAIConstants::maxCombatPower)
+		{
 			m_combatPowerOfUnits[attackerUnitDefId.id].IncreaseCombatPower(ETargetType::STATIC, AAIConstants::aircraftVsBuildingCombatPowerBonus);
+			++m_combatPowerVersion;
+		}
 	}
 }
 
@@ -322,40 +340,64 @@ bool AAIBuildTree::Generate(springLegacyAI::IAICallback* cb)
 	m_initialized = true;
 
 	//-----------------------------------------------------------------------------------------------------------------
-	// get number of unit types and set up arrays
+	// get list all of unit definitions
 	//-----------------------------------------------------------------------------------------------------------------
 	const int numberOfUnitTypes = cb->GetNumUnitDefs();
 
-	// unit ids start with 1 -> add one additional element to arrays to be able to directly access unit def with corresponding id
-	m_unitTypeCanBeConstructedtByLists.resize(numberOfUnitTypes+1);
-	m_unitTypeCanConstructLists.resize(numberOfUnitTypes+1);
-	m_unitTypeProperties.resize(numberOfUnitTypes+1);
-	m_sideOfUnitType.resize(numberOfUnitTypes+1, 0);
-	m_combatPowerOfUnits.resize(numberOfUnitTypes+1);
-
-	//-----------------------------------------------------------------------------------------------------------------
-	// get list all of unit definitions for further analysis
-	//-----------------------------------------------------------------------------------------------------------------
-
 	//spring first unitdef id is 1, we remap it so id = is position in array
 	std::vector<const springLegacyAI::UnitDef*> unitDefs(numberOfUnitTypes+1);
 
 	cb->GetUnitDefList(&unitDefs[1]);
 
 	//-----------------------------------------------------------------------------------------------------------------
-	// determine build tree
+	// load build tree from cache file - analyse unit definitions only if no valid cache file for current mod/config available
 	//-----------------------------------------------------------------------------------------------------------------
-	for(int id = 1; id <= numberOfUnitTypes; ++id)
+	const std::string cacheFilename = cfg->GetFileName(cb, cfg->GetUniqueName(cb, true, true, false, false), MOD_LEARN_PATH, "_buildtree.bin", true);
+	const uint64_t    cacheKey      = CalculateCacheKey(cb);
+
+	if(ReadCacheFile(cacheFilename, cacheKey, numberOfUnitTypes))
 	{
-		// determine which unit types can be constructed by the current unit type
-		for(const auto& constructableUnit : unitDefs[id]->buildOptions)
+		// generated power of tidal/wind generators depends on the map
+		for(int id = 1; id <= numberOfUnitTypes; ++id)
 		{
-			const int canConstructId = cb->GetUnitDef(constructableUnit.second.c_str())->id;
-
-			m_unitTypeCanConstructLists[id].push_back( UnitDefId(canConstructId) );
-			m_unitTypeCanBeConstructedtByLists[canConstructId].push_back( UnitDefId(id) );
+			if(m_unitTypeProperties[id].m_unitCategory.IsPowerPlant())
+				m_unitTypeProperties[id].m_primaryAbility = DeterminePrimaryAbility(unitDefs[id], m_unitTypeProperties[id].m_unitCategory, cb);
 		}
 	}
+	else
+	{
+		AnalyseUnitTypes(unitDefs, cb);
+		SaveCacheFile(cacheFilename, cacheKey);
+	}
+
+	m_combatPowerOfUnits.resize(numberOfUnitTypes+1);
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// calculate unit category statistics
+	//-----------------------------------------------------------------------------------------------------------------
+
+	m_unitCategoryStatisticsOfSide.resize(m_numberOfSides);
+
+	for(int side = 0; side < m_numberOfSides; ++side)
+	{
+		m_unitCategoryStatisticsOfSide[side].Init(unitDefs, m_unitTypeProperties, m_unitsInCategory[side], m_unitsInCombatCategory[side]);
+	}
+
+    return true;
+}
+
+void AAIBuildTree::AnalyseUnitTypes(const std::vector<const springLegacyAI::UnitDef*>& unitDefs, springLegacyAI::IAICallback* cb)
+{
+	const int numberOfUnitTypes = static_cast<int>(unitDefs.size()) - 1;
+
+	// unit ids start with 1 -> add one additional element to arrays to be able to directly access unit def with corresponding id
+	m_unitTypeProperties.assign(numberOfUnitTypes+1, UnitTypeProperties());
+	m_sideOfUnitType.assign(numberOfUnitTypes+1, 0);
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// determine build tree
+	//-----------------------------------------------------------------------------------------------------------------
+	InitConstructionRelations(unitDefs, cb);
 
 	//-----------------------------------------------------------------------------------------------------------------
 	// determine "roots" of buildtrees
@@ -364,8 +406,8 @@ bool AAIBuildTree::Generate(springLegacyAI::IAICallback* cb)
 
 	for(int id = 1; id <= numberOfUnitTypes; ++id)
 	{
-		if(    (m_unitTypeCanConstructLists[id].size() > 0) 
-			&& (m_unitTypeCanBeConstructedtByLists[id].size() == 0) )
+		if(    (GetCanConstructList(id).empty() == false) 
+			&& (GetConstructedByList(id).empty() == true) )
 		{
 			rootUnits.push_back(id);
 		}
@@ -382,7 +424,7 @@ bool AAIBuildTree::Generate(springLegacyAI::IAICallback* cb)
 	// assign sides to units
 	//-----------------------------------------------------------------------------------------------------------------
 	m_numberOfSides = 0;
-	m_startUnitsOfSide.resize( rootUnits.size()+1, 0);  // +1 because of neutral (side = 0) units
+	m_startUnitsOfSide.assign( rootUnits.size()+1, 0);  // +1 because of neutral (side = 0) units
 
 	for(std::list<int>::iterator id = rootUnits.begin(); id != rootUnits.end(); ++id)
 	{
@@ -391,14 +433,9 @@ bool AAIBuildTree::Generate(springLegacyAI::IAICallback* cb)
 		m_startUnitsOfSide[m_numberOfSides] = *id;
 	}
 
-	m_unitsInCategory.resize(m_numberOfSides); // no need to create statistics for neutral units
-	m_unitsInCombatCategory.resize(m_numberOfSides);
-
-	for(int side = 0; side < m_numberOfSides; ++side)
-	{
-		m_unitsInCategory[side].resize( AAIUnitCategory::numberOfUnitCategories ); 
-		m_unitsInCombatCategory[side].resize( AAICombatUnitCategory::numberOfCombatUnitCategories );
-	}
+	// no need to create statistics for neutral units
+	m_unitsInCategory.assign(m_numberOfSides, std::vector< std::list<UnitDefId> >(AAIUnitCategory::numberOfUnitCategories) );
+	m_unitsInCombatCategory.assign(m_numberOfSides, std::vector< std::list<UnitDefId> >(AAICombatUnitCategory::numberOfCombatUnitCategories) );
 
 	//-----------------------------------------------------------------------------------------------------------------
 	// set further unit type properties
@@ -477,19 +514,213 @@ bool AAIBuildTree::Generate(springLegacyAI::IAICallback* cb)
 	}
 
 	InitFactoryDefIdLookUpTable(numberOfFactories);
+}
+
+uint64_t AAIBuildTree::CalculateCacheKey(springLegacyAI::IAICallback* cb) const
+{
+	const int         modHash = cb->GetModHash();
+	const std::string modName(cb->GetModName());
+
+	uint64_t hash = AAICalculateHash(&modHash, sizeof(modHash));
+	hash = AAICalculateHash(modName.c_str(), modName.size(), hash);
+
+	// config settings that affect the analysis of the unit types
+	const int   configValues[4]      = { cfg->numberOfSides, cfg->MIN_ENERGY, cfg->MIN_ENERGY_STORAGE, cfg->MIN_METAL_STORAGE };
+	const float configFloatValues[4] = { cfg->SCOUT_SPEED, cfg->GROUND_ARTY_RANGE, cfg->HOVER_ARTY_RANGE, cfg->STATIONARY_ARTY_RANGE };
+
+	hash = AAICalculateHash(configValues,      sizeof(configValues),      hash);
+	hash = AAICalculateHash(configFloatValues, sizeof(configFloatValues), hash);
+
+	for(const std::list<int>* unitList : { &cfg->m_startUnits, &cfg->m_scouts, &cfg->m_transporters, &cfg->m_metalMakers, &cfg->m_bombers, &cfg->m_meleeUnits, &cfg->m_ignoredUnits })
+	{
+		const int numberOfUnits = static_cast<int>(unitList->size());
+		hash = AAICalculateHash(&numberOfUnits, sizeof(numberOfUnits), hash);
+
+		for(const int id : *unitList)
+			hash = AAICalculateHash(&id, sizeof(id), hash);
+	}
+
+	return hash;
+}
+
+//! @brief Appends the size of the given vector followed by its elements
+template<typename T>
+void AddVectorToCacheFile(AAICacheFileWriter& writer, const std::vector<T>& data)
+{
+	writer.Add( static_cast<int32_t>(data.size()) );
+	writer.AddArray(data.data(), data.size());
+}
+
+//! @brief Reads a vector stored by AddVectorToCacheFile(...)
+template<typename T>
+bool GetVectorFromCacheFile(AAICacheFileReader& reader, std::vector<T>& data)
+{
+	int32_t size;
+
+	if( (reader.Get(size) == false) || (size < 0) )
+		return false;
+
+	data.resize(size);
+	return reader.GetArray(data.data(), data.size());
+}
+
+//! @brief Appends the given unit lists (number of units followed by their ids for each list)
+void AddUnitListsToCacheFile(AAICacheFileWriter& writer, const std::vector< std::list<UnitDefId> >& unitLists)
+{
+	for(const auto& unitList : unitLists)
+	{
+		const std::vector<UnitDefId> unitDefIds(unitList.begin(), unitList.end());
+		AddVectorToCacheFile(writer, unitDefIds);
+	}
+}
+
+//! @brief Reads unit lists stored by AddUnitListsToCacheFile(...)
+bool GetUnitListsFromCacheFile(AAICacheFileReader& reader, std::vector< std::list<UnitDefId> >& unitLists)
+{
+	std::vector<UnitDefId> unitDefIds;
+
+	for(auto& unitList : unitLists)
+	{
+		if(GetVectorFromCacheFile(reader, unitDefIds) == false)
+			return false;
+
+		unitList.assign(unitDefIds.begin(), unitDefIds.end());
+	}
+
+	return true;
+}
+
+void AAIBuildTree::SaveCacheFile(const std::string& filename, uint64_t cacheKey) const
+{
+	AAICacheFileWriter writer;
+
+	const int numberOfUnitTypes = static_cast<int>(m_unitTypeProperties.size()) - 1;
+
+	writer.Add( static_cast<int32_t>(m_numberOfSides) );
 
 	//-----------------------------------------------------------------------------------------------------------------
-	// calculate unit category statistics
+	// construction relations & sides
 	//-----------------------------------------------------------------------------------------------------------------
+	AddVectorToCacheFile(writer, m_constructedByUnitTypes);
+	AddVectorToCacheFile(writer, m_constructedByOffsets);
+	AddVectorToCacheFile(writer, m_canConstructUnitTypes);
+	AddVectorToCacheFile(writer, m_canConstructOffsets);
+	AddVectorToCacheFile(writer, m_builderRowOfUnitType);
+	writer.Add( static_cast<int32_t>(m_wordsPerBuilderRow) );
+	AddVectorToCacheFile(writer, m_canConstructBitmatrix);
+	AddVectorToCacheFile(writer, m_canEventuallyConstructBitmatrix);
+	AddVectorToCacheFile(writer, m_sideOfUnitType);
+	AddVectorToCacheFile(writer, m_startUnitsOfSide);
 
-	m_unitCategoryStatisticsOfSide.resize(m_numberOfSides);
+	//-----------------------------------------------------------------------------------------------------------------
+	// unit type properties (names stored as length followed by characters)
+	//-----------------------------------------------------------------------------------------------------------------
+	for(int id = 1; id <= numberOfUnitTypes; ++id)
+	{
+		const UnitTypeProperties& properties = m_unitTypeProperties[id];
+
+		writer.Add( static_cast<int32_t>(properties.m_name.size()) );
+		writer.AddArray(properties.m_name.c_str(), properties.m_name.size());
+
+		writer.Add(properties.m_totalCost);
+		writer.Add(properties.m_buildtime);
+		writer.Add(properties.m_health);
+		writer.Add(properties.m_primaryAbility);
+		writer.Add(properties.m_secondaryAbility);
+		writer.Add(properties.m_movementType);
+		writer.Add(properties.m_footprint);
+		writer.Add(properties.m_unitCategory);
+		writer.Add(properties.m_unitType);
+		writer.Add(properties.m_targetType);
+		writer.Add(properties.m_factoryId);
+	}
 
+	//-----------------------------------------------------------------------------------------------------------------
+	// units per category
+	//-----------------------------------------------------------------------------------------------------------------
 	for(int side = 0; side < m_numberOfSides; ++side)
 	{
-		m_unitCategoryStatisticsOfSide[side].Init(unitDefs, m_unitTypeProperties, m_unitsInCategory[side], m_unitsInCombatCategory[side]);
+		AddUnitListsToCacheFile(writer, m_unitsInCategory[side]);
+		AddUnitListsToCacheFile(writer, m_unitsInCombatCategory[side]);
 	}
 
-    return true;
+	AddVectorToCacheFile(writer, m_factoryIdsTable);
+
+	// number of unit types stored in place of map size to reject cache files of a different set of unit definitions
+	writer.WriteToFile(filename, BUILD_TREE_CACHE_VERSION, cacheKey, numberOfUnitTypes, 0);
+}
+
+bool AAIBuildTree::ReadCacheFile(const std::string& filename, uint64_t cacheKey, int numberOfUnitTypes)
+{
+	AAICacheFileReader reader;
+
+	if(reader.ReadFromFile(filename, BUILD_TREE_CACHE_VERSION, cacheKey, numberOfUnitTypes, 0) == false)
+		return false;
+
+	int32_t numberOfSides, wordsPerBuilderRow;
+
+	bool success =    reader.Get(numberOfSides)
+	               && (numberOfSides >= 0)
+	               && GetVectorFromCacheFile(reader, m_constructedByUnitTypes)
+	               && GetVectorFromCacheFile(reader, m_constructedByOffsets)
+	               && GetVectorFromCacheFile(reader, m_canConstructUnitTypes)
+	               && GetVectorFromCacheFile(reader, m_canConstructOffsets)
+	               && GetVectorFromCacheFile(reader, m_builderRowOfUnitType)
+	               && reader.Get(wordsPerBuilderRow)
+	               && GetVectorFromCacheFile(reader, m_canConstructBitmatrix)
+	               && GetVectorFromCacheFile(reader, m_canEventuallyConstructBitmatrix)
+	               && GetVectorFromCacheFile(reader, m_sideOfUnitType)
+	               && GetVectorFromCacheFile(reader, m_startUnitsOfSide);
+
+	m_numberOfSides      = numberOfSides;
+	m_wordsPerBuilderRow = wordsPerBuilderRow;
+
+	m_unitTypeProperties.assign(numberOfUnitTypes+1, UnitTypeProperties());
+
+	std::vector<char> name;
+
+	for(int id = 1; success && (id <= numberOfUnitTypes); ++id)
+	{
+		UnitTypeProperties& properties = m_unitTypeProperties[id];
+
+		success =    GetVectorFromCacheFile(reader, name)
+		          && reader.Get(properties.m_totalCost)
+		          && reader.Get(properties.m_buildtime)
+		          && reader.Get(properties.m_health)
+		          && reader.Get(properties.m_primaryAbility)
+		          && reader.Get(properties.m_secondaryAbility)
+		          && reader.Get(properties.m_movementType)
+		          && reader.Get(properties.m_footprint)
+		          && reader.Get(properties.m_unitCategory)
+		          && reader.Get(properties.m_unitType)
+		          && reader.Get(properties.m_targetType)
+		          && reader.Get(properties.m_factoryId);
+
+		properties.m_name.assign(name.begin(), name.end());
+	}
+
+	if(success)
+	{
+		m_unitsInCategory.assign(m_numberOfSides, std::vector< std::list<UnitDefId> >(AAIUnitCategory::numberOfUnitCategories) );
+		m_unitsInCombatCategory.assign(m_numberOfSides, std::vector< std::list<UnitDefId> >(AAICombatUnitCategory::numberOfCombatUnitCategories) );
+
+		for(int side = 0; success && (side < m_numberOfSides); ++side)
+		{
+			success =    GetUnitListsFromCacheFile(reader, m_unitsInCategory[side])
+			          && GetUnitListsFromCacheFile(reader, m_unitsInCombatCategory[side]);
+		}
+	}
+
+	success =    success
+	          && GetVectorFromCacheFile(reader, m_factoryIdsTable)
+	          && reader.IsAtEnd()
+	          && (m_sideOfUnitType.size()     == static_cast<size_t>(numberOfUnitTypes+1))
+	          && (m_startUnitsOfSide.size()   == static_cast<size_t>(m_numberOfSides+1))
+	          && (m_canConstructOffsets.size()  == static_cast<size_t>(numberOfUnitTypes+2))
+	          && (m_constructedByOffsets.size() == static_cast<size_t>(numberOfUnitTypes+2))
+	          && (m_builderRowOfUnitType.size() == static_cast<size_t>(numberOfUnitTypes+1));
+
+	return success;
 }
 
 void AAIBuildTree::PrintSummaryToFile(const std::string& filename, springLegacyAI::IAICallback* cb) const
@@ -652,9 +883,111 @@ void AAIBuildTree::AssignSideToUnitType(int side, UnitDefId unitDefId)
 		m_sideOfUnitType[unitDefId.id] = side;
 
 		// continue with unit types constructed by given unit type
-		for( std::list<UnitDefId>::iterator id = m_unitTypeCanConstructLists[unitDefId.id].begin(); id != m_unitTypeCanConstructLists[unitDefId.id].end(); ++id)
+		for(const auto constructedUnitDefId : GetCanConstructList(unitDefId))
+		{
+			AssignSideToUnitType(side, constructedUnitDefId);
+		}
+	}
+}
+
+void AAIBuildTree::InitConstructionRelations(const std::vector<const springLegacyAI::UnitDef*>& unitDefs, springLegacyAI::IAICallback* cb)
+{
+	const int numberOfUnitTypes = static_cast<int>(unitDefs.size()) - 1;
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// store build options of every unit type consecutively
+	//-----------------------------------------------------------------------------------------------------------------
+	m_canConstructUnitTypes.clear();
+	m_canConstructOffsets.assign(numberOfUnitTypes+2, 0);
+	std::vector<int> numberOfConstructors(numberOfUnitTypes+1, 0);
+
+	for(int id = 1; id <= numberOfUnitTypes; ++id)
+	{
+		m_canConstructOffsets[id] = static_cast<int>(m_canConstructUnitTypes.size());
+
+		for(const auto& constructableUnit : unitDefs[id]->buildOptions)
+		{
+			const int canConstructId = cb->GetUnitDef(constructableUnit.second.c_str())->id;
+
+			m_canConstructUnitTypes.push_back( UnitDefId(canConstructId) );
+			++numberOfConstructors[canConstructId];
+		}
+	}
+
+	m_canConstructOffsets[numberOfUnitTypes+1] = static_cast<int>(m_canConstructUnitTypes.size());
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// store constructors of every unit type consecutively (in ascending order of their id)
+	//-----------------------------------------------------------------------------------------------------------------
+	m_constructedByOffsets.assign(numberOfUnitTypes+2, 0);
+
+	for(int id = 1; id <= numberOfUnitTypes; ++id)
+		m_constructedByOffsets[id+1] = m_constructedByOffsets[id] + numberOfConstructors[id];
+
+	m_constructedByUnitTypes.resize(m_canConstructUnitTypes.size());
+	std::vector<int> nextFreeIndex(m_constructedByOffsets.begin(), m_constructedByOffsets.end()-1);
+
+	for(int id = 1; id <= numberOfUnitTypes; ++id)
+	{
+		for(const auto constructedUnitDefId : GetCanConstructList(id))
+		{
+			m_constructedByUnitTypes[ nextFreeIndex[constructedUnitDefId.id] ] = UnitDefId(id);
+			++nextFreeIndex[constructedUnitDefId.id];
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// set up bitmatrices with one row for every unit type that can construct other unit types
+	//-----------------------------------------------------------------------------------------------------------------
+	m_builderRowOfUnitType.assign(numberOfUnitTypes+1, -1);
+	m_wordsPerBuilderRow = (numberOfUnitTypes + 1 + 63) / 64;
+
+	int numberOfBuilders(0);
+
+	for(int id = 1; id <= numberOfUnitTypes; ++id)
+	{
+		if(GetCanConstructList(id).empty() == false)
+		{
+			m_builderRowOfUnitType[id] = numberOfBuilders;
+			++numberOfBuilders;
+		}
+	}
+
+	m_canConstructBitmatrix.assign(numberOfBuilders * m_wordsPerBuilderRow, 0u);
+	m_canEventuallyConstructBitmatrix.assign(numberOfBuilders * m_wordsPerBuilderRow, 0u);
+
+	std::vector<UnitDefId> unitTypesToVisit;
+
+	for(int id = 1; id <= numberOfUnitTypes; ++id)
+	{
+		if(m_builderRowOfUnitType[id] < 0)
+			continue;
+
+		uint64_t* canConstruct           = &m_canConstructBitmatrix[m_builderRowOfUnitType[id] * m_wordsPerBuilderRow];
+		uint64_t* canEventuallyConstruct = &m_canEventuallyConstructBitmatrix[m_builderRowOfUnitType[id] * m_wordsPerBuilderRow];
+
+		for(const auto constructedUnitDefId : GetCanConstructList(id))
 		{
-			AssignSideToUnitType(side, *id);
+			canConstruct[constructedUnitDefId.id >> 6] |= uint64_t(1) << (constructedUnitDefId.id & 63);
+			unitTypesToVisit.push_back(constructedUnitDefId);
+		}
+
+		// transitive closure: follow build options of constructed unit types until no further unit types are found
+		while(unitTypesToVisit.empty() == false)
+		{
+			const UnitDefId unitDefId = unitTypesToVisit.back();
+			unitTypesToVisit.pop_back();
+
+			uint64_t&      word = canEventuallyConstruct[unitDefId.id >> 6];
+			const uint64_t bit  = uint64_t(1) << (unitDefId.id & 63);
+
+			if((word & bit) == 0u)
+			{
+				word |= bit;
+
+				for(const auto constructedUnitDefId : GetCanConstructList(unitDefId))
+					unitTypesToVisit.push_back(constructedUnitDefId);
+			}
 		}
 	}
 }
@@ -872,7 +1205,7 @@ EUnitCategory AAIBuildTree::DetermineUnitCategory(const springLegacyAI::UnitDef*
 		{
 			return EUnitCategory::STATIC_ASSISTANCE;
 		}
-		else if(m_unitTypeCanConstructLists[unitDef->id].size() > 0)
+		else if(GetCanConstructList(unitDef->id).empty() == false)
 		{
 			return EUnitCategory::STATIC_CONSTRUCTOR;
 		}
@@ -960,7 +1293,7 @@ EUnitCategory AAIBuildTree::DetermineUnitCategory(const springLegacyAI::UnitDef*
 		}
 
 		// --------------- armed units --------------------------------------------------------------------------------
-		if(    (m_unitTypeCanConstructLists[unitDef->id].size() > 0)
+		if(    (GetCanConstructList(unitDef->id).empty() == false)
 			|| (unitDef->canResurrect == true)
 			|| (unitDef->canAssist    == true)  )
 		{
@@ -1100,19 +1433,6 @@ float AAIBuildTree::GetMaxDamage(const springLegacyAI::UnitDef* unitDef) const
 	return maxDamage;
 }
 
-bool AAIBuildTree::CanBuildUnitType(UnitDefId unitDefIdBuilder, UnitDefId unitDefId) const
-{
-    // look in build options of builder for unit type
-    for(std::list<UnitDefId>::const_iterator id = m_unitTypeCanConstructLists[unitDefIdBuilder.id].begin(); id != m_unitTypeCanConstructLists[unitDefIdBuilder.id].end(); ++id)
-    {
-        if((*id).id == unitDefId.id)
-            return true;
-    }
-
-    // unit type not found in build options
-    return false;
-}
-
 bool AAIBuildTree::IsStartingUnit(UnitDefId unitDefId) const
 {
     if(m_initialized == false)
@@ -16,9 +16,30 @@
 #include "LegacyCpp/IAICallback.h"
 
 #include <stdio.h>
+#include <cstdint>
 #include <list>
 #include <vector>
 
+//! @brief A read only view of unit type ids stored contiguously within the build tree (e.g. the build options of a constructor)
+class UnitDefIdSpan
+{
+public:
+	UnitDefIdSpan(const UnitDefId* begin, const UnitDefId* end) : m_begin(begin), m_end(end) {}
+
+	const UnitDefId* begin() const { return m_begin; }
+
+	const UnitDefId* end()   const { return m_end; }
+
+	size_t size()  const { return static_cast<size_t>(m_end - m_begin); }
+
+	bool   empty() const { return (m_begin == m_end); }
+
+private:
+	const UnitDefId* m_begin;
+
+	const UnitDefId* m_end;
+};
+
 //! @brief This class stores the build-tree, this includes which unit builds another, to which side each unit belongs
 class AAIBuildTree
 {
@@ -30,8 +51,8 @@ public:
 	//! @brief Generates buildtree for current game/mod
 	bool Generate(springLegacyAI::IAICallback* cb);
 
-	//! @brief Saves the combat power of units to given 
-	void SaveCombatPowerOfUnits(FILE* saveFile) const;
+	//! @brief Appends the combat power of units (as stored in mod learn file) to given buffer
+	void SaveCombatPowerOfUnits(AAITextBuffer& buffer) const;
 
 	//! @brief Initializes the combat power of units and invokes update of the unit types (returns true if successful)
 	bool LoadCombatPowerOfUnits(FILE* inputFile);
@@ -46,16 +67,19 @@ public:
 	void PrintSummaryToFile(const std::string& filename, springLegacyAI::IAICallback* cb) const;
 
 	//! @brief Returns whether given the given unit type can be constructed by the given constructor unit type
-	bool CanBuildUnitType(UnitDefId unitDefIdBuilder, UnitDefId unitDefId) const;
+	bool CanBuildUnitType(UnitDefId unitDefIdBuilder, UnitDefId unitDefId) const { return IsBitSet(m_canConstructBitmatrix, unitDefIdBuilder, unitDefId); }
+
+	//! @brief Returns whether the given unit type can be constructed by the given constructor unit type or by any unit type it can (indirectly) construct
+	bool CanEventuallyBuildUnitType(UnitDefId unitDefIdBuilder, UnitDefId unitDefId) const { return IsBitSet(m_canEventuallyConstructBitmatrix, unitDefIdBuilder, unitDefId); }
 
 	//! @brief Return side of given unit type (0 if not initialized)
 	int GetSideOfUnitType(UnitDefId unitDefId) const { return m_initialized ? m_sideOfUnitType[unitDefId.id] : 0; }
 
 	//! @brief Returns the list of units that can construct the given unit.
-	const std::list<UnitDefId>& GetConstructedByList(UnitDefId unitDefId) const { return m_unitTypeCanBeConstructedtByLists[unitDefId.id]; }
+	UnitDefIdSpan GetConstructedByList(UnitDefId unitDefId) const { return GetSpan(m_constructedByUnitTypes, m_constructedByOffsets, unitDefId); }
 
 	//! @brief Returns the list of units that can be construct by the given unit.
-	const std::list<UnitDefId>& GetCanConstructList(UnitDefId unitDefId) const { return m_unitTypeCanConstructLists[unitDefId.id]; }
+	UnitDefIdSpan GetCanConstructList(UnitDefId unitDefId) const { return GetSpan(m_canConstructUnitTypes, m_canConstructOffsets, unitDefId); }
 
 	//! @brief Returns the number of sides
 	int GetNumberOfSides() const { return m_numberOfSides; }
@@ -111,6 +135,9 @@ public:
 	//! @brief Returns combat power of given unit type
 	const TargetTypeValues& GetCombatPower(UnitDefId unitDefId)   const { return m_combatPowerOfUnits[unitDefId.id]; }
 
+	//! @brief Returns a counter that is increased whenever the combat power of any unit type changes (allows detection of outdated cached data)
+	uint32_t GetCombatPowerVersion() const { return m_combatPowerVersion; }
+
 	//! @brief Returns the list of units of the given category for given side
 	const std::list<UnitDefId>& GetUnitsInCategory(const AAIUnitCategory& category, int side) const { return m_unitsInCategory[side-1][category.GetArrayIndex()]; }
 
@@ -136,6 +163,39 @@ private:
 	//! @brief Sets side for given unit type, and recursively calls itself for all unit types that can be constructed by it.
 	void AssignSideToUnitType(int side, UnitDefId unitDefId);
 
+	//! @brief Determines construction relations, sides, and properties (except combat power) of all unit types from their unit definitions
+	void AnalyseUnitTypes(const std::vector<const springLegacyAI::UnitDef*>& unitDefs, springLegacyAI::IAICallback* cb);
+
+	//! @brief Returns the hash identifying the current mod and the config settings that affect the analysis of the unit types
+	uint64_t CalculateCacheKey(springLegacyAI::IAICallback* cb) const;
+
+	//! @brief Saves the result of AnalyseUnitTypes(...) to a binary cache file
+	void SaveCacheFile(const std::string& filename, uint64_t cacheKey) const;
+
+	//! @brief Loads the result of AnalyseUnitTypes(...) from the given cache file (returns false if file is missing, outdated, or invalid)
+	bool ReadCacheFile(const std::string& filename, uint64_t cacheKey, int numberOfUnitTypes);
+
+	//! @brief Stores the build options of all unit types as contiguous arrays (can construct/constructed by) and sets up the capability bitmatrices
+	void InitConstructionRelations(const std::vector<const springLegacyAI::UnitDef*>& unitDefs, springLegacyAI::IAICallback* cb);
+
+	//! @brief Returns the span of the given unit type within the given (offset-indexed) array of unit type ids
+	UnitDefIdSpan GetSpan(const std::vector<UnitDefId>& unitTypes, const std::vector<int>& offsets, UnitDefId unitDefId) const
+	{
+		const UnitDefId* data = unitTypes.data();
+		return UnitDefIdSpan(data + offsets[unitDefId.id], data + offsets[unitDefId.id+1]);
+	}
+
+	//! @brief Returns whether the bit of the given unit type is set in the row of the given constructor unit type
+	bool IsBitSet(const std::vector<uint64_t>& bitmatrix, UnitDefId unitDefIdBuilder, UnitDefId unitDefId) const
+	{
+		const int row = m_builderRowOfUnitType[unitDefIdBuilder.id];
+
+		if(row < 0)
+			return false;
+
+		return (bitmatrix[row * m_wordsPerBuilderRow + (unitDefId.id >> 6)] & (uint64_t(1) << (unitDefId.id & 63))) != 0u;
+	}
+
 	//! @brief 	Returns the primary ability (weapon range for combat units, artillery, or static defences, los for scout, radar(jammer) range, 
 	//!         buildtime for constructors, metal extraction for extractors, metal storage capacity for storages), generated power for power plants
 	float DeterminePrimaryAbility(const springLegacyAI::UnitDef* unitDef, const AAIUnitCategory& unitCategory, springLegacyAI::IAICallback* cb) const;
@@ -183,11 +243,29 @@ private:
 	//! Flag if build tree is initialized
 	bool                                          m_initialized;
 
-	//! For every unit type, a list of unit types (unit type id) that may contsruct it 
-	std::vector< std::list<UnitDefId> >           m_unitTypeCanBeConstructedtByLists;
+	//! The unit types that may construct a certain unit type, stored consecutively for all unit types (ordered by id of the constructed unit type)
+	std::vector<UnitDefId>                        m_constructedByUnitTypes;
 
-	//! For every unit type, a list of unit types (unit type id) that it may contsruct (e.g. empty if it cannot construct any units) 
-	std::vector< std::list<UnitDefId> >           m_unitTypeCanConstructLists;
+	//! For every unit type, the index of the first unit type in m_constructedByUnitTypes that may construct it (one additional element marks the end)
+	std::vector<int>                              m_constructedByOffsets;
+
+	//! The unit types a certain unit type may construct, stored consecutively for all unit types (ordered by id of the constructor unit type)
+	std::vector<UnitDefId>                        m_canConstructUnitTypes;
+
+	//! For every unit type, the index of its first build option in m_canConstructUnitTypes (one additional element marks the end)
+	std::vector<int>                              m_canConstructOffsets;
+
+	//! For every unit type, the row in the capability bitmatrices (-1 if unit type cannot construct any units)
+	std::vector<int>                              m_builderRowOfUnitType;
+
+	//! Number of 64 bit words per row of the capability bitmatrices
+	int                                           m_wordsPerBuilderRow;
+
+	//! One row per constructor unit type with one bit per unit type that is set if it is a build option of the constructor
+	std::vector<uint64_t>                         m_canConstructBitmatrix;
+
+	//! One row per constructor unit type with one bit per unit type that is set if it can be constructed directly or indirectly (i.e. by a unit type it can construct)
+	std::vector<uint64_t>                         m_canEventuallyConstructBitmatrix;
 
 	//! Properties of every unit type needed by other parts of AAI for decision making
 	std::vector< UnitTypeProperties >             m_unitTypeProperties;
@@ -219,6 +297,9 @@ private:
 	//! The combat power of every unit
 	std::vector<TargetTypeValues>                 m_combatPowerOfUnits;
 
+	//! Increased whenever combat power of any unit has been initialized/loaded/updated
+	uint32_t                                      m_combatPowerVersion;
+
 	//! This vetcor stores the UnitDefIds corresponding to any valid factory id
 	std::vector<UnitDefId>                        m_factoryIdsTable;
 };
@@ -0,0 +1,101 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#include <cstdio>
+
+#include "AAICacheFile.h"
+
+//! Magic number identifying AAI cache files
+static const char cacheFileMagic[4] = {'A', 'A', 'I', 'C'};
+
+//! Version of the binary layout - increase if header or encoding changes
+static constexpr uint32_t cacheFileFormatVersion = 1;
+
+static_assert(sizeof(AAICacheFileHeader) == 72, "Unexpected padding in cache file header");
+
+uint64_t AAICalculateHash(const void* data, size_t size, uint64_t hash)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+	for(size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+bool AAICacheFileWriter::WriteToFile(const std::string& filename, const char* contentVersion, uint64_t mapHash, int xMapSize, int yMapSize) const
+{
+	AAICacheFileHeader header;
+	std::memset(&header, 0, sizeof(header));
+
+	std::memcpy(header.magic, cacheFileMagic, sizeof(header.magic));
+	std::strncpy(header.contentVersion, contentVersion, sizeof(header.contentVersion)-1);
+	header.formatVersion = cacheFileFormatVersion;
+	header.xMapSize      = xMapSize;
+	header.yMapSize      = yMapSize;
+	header.payloadSize   = static_cast<uint32_t>(m_payload.size());
+	header.mapHash       = mapHash;
+	header.checksum      = AAICalculateHash(m_payload.data(), m_payload.size());
+
+	FILE* file = fopen(filename.c_str(), "wb");
+
+	if(file == nullptr)
+		return false;
+
+	bool success = (fwrite(&header, sizeof(header), 1, file) == 1);
+
+	if(success && (m_payload.empty() == false))
+		success = (fwrite(m_payload.data(), m_payload.size(), 1, file) == 1);
+
+	fclose(file);
+
+	return success;
+}
+
+bool AAICacheFileReader::ReadFromFile(const std::string& filename, const char* contentVersion, uint64_t mapHash, int xMapSize, int yMapSize)
+{
+	m_payload.clear();
+	m_readPosition = 0;
+
+	FILE* file = fopen(filename.c_str(), "rb");
+
+	if(file == nullptr)
+		return false;
+
+	AAICacheFileHeader header;
+
+	const bool headerValid =    (fread(&header, sizeof(header), 1, file) == 1)
+	                         && (std::memcmp(header.magic, cacheFileMagic, sizeof(header.magic)) == 0)
+	                         && (header.formatVersion == cacheFileFormatVersion)
+	                         && (std::strncmp(header.contentVersion, contentVersion, sizeof(header.contentVersion)) == 0)
+	                         && (header.mapHash  == mapHash)
+	                         && (header.xMapSize == xMapSize)
+	                         && (header.yMapSize == yMapSize);
+
+	if(headerValid)
+	{
+		m_payload.resize(header.payloadSize);
+
+		const bool payloadRead = m_payload.empty() || (fread(m_payload.data(), m_payload.size(), 1, file) == 1);
+
+		if( !payloadRead || (AAICalculateHash(m_payload.data(), m_payload.size()) != header.checksum) )
+			m_payload.clear();
+		else
+		{
+			fclose(file);
+			return true;
+		}
+	}
+
+	fclose(file);
+	return false;
+}
@@ -0,0 +1,114 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#ifndef AAI_CACHEFILE_H
+#define AAI_CACHEFILE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+//! Header at the beginning of every binary cache file
+struct AAICacheFileHeader
+{
+	//! Identifies the file as an AAI cache file ("AAIC")
+	char     magic[4];
+
+	//! Version of the binary layout (header + payload encoding)
+	uint32_t formatVersion;
+
+	//! Size of the map the data belong to (in map tiles; number of unit types for mod related data)
+	int32_t  xMapSize;
+	int32_t  yMapSize;
+
+	//! Size of the payload (in bytes) following the header
+	uint32_t payloadSize;
+
+	uint32_t reserved;
+
+	//! Version of the stored data (e.g. MAP_CACHE_VERSION), zero terminated
+	char     contentVersion[32];
+
+	//! Hash of the map data (height and metal map) or mod the cache has been created for
+	uint64_t mapHash;
+
+	//! Hash of the payload to detect corrupted/truncated files
+	uint64_t checksum;
+};
+
+//! Collects data in memory and writes them with a header to a binary cache file
+class AAICacheFileWriter
+{
+public:
+	//! @brief Appends the given value to the payload
+	template<typename T>
+	void Add(const T& value) { AddArray(&value, 1); }
+
+	//! @brief Appends the given number of elements (stored as one contiguous block) to the payload
+	template<typename T>
+	void AddArray(const T* data, size_t numberOfElements)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be stored in cache files");
+
+		const char* bytes = reinterpret_cast<const char*>(data);
+		m_payload.insert(m_payload.end(), bytes, bytes + numberOfElements * sizeof(T));
+	}
+
+	//! @brief Writes header and payload to the given file (returns whether successful)
+	bool WriteToFile(const std::string& filename, const char* contentVersion, uint64_t mapHash, int xMapSize, int yMapSize) const;
+
+private:
+	std::vector<char> m_payload;
+};
+
+//! Loads a binary cache file with a single read and provides access to its payload (only accepted if header and checksum are valid)
+class AAICacheFileReader
+{
+public:
+	//! @brief Loads the file and checks its header and checksum against the expected values (returns whether successful)
+	bool ReadFromFile(const std::string& filename, const char* contentVersion, uint64_t mapHash, int xMapSize, int yMapSize);
+
+	//! @brief Reads the next value from the payload (returns false if end of payload has been reached)
+	template<typename T>
+	bool Get(T& value) { return GetArray(&value, 1); }
+
+	//! @brief Copies the given number of elements from the payload (returns false if end of payload has been reached)
+	template<typename T>
+	bool GetArray(T* data, size_t numberOfElements)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be read from cache files");
+
+		const size_t bytes = numberOfElements * sizeof(T);
+
+		if(m_readPosition + bytes > m_payload.size())
+			return false;
+
+		if(bytes > 0)
+			std::memcpy(data, &m_payload[m_readPosition], bytes);
+
+		m_readPosition += bytes;
+		return true;
+	}
+
+	//! @brief Returns true if the complete payload has been read
+	bool IsAtEnd() const { return (m_readPosition == m_payload.size()); }
+
+private:
+	std::vector<char> m_payload;
+
+	//! Position (in bytes) within the payload of the next value to be read
+	size_t m_readPosition = 0;
+};
+
+//! @brief Returns the 64 bit FNV-1a hash of the given data (continuing the given hash if provided)
+uint64_t AAICalculateHash(const void* data, size_t size, uint64_t hash = 14695981039346656037ull);
+
+#endif
@@ -19,6 +19,7 @@
 #include "AAIConfig.h"
 #include "AAIMap.h"
 #include "AAISector.h"
+#include "AAIUnitSnapshot.h"
 
 
 #include "LegacyCpp/UnitDef.h"
@@ -233,7 +234,7 @@ void AAIConstructor::CheckAssistance()
 
 		if(assistanceNeeded)
 		{
-			AAIConstructor* assistant = ai->UnitTable()->FindClosestAssistant(ai->GetAICallback()->GetUnitPos(m_myUnitId.id), 5, true);
+			AAIConstructor* assistant = ai->UnitTable()->FindClosestAssistant(ai->UnitSnapshot()->GetUnitPos(m_myUnitId), 5, true);
 
 			if(assistant)
 			{
@@ -490,7 +491,7 @@ void AAIConstructor::CheckRetreatFromAttackBy(const AAIUnitCategory& attackedByC
 {
 	if(m_activity.IsDestroyed() == false)
 	{
-		const float3 unitPos = ai->GetAICallback()->GetUnitPos(m_myUnitId.id);
+		const float3 unitPos = ai->UnitSnapshot()->GetUnitPos(m_myUnitId);
 
 		const AAISector* sector = ai->Map()->GetSectorOfPos(unitPos);
 
@@ -0,0 +1,208 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+
+#include "AAIConstructorIndex.h"
+#include "AAI.h"
+#include "AAIConstructor.h"
+#include "AAIMap.h"
+#include "AAIUnitSnapshot.h"
+
+#include "LegacyCpp/IGlobalAICallback.h"
+
+AAIConstructorIndex::AAIConstructorIndex() :
+	m_frameOfLastUpdate(-1),
+	m_xCells(1),
+	m_yCells(1)
+{
+}
+
+int AAIConstructorIndex::DetermineCell(const float3& position) const
+{
+	const int x = std::max(0, std::min(static_cast<int>(position.x / AAIConstants::constructorIndexCellSize), m_xCells-1));
+	const int y = std::max(0, std::min(static_cast<int>(position.z / AAIConstants::constructorIndexCellSize), m_yCells-1));
+
+	return x + y * m_xCells;
+}
+
+void AAIConstructorIndex::Update(AAI* ai, const std::set<UnitId>& constructors, const std::vector<AAIUnit>& units)
+{
+	const int currentFrame = ai->GetAICallback()->GetCurrentFrame();
+
+	if(currentFrame == m_frameOfLastUpdate)
+		return;
+
+	m_frameOfLastUpdate = currentFrame;
+
+	m_xCells = std::max(1, static_cast<int>( std::ceil(static_cast<float>(AAIMap::xSize) / AAIConstants::constructorIndexCellSize) ) );
+	m_yCells = std::max(1, static_cast<int>( std::ceil(static_cast<float>(AAIMap::ySize) / AAIConstants::constructorIndexCellSize) ) );
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// fetch position of every constructor
+	//-----------------------------------------------------------------------------------------------------------------
+	m_constructors.clear();
+
+	for(const auto unitId : constructors)
+	{
+		AAIConstructor* constructor = units[unitId.id].cons;
+
+		IndexedConstructor indexedConstructor;
+		indexedConstructor.constructor = constructor;
+		indexedConstructor.position    = ai->UnitSnapshot()->GetUnitPos(unitId);
+		indexedConstructor.maxSpeed    = std::max(0.1f, ai->s_buildTree.GetMaxSpeed(constructor->m_myDefId));
+		indexedConstructor.continent   = ai->s_buildTree.GetMovementType(constructor->m_myDefId).CannotMoveToOtherContinents() ? AAIMap::GetContinentID(indexedConstructor.position) : -1;
+		indexedConstructor.cell        = DetermineCell(indexedConstructor.position);
+
+		m_constructors.push_back(indexedConstructor);
+	}
+
+	std::sort(m_constructors.begin(), m_constructors.end(), [](const IndexedConstructor& lhs, const IndexedConstructor& rhs) 
+		{ return (lhs.continent < rhs.continent) || ( (lhs.continent == rhs.continent) && (lhs.cell < rhs.cell) ); } );
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// set up buckets (constructors of one bucket are stored consecutively, sorted by cell)
+	//-----------------------------------------------------------------------------------------------------------------
+	const int numberOfCells = m_xCells * m_yCells;
+	const int numberOfConstructors = static_cast<int>(m_constructors.size());
+
+	m_buckets.clear();
+	m_cellOffsets.clear();
+
+	int constructorIndex(0);
+
+	while(constructorIndex < numberOfConstructors)
+	{
+		ConstructorBucket bucket;
+		bucket.continent       = m_constructors[constructorIndex].continent;
+		bucket.firstCellOffset = static_cast<int>(m_cellOffsets.size());
+		bucket.maxSpeed        = 0.0f;
+
+		for(int cell = 0; cell < numberOfCells; ++cell)
+		{
+			m_cellOffsets.push_back(constructorIndex);
+
+			while(    (constructorIndex < numberOfConstructors) 
+			       && (m_constructors[constructorIndex].continent == bucket.continent) 
+			       && (m_constructors[constructorIndex].cell == cell) )
+			{
+				bucket.maxSpeed = std::max(bucket.maxSpeed, m_constructors[constructorIndex].maxSpeed);
+				++constructorIndex;
+			}
+		}
+
+		m_cellOffsets.push_back(constructorIndex);
+		m_buckets.push_back(bucket);
+	}
+}
+
+void AAIConstructorIndex::FindClosestConstructors(std::vector<AvailableConstructor>& closestConstructors, const float3& position, int continent, bool considerSpeed,
+                                                  size_t maxNumberOfConstructors, const ConstructorFilter& filter) const
+{
+	closestConstructors.clear();
+
+	if(maxNumberOfConstructors == 0)
+		return;
+
+	for(const auto& bucket : m_buckets)
+	{
+		if( (bucket.continent == -1) || (bucket.continent == continent) )
+			SearchBucket(closestConstructors, bucket, position, considerSpeed, maxNumberOfConstructors, filter);
+	}
+}
+
+void AAIConstructorIndex::DetermineContinents(std::vector<int>& continents, const ConstructorFilter& filter) const
+{
+	continents.clear();
+
+	const int numberOfCells = m_xCells * m_yCells;
+
+	for(const auto& bucket : m_buckets)
+	{
+		const int firstConstructor = m_cellOffsets[bucket.firstCellOffset];
+		const int endConstructor   = m_cellOffsets[bucket.firstCellOffset + numberOfCells];
+
+		for(int i = firstConstructor; i < endConstructor; ++i)
+		{
+			if(filter(m_constructors[i].constructor))
+			{
+				continents.push_back(bucket.continent);
+				break;
+			}
+		}
+	}
+}
+
+void AAIConstructorIndex::SearchBucket(std::vector<AvailableConstructor>& closestConstructors, const ConstructorBucket& bucket, const float3& position, bool considerSpeed,
+                                       size_t maxNumberOfConstructors, const ConstructorFilter& filter) const
+{
+	const int cell  = DetermineCell(position);
+	const int xCell = cell % m_xCells;
+	const int yCell = cell / m_xCells;
+
+	const int maxRing = std::max( std::max(xCell, m_xCells-1-xCell), std::max(yCell, m_yCells-1-yCell) );
+
+	for(int ring = 0; ring <= maxRing; ++ring)
+	{
+		// constructors in cells of the current ring are at least (ring-1) cells away -> stop if they cannot be closer than the ones already found
+		if(closestConstructors.size() == maxNumberOfConstructors)
+		{
+			const float minDistance = static_cast<float>(std::max(ring-1, 0)) * AAIConstants::constructorIndexCellSize;
+			const float lowerBound  = considerSpeed ? minDistance / bucket.maxSpeed : minDistance;
+
+			if(lowerBound >= closestConstructors.back().TravelTimeToBuildSite())
+				return;
+		}
+
+		for(int y = std::max(yCell-ring, 0); y <= std::min(yCell+ring, m_yCells-1); ++y)
+		{
+			// check complete row at top/bottom of the ring, only the left/right cell otherwise
+			const bool completeRow = (y == yCell-ring) || (y == yCell+ring);
+			const int  xStep       = completeRow ? 1 : 2*ring;
+
+			for(int x = xCell-ring; x <= xCell+ring; x += xStep)
+			{
+				if( (x >= 0) && (x < m_xCells) )
+					SearchCell(closestConstructors, bucket, x + y * m_xCells, position, considerSpeed, maxNumberOfConstructors, filter);
+			}
+		}
+	}
+}
+
+void AAIConstructorIndex::SearchCell(std::vector<AvailableConstructor>& closestConstructors, const ConstructorBucket& bucket, int cell, const float3& position, bool considerSpeed,
+                                     size_t maxNumberOfConstructors, const ConstructorFilter& filter) const
+{
+	const int first = m_cellOffsets[bucket.firstCellOffset + cell];
+	const int last  = m_cellOffsets[bucket.firstCellOffset + cell + 1];
+
+	for(int i = first; i < last; ++i)
+	{
+		const IndexedConstructor& indexedConstructor = m_constructors[i];
+
+		if(filter(indexedConstructor.constructor) == false)
+			continue;
+
+		const float dx       = indexedConstructor.position.x - position.x;
+		const float dy       = indexedConstructor.position.z - position.z;
+		const float distance = fastmath::apxsqrt(dx * dx + dy * dy);
+		const float rating   = considerSpeed ? distance / indexedConstructor.maxSpeed : distance;
+
+		if( (closestConstructors.size() == maxNumberOfConstructors) && (rating >= closestConstructors.back().TravelTimeToBuildSite()) )
+			continue;
+
+		auto insertPosition = std::upper_bound(closestConstructors.begin(), closestConstructors.end(), rating, 
+		                                       [](float value, const AvailableConstructor& constructor) { return value < constructor.TravelTimeToBuildSite(); } );
+
+		closestConstructors.insert(insertPosition, AvailableConstructor(indexedConstructor.constructor, rating));
+
+		if(closestConstructors.size() > maxNumberOfConstructors)
+			closestConstructors.pop_back();
+	}
+}
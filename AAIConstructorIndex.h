@@ -0,0 +1,131 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#ifndef AAI_CONSTRUCTORINDEX_H
+#define AAI_CONSTRUCTORINDEX_H
+
+#include <functional>
+#include <set>
+#include <vector>
+
+#include "aidef.h"
+
+class AAI;
+class AAIConstructor;
+
+//! Used to store the information of a construction unit that is currently available
+class AvailableConstructor
+{
+public:
+	AvailableConstructor(AAIConstructor* constructor, float travelTimeToBuildSite) : m_constructor(constructor), m_travelTimeToBuildSite(travelTimeToBuildSite) {}
+
+	AvailableConstructor() : AvailableConstructor(nullptr, 0.0f) {}
+
+	void SetAvailableConstructor(AAIConstructor* constructor, float travelTimeToBuildSite) 
+	{
+		m_constructor           = constructor;
+		m_travelTimeToBuildSite = travelTimeToBuildSite;
+	}
+
+	bool            IsValid()               const { return m_constructor != nullptr; }
+
+	AAIConstructor* Constructor()           const { return m_constructor; }
+
+	float           TravelTimeToBuildSite() const { return m_travelTimeToBuildSite; }
+
+private:
+	AAIConstructor* m_constructor;
+
+	float           m_travelTimeToBuildSite;
+};
+
+//! @brief Function to decide whether a constructor shall be considered by a search (e.g. if it is idle and can build a certain unit type)
+typedef std::function<bool(const AAIConstructor*)> ConstructorFilter;
+
+//! Spatial index of the own constructors: the positions of all constructors are fetched once per frame and sorted into a uniform grid.
+//! Constructors bound to one continent (ground/sea units) are stored in a separate bucket per continent, all others (air, hover, static) in a shared one,
+//! so that searches only visit constructors that are able to reach the requested position.
+class AAIConstructorIndex
+{
+public:
+	AAIConstructorIndex();
+
+	//! @brief Marks the index as outdated (must be called whenever constructors are added or removed)
+	void Invalidate() { m_frameOfLastUpdate = -1; }
+
+	//! @brief Fetches the positions of all given constructors and rebuilds the index (skipped if index has already been updated in the current frame)
+	void Update(AAI* ai, const std::set<UnitId>& constructors, const std::vector<AAIUnit>& units);
+
+	//! @brief Determines up to the given number of constructors accepted by the filter that are closest to the given position (sorted by ascending travel time).
+	//!        If considerSpeed is false, the distance is used instead of the travel time.
+	void FindClosestConstructors(std::vector<AvailableConstructor>& closestConstructors, const float3& position, int continent, bool considerSpeed, 
+	                             size_t maxNumberOfConstructors, const ConstructorFilter& filter) const;
+
+	//! @brief Determines the continents on which constructors accepted by the filter are located (-1 if such a constructor may move to other continents)
+	void DetermineContinents(std::vector<int>& continents, const ConstructorFilter& filter) const;
+
+private:
+	//! Position etc. of a constructor at the time of the last update
+	struct IndexedConstructor
+	{
+		AAIConstructor* constructor;
+
+		float3          position;
+
+		//! Max speed of the constructor (lower bound used to avoid division by zero for static constructors)
+		float           maxSpeed;
+
+		//! Continent the constructor is bound to (-1 if it may move to other continents)
+		int             continent;
+
+		//! Cell of the grid the constructor is located in
+		int             cell;
+	};
+
+	//! Constructors bound to one continent (or not bound to any continent) sorted by cell
+	struct ConstructorBucket
+	{
+		//! Continent of the constructors of this bucket (-1 for constructors that may move to other continents)
+		int   continent;
+
+		//! Index of the first element of this bucket in m_cellOffsets (the bucket occupies number of cells + 1 elements)
+		int   firstCellOffset;
+
+		//! Max speed of all constructors of this bucket
+		float maxSpeed;
+	};
+
+	//! @brief Returns the cell of the grid containing the given position
+	int DetermineCell(const float3& position) const;
+
+	//! @brief Looks for the closest constructors in the given bucket, searching in rings of cells around the given position
+	void SearchBucket(std::vector<AvailableConstructor>& closestConstructors, const ConstructorBucket& bucket, const float3& position, bool considerSpeed,
+	                  size_t maxNumberOfConstructors, const ConstructorFilter& filter) const;
+
+	//! @brief Checks the constructors of the given cell of the given bucket
+	void SearchCell(std::vector<AvailableConstructor>& closestConstructors, const ConstructorBucket& bucket, int cell, const float3& position, bool considerSpeed,
+	                size_t maxNumberOfConstructors, const ConstructorFilter& filter) const;
+
+	//! Frame of the last update of the index (-1 if index needs to be updated)
+	int m_frameOfLastUpdate;
+
+	//! Number of cells of the grid in x and y direction
+	int m_xCells, m_yCells;
+
+	//! All constructors, sorted by bucket and cell
+	std::vector<IndexedConstructor> m_constructors;
+
+	//! For every bucket and cell, the index of the first constructor in m_constructors located in that cell
+	std::vector<int>                m_cellOffsets;
+
+	//! The buckets of the constructors (one for every continent with continent bound constructors + one for all other constructors)
+	std::vector<ConstructorBucket>  m_buckets;
+};
+
+#endif
@@ -0,0 +1,55 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#include "AAIEnemyUnitRegistry.h"
+
+void AAIEnemyUnitRegistry::SetInLOS(UnitId unitId, bool inLOS)
+{
+	m_enemyUnits[unitId.id].inLOS = inLOS;
+	UpdateTracking(unitId);
+}
+
+void AAIEnemyUnitRegistry::SetInRadar(UnitId unitId, bool inRadar)
+{
+	m_enemyUnits[unitId.id].inRadar = inRadar;
+	UpdateTracking(unitId);
+}
+
+void AAIEnemyUnitRegistry::Remove(UnitId unitId)
+{
+	m_enemyUnits[unitId.id].inLOS   = false;
+	m_enemyUnits[unitId.id].inRadar = false;
+	UpdateTracking(unitId);
+
+	m_enemyUnits[unitId.id] = EnemyUnitInfo();
+}
+
+void AAIEnemyUnitRegistry::UpdateTracking(UnitId unitId)
+{
+	EnemyUnitInfo& enemyUnit = m_enemyUnits[unitId.id];
+
+	const bool tracked = enemyUnit.inLOS || enemyUnit.inRadar;
+
+	if(tracked && (enemyUnit.trackedUnitsListIndex < 0))
+	{
+		enemyUnit.trackedUnitsListIndex = static_cast<int>(m_trackedUnits.size());
+		m_trackedUnits.push_back(unitId);
+	}
+	else if(!tracked && (enemyUnit.trackedUnitsListIndex >= 0))
+	{
+		// move last element to position of removed one
+		const UnitId lastUnitId = m_trackedUnits.back();
+
+		m_trackedUnits[enemyUnit.trackedUnitsListIndex] = lastUnitId;
+		m_enemyUnits[lastUnitId.id].trackedUnitsListIndex = enemyUnit.trackedUnitsListIndex;
+		m_trackedUnits.pop_back();
+
+		enemyUnit.trackedUnitsListIndex = -1;
+	}
+}
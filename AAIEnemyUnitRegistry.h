@@ -0,0 +1,96 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#ifndef AAI_ENEMYUNITREGISTRY_H
+#define AAI_ENEMYUNITREGISTRY_H
+
+#include <vector>
+
+#include "aidef.h"
+
+//! Information about an enemy unit that is (or has been) within LOS or radar coverage
+struct EnemyUnitInfo
+{
+	EnemyUnitInfo() :
+		lastSeenPosition(ZeroVector),
+		lastSeenFrame(0),
+		sensorContactGridIndex(-1),
+		trackedUnitsListIndex(-1),
+		inLOS(false),
+		inRadar(false),
+		isStatic(false),
+		finished(false),
+		bombTargetPending(false)
+	{}
+
+	//! Unit type (last one known, invalid if unit has never been within LOS)
+	UnitDefId unitDefId;
+
+	//! Position when unit has been seen the last time
+	float3    lastSeenPosition;
+
+	//! Frame when unit has been seen the last time
+	int       lastSeenFrame;
+
+	//! Index of the sector (within the sector grid) where unit is counted as detected by sensor (-1 if not counted)
+	int       sensorContactGridIndex;
+
+	//! Position in the list of tracked units (-1 if neither within LOS nor radar coverage)
+	int       trackedUnitsListIndex;
+
+	bool      inLOS;
+
+	bool      inRadar;
+
+	//! True if unit is a building (i.e. position does not need to be updated)
+	bool      isStatic;
+
+	//! True if construction of the unit is known to be finished
+	bool      finished;
+
+	//! True if unit is a possible bomb target that has not been accepted yet (e.g. because target list was full)
+	bool      bombTargetPending;
+};
+
+//! Keeps track of the enemy units within LOS/radar coverage based on the corresponding events sent by the engine (instead of querying all enemy units)
+class AAIEnemyUnitRegistry
+{
+public:
+	//! @brief Initializes data for all possible unit ids
+	void Init(int maxUnits) { m_enemyUnits.assign(maxUnits, EnemyUnitInfo()); m_trackedUnits.clear(); }
+
+	//! @brief Returns true if given unit id may be stored in the registry
+	bool IsValid(UnitId unitId) const { return (unitId.id >= 0) && (unitId.id < static_cast<int>(m_enemyUnits.size())); }
+
+	EnemyUnitInfo& GetEnemyUnit(UnitId unitId) { return m_enemyUnits[unitId.id]; }
+
+	//! @brief Sets whether unit is within LOS and adds it to/removes it from the list of tracked units accordingly
+	void SetInLOS(UnitId unitId, bool inLOS);
+
+	//! @brief Sets whether unit is within radar coverage and adds it to/removes it from the list of tracked units accordingly
+	void SetInRadar(UnitId unitId, bool inRadar);
+
+	//! @brief Removes the given unit (e.g. when it has been destroyed)
+	void Remove(UnitId unitId);
+
+	//! @brief Returns the units that are currently within LOS or radar coverage
+	const std::vector<UnitId>& GetTrackedUnits() const { return m_trackedUnits; }
+
+private:
+	//! @brief Adds unit to/removes unit from list of tracked units depending on its LOS/radar state
+	void UpdateTracking(UnitId unitId);
+
+	//! Information about every enemy unit (indexed by unit id)
+	std::vector<EnemyUnitInfo> m_enemyUnits;
+
+	//! Ids of all units currently within LOS or radar coverage
+	std::vector<UnitId>        m_trackedUnits;
+};
+
+#endif
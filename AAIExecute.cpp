@@ -18,9 +18,13 @@
 #include "AAIMap.h"
 #include "AAIGroup.h"
 #include "AAISector.h"
+#include "AAIFrameArena.h"
 
 #include "LegacyCpp/UnitDef.h"
 #include "LegacyCpp/CommandQueue.h"
+
+#include <algorithm>
+#include <cmath>
 using namespace springLegacyAI;
 
 
@@ -429,63 +433,145 @@ bool AAIExecute::BuildExtractor()
 	// normal map
 	//-----------------------------------------------------------------------------------------------------------------
 
-	// check the first 10 free spots for the one with least distance to available builder
+	// the extractor type only depends on whether the spot is under water and whether it is located outside of the
+	// base (armed extractors preferred) -> select each type only once
+	const UnitDefId landExtractor = ai->BuildTable()->SelectExtractor(ai->GetSide(), selectionCriteria, false);
+	const UnitDefId seaExtractor  = ai->BuildTable()->SelectExtractor(ai->GetSide(), selectionCriteria, true);
+
+	selectionCriteria.armed = 0.5f;
+	const UnitDefId outerLandExtractor = ai->BuildTable()->SelectExtractor(ai->GetSide(), selectionCriteria, false);
+	const UnitDefId outerSeaExtractor  = ai->BuildTable()->SelectExtractor(ai->GetSide(), selectionCriteria, true);
+
+	// check the 10 free spots closest to the base (that can be reached by any available builder) - for each spot, the closest
+	// builders are stored as candidates for the assignment of builders to spots
 	const int maxExtractorBuildSpots(10);
-	std::set< std::pair<AvailableMetalSpot, float>, InsertByRatingComparator<AvailableMetalSpot> > extractorSpots;
+	const int maxCheckedSpots(3 * maxExtractorBuildSpots);
+	int       numberOfExtractorBuildSpots(0);
+	AAIFrameVector< std::pair<AvailableMetalSpot, float> > extractorSpotCandidates( AAIFrameAllocator< std::pair<AvailableMetalSpot, float> >(ai->FrameArena()) );
+	AAIFrameVector<const AAIMetalSpot*> checkedSpots( AAIFrameAllocator<const AAIMetalSpot*>(ai->FrameArena()) );
 
 	// determine max search dist - prevent crashes on smaller maps
 	const int maxSearchDist = std::min(cfg->MAX_MEX_DISTANCE, static_cast<int>(ai->Brain()->m_sectorsInDistToBase.size()) );
 
+	const MetalSpotFilter isSuitableSpot = [this, &checkedSpots, maxSearchDist](const AAIMetalSpot& spot)
+	{
+		if(std::find(checkedSpots.begin(), checkedSpots.end(), &spot) != checkedSpots.end())
+			return false;
+
+		const AAISector* sector = ai->Map()->GetSectorOfPos(spot.pos);
+
+		return     sector
+		        && (sector->GetDistanceToBase() >= 0)
+		        && (sector->GetDistanceToBase() < maxSearchDist)
+		        && sector->ShallBeConsideredForExtractorConstruction();
+	};
+
+	// only look for spots on continents where builders are available (commander may not be allowed in every sector, this is checked per spot)
+	std::vector<int> builderContinents;
+	std::vector<int> continentsOfExtractorBuilders;
+
+	for(const auto extractor : {landExtractor, seaExtractor, outerLandExtractor, outerSeaExtractor})
+	{
+		if(extractor.IsValid())
+		{
+			ai->UnitTable()->DetermineContinentsOfAvailableBuilders(continentsOfExtractorBuilders, extractor, true);
+
+			for(const int continent : continentsOfExtractorBuilders)
+			{
+				if(std::find(builderContinents.begin(), builderContinents.end(), continent) == builderContinents.end())
+					builderContinents.push_back(continent);
+			}
+		}
+	}
+
+	// a builder that may move to other continents can reach spots on any continent
+	if(std::find(builderContinents.begin(), builderContinents.end(), -1) != builderContinents.end())
+		builderContinents.assign(1, -1);
+
+	const MapPos& centerOfBase = ai->Brain()->GetCenterOfBase();
+	const float3  basePosition(static_cast<float>(centerOfBase.x * SQUARE_SIZE), 0.0f, static_cast<float>(centerOfBase.y * SQUARE_SIZE));
+
 	bool freeMetalSpotFound = false;
 
-	for(int distanceFromBase = 0; distanceFromBase < maxSearchDist; ++distanceFromBase)
+	for(const int continent : builderContinents)
 	{
-		if(distanceFromBase > 0)
-			selectionCriteria.armed = 0.5f;
+		if( (continent >= 0) && (AAIMap::s_metalSpots.AreFreeSpotsOnContinent(continent) == false) )
+			continue;
 
-		for(auto sector : ai->Brain()->m_sectorsInDistToBase[distanceFromBase])
+		while( (numberOfExtractorBuildSpots < maxExtractorBuildSpots) && (static_cast<int>(checkedSpots.size()) < maxCheckedSpots) )
 		{
-			if( sector->ShallBeConsideredForExtractorConstruction() )
-			{
-				for(auto spot : sector->metalSpots)
-				{
-					if(!spot->occupied)
-					{
-						freeMetalSpotFound = true;
+			AAIMetalSpot* spot = AAIMap::s_metalSpots.FindClosestFreeSpot(basePosition, continent, isSuitableSpot);
 
-						const bool      water     = (spot->pos.y >= 0.0f) ? false : true;
-						const UnitDefId extractor = ai->BuildTable()->SelectExtractor(ai->GetSide(), selectionCriteria, water);
+			if(spot == nullptr)
+				break;
 
-						const AvailableConstructor selectedConstructor = ai->UnitTable()->FindClosestBuilder(extractor, spot->pos, ai->Brain()->IsCommanderAllowedForConstructionInSector(sector));
+			const AAISector* sector = ai->Map()->GetSectorOfPos(spot->pos);
+			const int distanceFromBase = sector->GetDistanceToBase();
 
-						const float rating = (1.0f + ai->Map()->GetDistanceToCenterOfEnemyBase(spot->pos)) / (1.0f + selectedConstructor.TravelTimeToBuildSite());
+			// stop looking for metal spots further away from base if already one found
+			if( (distanceFromBase > 3) && (numberOfExtractorBuildSpots > 0) )
+				break;
 
-						if(selectedConstructor.IsValid())
-							extractorSpots.insert( std::pair<AvailableMetalSpot, float>(AvailableMetalSpot(spot, selectedConstructor.Constructor(), extractor), rating) );
-					}
+			checkedSpots.push_back(spot);
+			freeMetalSpotFound = true;
+
+			const bool      commanderAllowed = ai->Brain()->IsCommanderAllowedForConstructionInSector(sector);
+			const bool      water     = (spot->pos.y >= 0.0f) ? false : true;
+			const UnitDefId extractor = (distanceFromBase > 0) ? (water ? outerSeaExtractor : outerLandExtractor)
+			                                                   : (water ? seaExtractor      : landExtractor);
+
+			const std::vector<AvailableConstructor>& builders = ai->UnitTable()->FindClosestBuilders(extractor, spot->pos, commanderAllowed, AAIConstants::maxBuildersPerMetalSpot);
+
+			if(builders.empty() == false)
+			{
+				const float distanceToEnemyBase = 1.0f + ai->Map()->GetDistanceToCenterOfEnemyBase(spot->pos);
+
+				for(const auto& builder : builders)
+				{
+					const float rating = distanceToEnemyBase / (1.0f + builder.TravelTimeToBuildSite());
+					extractorSpotCandidates.push_back( std::pair<AvailableMetalSpot, float>(AvailableMetalSpot(spot, builder.Constructor(), extractor), rating) );
 				}
-			}
 
-			if(extractorSpots.size() >= maxExtractorBuildSpots)
-				break;
+				++numberOfExtractorBuildSpots;
+			}
 		}
-
-		// stop looking for metal spots further away from base if already one found
-		if( (distanceFromBase > 3) && (extractorSpots.size() > 0) )
-			break;
 	}
 
-	// look for spot with minimum dist to available builder
-	if(extractorSpots.size() > 0)
+	// free spots may exist although no builder is currently available (or all available builders are on other continents) - 
+	// extractor urgency must not be reset in that case
+	if(freeMetalSpotFound == false)
+		freeMetalSpotFound = (AAIMap::s_metalSpots.FindClosestFreeSpot(basePosition, -1, isSuitableSpot) != nullptr);
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// assign builders to spots (greedy: highest rated combination of not yet assigned builder and spot first)
+	//-----------------------------------------------------------------------------------------------------------------
+
+	std::sort(extractorSpotCandidates.begin(), extractorSpotCandidates.end(), InsertByRatingComparator<AvailableMetalSpot>());
+
+	AAIFrameVector<AAIConstructor*> assignedBuilders( AAIFrameAllocator<AAIConstructor*>(ai->FrameArena()) );
+
+	for(const auto& candidate : extractorSpotCandidates)
 	{
-		const AvailableMetalSpot& metalSpot = (extractorSpots.begin())->first;
+		const AvailableMetalSpot& metalSpot = candidate.first;
 
-		// order mex construction for best spot
-		metalSpot.builder->GiveConstructionOrder(metalSpot.extractor, metalSpot.metalSpot->pos);
-		metalSpot.metalSpot->occupied = true;
-		return true;
+		const bool builderAssigned = std::find(assignedBuilders.begin(), assignedBuilders.end(), metalSpot.builder) != assignedBuilders.end();
+
+		if( !metalSpot.metalSpot->occupied && !builderAssigned )
+		{
+			// order mex construction
+			metalSpot.builder->GiveConstructionOrder(metalSpot.extractor, metalSpot.metalSpot->pos);
+			AAIMap::s_metalSpots.SetOccupied(metalSpot.metalSpot);
+
+			assignedBuilders.push_back(metalSpot.builder);
+
+			if(static_cast<int>(assignedBuilders.size()) >= AAIConstants::maxExtractorOrdersPerUpdate)
+				break;
+		}
 	}
 
+	if(assignedBuilders.size() > 0)
+		return true;
+
 	// dont build other things if construction could not be started due to unavailable builders
 	if(freeMetalSpotFound)
 		return false;
@@ -1625,26 +1711,43 @@ void AAIExecute::CheckExtractorUpgrade()
 	float maxExtractedMetalGain(0.0f);
 	AAIMetalSpot* selectedMetalSpot(nullptr);
 
+	// query all spots within a circle around the base center that covers all sectors within/next to the base
+	const MapPos& centerOfBase = ai->Brain()->GetCenterOfBase();
+	const float3  basePosition(static_cast<float>(centerOfBase.x * SQUARE_SIZE), 0.0f, static_cast<float>(centerOfBase.y * SQUARE_SIZE));
+	const float   halfSectorDiagonal = 0.5f * std::sqrt( static_cast<float>(AAIMap::xSectorSize * AAIMap::xSectorSize + AAIMap::ySectorSize * AAIMap::ySectorSize) );
+
+	float searchRadius(0.0f);
+
 	for(int dist = 0; dist < 2; ++dist)
 	{
-		for(auto sector : ai->Brain()->m_sectorsInDistToBase[dist])
+		for(const auto sector : ai->Brain()->m_sectorsInDistToBase[dist])
+			searchRadius = std::max(searchRadius, basePosition.distance2D(sector->GetCenter()) + halfSectorDiagonal);
+	}
+
+	std::vector<AAIMetalSpot*> metalSpots;
+	AAIMap::s_metalSpots.FindSpotsInRadius(metalSpots, basePosition, searchRadius);
+
+	for(auto spot : metalSpots)
+	{
+		if(    spot->extractorDefId.IsValid() 
+		    && spot->extractorUnitId.IsValid() )
 		{
-			for(auto spot : sector->metalSpots)
+			const AAISector* sector = ai->Map()->GetSectorOfPos(spot->pos);
+
+			if(    sector
+			    && (sector->GetDistanceToBase() >= 0)
+			    && (sector->GetDistanceToBase() < 2)
+				&& ai->GetAICallback()->GetUnitTeam(spot->extractorUnitId.id) == ai->GetMyTeamId())	// only upgrade own extractors
 			{
-				if(    spot->extractorDefId.IsValid() 
-				    && spot->extractorUnitId.IsValid()
-					&& ai->GetAICallback()->GetUnitTeam(spot->extractorUnitId.id) == ai->GetMyTeamId())	// only upgrade own extractors
-				{
-					const bool isLand = ai->s_buildTree.GetMovementType( spot->extractorDefId ).IsStaticLand();
+				const bool isLand = ai->s_buildTree.GetMovementType( spot->extractorDefId ).IsStaticLand();
 
-					const float extractedMetalGain =  (isLand ? landExtractedMetal : seaExtractedMetal) 
-													- ai->s_buildTree.GetMaxRange( spot->extractorDefId );
+				const float extractedMetalGain =  (isLand ? landExtractedMetal : seaExtractedMetal) 
+												- ai->s_buildTree.GetMaxRange( spot->extractorDefId );
 
-					if( (extractedMetalGain > 0.0001f) && (extractedMetalGain > maxExtractedMetalGain) )
-					{
-						maxExtractedMetalGain = extractedMetalGain;
-						selectedMetalSpot     = spot;
-					}
+				if( (extractedMetalGain > 0.0001f) && (extractedMetalGain > maxExtractedMetalGain) )
+				{
+					maxExtractedMetalGain = extractedMetalGain;
+					selectedMetalSpot     = spot;
 				}
 			}
 		}
@@ -1798,7 +1901,7 @@ void AAIExecute::CheckConstruction()
 	float highestUrgency(0.5f);		// min urgency (prevents aai from building things it doesnt really need that much)
 	AAIUnitCategory buildingCategory;
 
-	std::set< std::pair<int, float>, CompareConstructionUrgency> categoriesToBeChecked;
+	AAIFrameSet< std::pair<int, float>, CompareConstructionUrgency> categoriesToBeChecked( CompareConstructionUrgency(), AAIFrameAllocator< std::pair<int, float> >(ai->FrameArena()) );
 
 	// ----------------------------------------------------------------------------------------------------------------
 	// determine category with highest urgency
@@ -0,0 +1,88 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#include "AAIFileWriter.h"
+
+#include <cstdarg>
+#include <cstdio>
+
+#ifdef _WIN32
+	#include <io.h>
+	#include <windows.h>
+#else
+	#include <unistd.h>
+#endif
+
+void AAITextBuffer::Printf(const char* format, ...)
+{
+	char buffer[256];
+
+	va_list args;
+	va_start(args, format);
+	const int length = vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+
+	if(length < 0)
+		return;
+
+	if(length < static_cast<int>(sizeof(buffer)))
+	{
+		m_text.append(buffer, length);
+	}
+	else
+	{
+		// text does not fit into local buffer -> format again directly into the text
+		const size_t oldSize = m_text.size();
+		m_text.resize(oldSize + length + 1);
+
+		va_start(args, format);
+		vsnprintf(&m_text[oldSize], length + 1, format, args);
+		va_end(args);
+
+		m_text.resize(oldSize + length);
+	}
+}
+
+bool AAIFileWriter::WriteFileAtomically(const std::string& filename, const std::string& content)
+{
+	const std::string temporaryFilename = filename + ".tmp";
+
+	FILE* file = fopen(temporaryFilename.c_str(), "wb");
+
+	if(file == nullptr)
+		return false;
+
+	bool success = content.empty() || (fwrite(content.data(), content.size(), 1, file) == 1);
+
+	success = (fflush(file) == 0) && success;
+
+	// make sure data are on disk before replacing the old file
+#ifdef _WIN32
+	success = (_commit(_fileno(file)) == 0) && success;
+#else
+	success = (fsync(fileno(file)) == 0) && success;
+#endif
+
+	success = (fclose(file) == 0) && success;
+
+	if(success)
+	{
+#ifdef _WIN32
+		// rename() does not replace existing files on windows
+		success = (MoveFileExA(temporaryFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0);
+#else
+		success = (rename(temporaryFilename.c_str(), filename.c_str()) == 0);
+#endif
+	}
+
+	if(success == false)
+		remove(temporaryFilename.c_str());
+
+	return success;
+}
@@ -0,0 +1,38 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#ifndef AAI_FILEWRITER_H
+#define AAI_FILEWRITER_H
+
+#include <string>
+
+//! Collects formatted text in memory (e.g. the content of a learn file that shall be written by AAIFileWriter)
+class AAITextBuffer
+{
+public:
+	//! @brief Appends the given printf-style formatted text
+	void Printf(const char* format, ...);
+
+	//! @brief Returns the collected text
+	const std::string& GetText() const { return m_text; }
+
+private:
+	std::string m_text;
+};
+
+//! Writes files such that an existing file is either kept or replaced completely: the content is written to a temporary file first
+//! which is flushed to disk and renamed afterwards.
+class AAIFileWriter
+{
+public:
+	//! @brief Writes the given content to the given file (returns whether successful)
+	static bool WriteFileAtomically(const std::string& filename, const std::string& content);
+};
+
+#endif
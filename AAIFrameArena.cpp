@@ -0,0 +1,76 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#include <algorithm>
+
+#include "AAIFrameArena.h"
+
+AAIFrameArena::AAIFrameArena(size_t blockSize) :
+	m_blockSize(blockSize),
+	m_currentBlock(0),
+	m_offset(0)
+{
+	AddBlock(m_blockSize);
+}
+
+AAIFrameArena::~AAIFrameArena()
+{
+	for(auto& block : m_blocks)
+		delete[] block.data;
+}
+
+void* AAIFrameArena::Allocate(size_t bytes, size_t alignment)
+{
+	while(true)
+	{
+		const Block& block = m_blocks[m_currentBlock];
+
+		const size_t alignedOffset = (m_offset + alignment - 1) & ~(alignment - 1);
+
+		if(alignedOffset + bytes <= block.size)
+		{
+			m_offset = alignedOffset + bytes;
+			return block.data + alignedOffset;
+		}
+
+		// continue with next block (blocks that are too small for the request are skipped)
+		++m_currentBlock;
+		m_offset = 0;
+
+		if(m_currentBlock == m_blocks.size())
+			AddBlock(bytes + alignment);
+	}
+}
+
+void AAIFrameArena::Reset()
+{
+	// replace multiple blocks by a single one large enough to serve the same requests without the need for further blocks
+	if(m_blocks.size() > 1)
+	{
+		size_t totalSize(0);
+
+		for(auto& block : m_blocks)
+		{
+			totalSize += block.size;
+			delete[] block.data;
+		}
+
+		m_blocks.clear();
+		AddBlock(totalSize);
+	}
+
+	m_currentBlock = 0;
+	m_offset       = 0;
+}
+
+void AAIFrameArena::AddBlock(size_t minSize)
+{
+	const size_t size = std::max(minSize, m_blockSize);
+	m_blocks.push_back( Block(new char[size], size) );
+}
@@ -0,0 +1,101 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#ifndef AAI_FRAMEARENA_H
+#define AAI_FRAMEARENA_H
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <set>
+#include <vector>
+
+//! Monotonic memory arena for transient containers used during one update of AAI. Memory is taken consecutively from large blocks
+//! and never freed individually; Reset() (called at the end of every update) makes all memory available again. The blocks are
+//! kept, i.e. the global allocator is only called if more memory is needed within one update than ever before.
+class AAIFrameArena
+{
+public:
+	AAIFrameArena(size_t blockSize);
+
+	~AAIFrameArena();
+
+	//! @brief Returns memory of the given size and alignment (valid until next call of Reset())
+	void* Allocate(size_t bytes, size_t alignment);
+
+	//! @brief Releases all memory allocated since the last reset (blocks are merged if more than one has been used)
+	void Reset();
+
+private:
+	AAIFrameArena(const AAIFrameArena&) = delete;
+	AAIFrameArena& operator=(const AAIFrameArena&) = delete;
+
+	struct Block
+	{
+		Block(char* data, size_t size) : data(data), size(size) {}
+
+		char*  data;
+		size_t size;
+	};
+
+	//! @brief Adds a new block with at least the given size
+	void AddBlock(size_t minSize);
+
+	//! Size of newly added blocks
+	size_t             m_blockSize;
+
+	//! The blocks memory is taken from
+	std::vector<Block> m_blocks;
+
+	//! Index of the block memory is currently taken from
+	size_t             m_currentBlock;
+
+	//! Offset (in bytes) of the first unused byte within the current block
+	size_t             m_offset;
+};
+
+//! Allocator (usable with std containers) taking memory from a frame arena. Deallocation does nothing, memory is released by the arena.
+template<typename T>
+class AAIFrameAllocator
+{
+public:
+	typedef T value_type;
+
+	AAIFrameAllocator(AAIFrameArena* arena) : m_arena(arena) {}
+
+	template<typename U>
+	AAIFrameAllocator(const AAIFrameAllocator<U>& other) : m_arena(other.GetArena()) {}
+
+	T* allocate(size_t n) { return static_cast<T*>(m_arena->Allocate(n * sizeof(T), alignof(T))); }
+
+	void deallocate(T* /*p*/, size_t /*n*/) {}
+
+	AAIFrameArena* GetArena() const { return m_arena; }
+
+private:
+	AAIFrameArena* m_arena;
+};
+
+template<typename T, typename U>
+bool operator==(const AAIFrameAllocator<T>& lhs, const AAIFrameAllocator<U>& rhs) { return lhs.GetArena() == rhs.GetArena(); }
+
+template<typename T, typename U>
+bool operator!=(const AAIFrameAllocator<T>& lhs, const AAIFrameAllocator<U>& rhs) { return lhs.GetArena() != rhs.GetArena(); }
+
+//! Containers whose memory is taken from a frame arena (must not be used after the end of the update they have been created in)
+template<typename T>
+using AAIFrameVector = std::vector<T, AAIFrameAllocator<T>>;
+
+template<typename T>
+using AAIFrameList = std::list<T, AAIFrameAllocator<T>>;
+
+template<typename T, typename Compare = std::less<T>>
+using AAIFrameSet = std::set<T, Compare, AAIFrameAllocator<T>>;
+
+#endif
@@ -0,0 +1,37 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#include "AAIFriendlyUnitRegistry.h"
+
+void AAIFriendlyUnitRegistry::Add(UnitId unitId, const FriendlyUnitInfo& friendlyUnit)
+{
+	if(IsTracked(unitId))
+		Remove(unitId);
+
+	m_friendlyUnits[unitId.id] = friendlyUnit;
+	m_friendlyUnits[unitId.id].trackedUnitsListIndex = static_cast<int>(m_trackedUnits.size());
+	m_trackedUnits.push_back(unitId);
+}
+
+void AAIFriendlyUnitRegistry::Remove(UnitId unitId)
+{
+	const int listIndex = m_friendlyUnits[unitId.id].trackedUnitsListIndex;
+
+	if(listIndex < 0)
+		return;
+
+	// move last element to position of removed one
+	const UnitId lastUnitId = m_trackedUnits.back();
+
+	m_trackedUnits[listIndex] = lastUnitId;
+	m_friendlyUnits[lastUnitId.id].trackedUnitsListIndex = listIndex;
+	m_trackedUnits.pop_back();
+
+	m_friendlyUnits[unitId.id] = FriendlyUnitInfo();
+}
@@ -0,0 +1,90 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#ifndef AAI_FRIENDLYUNITREGISTRY_H
+#define AAI_FRIENDLYUNITREGISTRY_H
+
+#include <vector>
+
+#include "aidef.h"
+#include "AAITypes.h"
+
+//! Information about an own or allied unit whose combat power/building is accounted for in the sector it is located in
+struct FriendlyUnitInfo
+{
+	FriendlyUnitInfo() :
+		gridIndex(-1),
+		trackedUnitsListIndex(-1),
+		lastUpdateFrame(0),
+		ownUnit(false),
+		isStatic(false),
+		alliedBuilding(false),
+		hasCombatPower(false)
+	{}
+
+	UnitDefId        unitDefId;
+
+	//! Combat power added to the sector the unit is located in
+	TargetTypeValues combatPower;
+
+	//! Index of the sector (within the sector grid) the unit is accounted for (-1 if none)
+	int              gridIndex;
+
+	//! Position in the list of tracked units (-1 if not tracked)
+	int              trackedUnitsListIndex;
+
+	//! Frame when unit has been reported by the engine the last time (used to detect allied units that no longer exist)
+	int              lastUpdateFrame;
+
+	//! True for units of this AAI instance (added/removed via unit finished/destroyed events), false for allied units
+	bool             ownUnit;
+
+	//! True if unit is a building (i.e. cannot move to another sector)
+	bool             isStatic;
+
+	//! True if unit is counted as allied building
+	bool             alliedBuilding;
+
+	//! True if combat power of unit is accounted for
+	bool             hasCombatPower;
+};
+
+//! Keeps track of own and allied units in order to update the friendly combat power and allied buildings of the sectors by delta
+class AAIFriendlyUnitRegistry
+{
+public:
+	//! @brief Initializes data for all possible unit ids
+	void Init(int maxUnits) { m_friendlyUnits.assign(maxUnits, FriendlyUnitInfo()); m_trackedUnits.clear(); }
+
+	//! @brief Returns true if given unit id may be stored in the registry
+	bool IsValid(UnitId unitId) const { return (unitId.id >= 0) && (unitId.id < static_cast<int>(m_friendlyUnits.size())); }
+
+	//! @brief Returns true if given unit is currently tracked
+	bool IsTracked(UnitId unitId) const { return (m_friendlyUnits[unitId.id].trackedUnitsListIndex >= 0); }
+
+	FriendlyUnitInfo& GetFriendlyUnit(UnitId unitId) { return m_friendlyUnits[unitId.id]; }
+
+	//! @brief Adds the given unit to the list of tracked units
+	void Add(UnitId unitId, const FriendlyUnitInfo& friendlyUnit);
+
+	//! @brief Removes the given unit from the list of tracked units
+	void Remove(UnitId unitId);
+
+	//! @brief Returns all tracked units
+	const std::vector<UnitId>& GetTrackedUnits() const { return m_trackedUnits; }
+
+private:
+	//! Information about every friendly unit (indexed by unit id)
+	std::vector<FriendlyUnitInfo> m_friendlyUnits;
+
+	//! Ids of all tracked units
+	std::vector<UnitId>           m_trackedUnits;
+};
+
+#endif
@@ -20,6 +20,7 @@
 #include "AAIMap.h"
 #include "AAISector.h"
 #include "AAIBrain.h"
+#include "AAIUnitSnapshot.h"
 
 
 #include "LegacyCpp/UnitDef.h"
@@ -244,7 +245,7 @@ float3 AAIGroup::GetGroupPosition() const
 	if(!m_units.empty())
 	{
 		std::list<UnitId>::const_iterator unit = std::prev(m_units.end());
-		return ai->GetAICallback()->GetUnitPos( (*unit).id );
+		return ai->UnitSnapshot()->GetUnitPos(*unit);
 	}
 	else
 		return ZeroVector;
@@ -338,7 +339,7 @@ void AAIGroup::DefendUnit(UnitId unitId, const float3& enemyPosition, float urge
 
 		GiveOrderToGroup(&cmd, urgency, GUARDING, "Group::Defend");
 
-		const float3 defendedUnitPosition = ai->GetAICallback()->GetUnitPos(unitId.id);
+		const float3 defendedUnitPosition = ai->UnitSnapshot()->GetUnitPos(unitId);
 
 		m_targetPosition = defendedUnitPosition;
 		m_targetSector   = ai->Map()->GetSectorOfPos(defendedUnitPosition);
@@ -487,7 +488,7 @@ void AAIGroup::UnitIdle(UnitId unitId, AAIAttackManager* attackManager)
 	if(m_attack)
 	{
 		//check if idle unit is in target sector
-		const float3 pos = ai->GetAICallback()->GetUnitPos(unitId.id);
+		const float3 pos = ai->UnitSnapshot()->GetUnitPos(unitId);
 		const AAISector *sector = ai->Map()->GetSectorOfPos(pos);
 
 		if( (sector == m_targetSector) || (m_targetSector == nullptr) )
@@ -537,7 +538,7 @@ void AAIGroup::UnitIdle(UnitId unitId, AAIAttackManager* attackManager)
 	else if( (m_task == GROUP_RETREATING) || (m_task == GROUP_DEFENDING) ) 
 	{
 		//check if retreating units is in target sector
-		const float3 pos = ai->GetAICallback()->GetUnitPos(unitId.id);
+		const float3 pos = ai->UnitSnapshot()->GetUnitPos(unitId);
 
 		const AAISector* temp = ai->Map()->GetSectorOfPos(pos);
 
@@ -14,11 +14,20 @@
 #include "AAIConfig.h"
 #include "AAISector.h"
 #include "AAIUnitTable.h"
+#include "AAICacheFile.h"
+#include "AAIUnitSnapshot.h"
+#include "AAIFileWriter.h"
 
 #include "System/SafeUtil.h"
 #include "LegacyCpp/UnitDef.h"
 
 #include <inttypes.h>
+#include <cstdlib>
+#include <limits>
+#include <algorithm>
+#include <numeric>
+#include <queue>
+#include <thread>
 
 using namespace springLegacyAI;
 
@@ -42,7 +51,7 @@ int AAIMap::xSectorSizeMap;
 int AAIMap::ySectorSizeMap;
 
 bool AAIMap::s_isMetalMap;
-std::list<AAIMetalSpot>  AAIMap::metal_spots;
+AAIMetalSpotMap          AAIMap::s_metalSpots;
 int AAIMap::s_metalSpotsOnLand;
 int AAIMap::s_metalSpotsInSea;
 
@@ -54,6 +63,7 @@ AAIDefenceMaps                AAIMap::s_defenceMaps;
 AAIMapType                    AAIMap::s_mapType;
 AAITeamSectorMap              AAIMap::s_teamSectorMap;
 std::vector<BuildMapTileType> AAIMap::s_buildmap;
+AAIBuildMapBitPlanes          AAIMap::s_buildMapBitPlanes;
 std::vector<int>              AAIMap::blockmap;
 std::vector<float>            AAIMap::plateau_map;
 
@@ -61,15 +71,24 @@ std::vector<AAIContinent>     AAIMap::s_continents;
 StatisticalData               AAIMap::s_landContinentSizeStatistics;
 StatisticalData               AAIMap::s_seaContinentSizeStatistics;
 
+int                           AAIMap::s_mapDataUsers = 0;
+
 AAIMap::AAIMap(AAI *ai, int xMapSize, int yMapSize, int losMapResolution) :
 	ai(ai),
 	m_unitsInLOS(cfg->MAX_UNITS, 0),
 	m_scoutedEnemyUnitsMap(xMapSize, yMapSize, losMapResolution),
 	m_centerOfEnemyBase(xMapSize/2 , yMapSize/2),
-	m_lastLOSUpdateInFrame(0)
+	m_lastLOSUpdateInFrame(0),
+	m_friendlyUnitsUpdates(0),
+	m_nextSectorRowToUpdate(0),
+	m_scoutedEnemyBuildings(0),
+	m_sectorLocationOfEnemyBuildings(0, 0)
 {
-	// all static vars are only initialized by the first AAI instance
-	if(ai->GetAAIInstance() == 1)
+	m_enemyUnits.Init(cfg->MAX_UNITS);
+	m_friendlyUnits.Init(cfg->MAX_UNITS);
+
+	// all static vars are only initialized by the first AAI instance that uses them (remain unchanged until last user is deleted)
+	if(s_mapDataUsers == 0)
 	{
 		this->xMapSize = xMapSize;
 		this->yMapSize = yMapSize;
@@ -97,8 +116,9 @@ AAIMap::AAIMap(AAI *ai, int xMapSize, int yMapSize, int losMapResolution) :
 		ySectorSize = ySectorSizeMap * SQUARE_SIZE;
 
 		s_buildmap.resize(xMapSize*yMapSize);
+		s_buildMapBitPlanes.Init(xMapSize, yMapSize);
 		blockmap.resize(xMapSize*yMapSize, 0);
-		plateau_map.resize(xMapSize/4*xMapSize/4, 0.0f);
+		plateau_map.resize((xMapSize/4)*(yMapSize/4), 0.0f);
 
 		s_teamSectorMap.Init(xSectors, ySectors);
 
@@ -106,24 +126,31 @@ AAIMap::AAIMap(AAI *ai, int xMapSize, int yMapSize, int losMapResolution) :
 
 		s_continentMap.Init(xMapSize, yMapSize);
 
-		InitContinents();
+		const uint64_t mapHash = CalculateMapHash();
 
-		ReadMapCacheFile();
+		InitContinents(mapHash);
+
+		ReadMapCacheFile(mapHash);
 	}
 
+	++s_mapDataUsers;
+
 	ai->Log("Map size: %i x %i    LOS map size: %i x %i  (los res: %i)\n", xMapSize, yMapSize, xLOSMapSize, yLOSMapSize, losMapResolution);
 
+	m_scoutedEnemyUnitsMap.InitSectorLookupTables(xSectors, ySectors, xSectorSizeMap, ySectorSizeMap);
+
+	m_sectorGrid.Init(xSectors, ySectors);
 	m_sectorMap.resize(xSectors, std::vector<AAISector>(ySectors));
 
 	for(int x = 0; x < xSectors; ++x)
 	{
 		for(int y = 0; y < ySectors; ++y)
 			// provide ai callback to sectors & set coordinates of the sectors
-			m_sectorMap[x][y].Init(ai, x, y);
+			m_sectorMap[x][y].Init(ai, x, y, &m_sectorGrid);
 	}
 
 	// add metalspots to their sectors
-	for(auto& spot : metal_spots)
+	for(auto& spot : s_metalSpots.GetSpots())
 	{
 		AAISector* sector = GetSectorOfPos(spot.pos);
 
@@ -145,7 +172,7 @@ AAIMap::AAIMap(AAI *ai, int xMapSize, int yMapSize, int losMapResolution) :
 	ai->Log("%i sectors in y direction\n", ySectors);
 	ai->Log("x-sectorsize is %i (Map %i)\n", xSectorSize, xSectorSizeMap);
 	ai->Log("y-sectorsize is %i (Map %i)\n", ySectorSize, ySectorSizeMap);
-	ai->Log( _STPF_ " metal spots found (%i are on land, %i under water) \n \n", metal_spots.size(), s_metalSpotsOnLand, s_metalSpotsInSea);
+	ai->Log( _STPF_ " metal spots found (%i are on land, %i under water) \n \n", s_metalSpots.GetSpots().size(), s_metalSpotsOnLand, s_metalSpotsInSea);
 	ai->Log( _STPF_ " continents found on map\n", s_continents.size());
 	ai->Log("%u land and %u water continents\n", s_landContinentSizeStatistics.GetSampleSize(), s_seaContinentSizeStatistics.GetSampleSize());
 	ai->Log("Average land continent size is %f\n", s_landContinentSizeStatistics.GetAvgValue());
@@ -174,218 +201,288 @@ AAIMap::~AAIMap(void)
 {
 	UpdateLearningData();
 
-	// delete common data only if last AAI instance is deleted
-	if(ai->GetNumberOfAAIInstances() == 0)
+	--s_mapDataUsers;
+
+	// save learning data and delete common data only if last user of the map data is deleted
+	if(s_mapDataUsers == 0)
 	{
 		ai->Log("Saving map learn file\n");
 
 		const std::string mapLearningDataFilename = LocateMapLearnFile();
 
 		// save map data
-		FILE *file = fopen(mapLearningDataFilename.c_str(), "w+");
+		AAITextBuffer buffer;
 
-		fprintf(file, "%s\n", MAP_LEARN_VERSION);
+		buffer.Printf("%s\n", MAP_LEARN_VERSION);
 
 		for(int y = 0; y < ySectors; ++y)
 		{
 			for(int x = 0; x < xSectors; ++x)
-				m_sectorMap[x][y].SaveDataToFile(file);
+				m_sectorMap[x][y].SaveDataToBuffer(buffer);
 
-			fprintf(file, "\n");
+			buffer.Printf("\n");
 		}
 
-		fclose(file);
+		if(AAIFileWriter::WriteFileAtomically(mapLearningDataFilename, buffer.GetText()) == false)
+			ai->Log("Error: Writing file %s failed\n", mapLearningDataFilename.c_str());
 
-		s_buildmap.clear();
-		blockmap.clear();
-		plateau_map.clear();
+		ReleaseSharedMapData();
 	}
 
 	m_unitsInLOS.clear();
 }
 
-void AAIMap::ReadMapCacheFile()
+void AAIMap::ReleaseSharedMapData()
 {
-	// try to read cache file
-	bool loaded = false;
+	// reset all data (not only free memory) to ensure a clean initialization if AAI instances are created again within the same process
+	s_buildmap.clear();
+	s_buildMapBitPlanes = AAIBuildMapBitPlanes();
+	blockmap.clear();
+	plateau_map.clear();
+
+	s_metalSpots = AAIMetalSpotMap();
+	s_metalSpotsOnLand = 0;
+	s_metalSpotsInSea  = 0;
+
+	s_continentMap = AAIContinentMap();
+	s_continents.clear();
+	s_landContinentSizeStatistics = StatisticalData();
+	s_seaContinentSizeStatistics  = StatisticalData();
+
+	s_defenceMaps   = AAIDefenceMaps();
+	s_teamSectorMap = AAITeamSectorMap();
+	s_mapType       = AAIMapType();
+}
 
-	const size_t buffer_sizeMax = 512;
-	char buffer[buffer_sizeMax];
+uint64_t AAIMap::CalculateMapHash() const
+{
+	const float*         heightMap = ai->GetAICallback()->GetHeightMap();
+	const unsigned char* metalMap  = ai->GetAICallback()->GetMetalMap();
 
-	const std::string mapCache_filename = LocateMapCacheFile();
+	uint64_t hash = AAICalculateHash(heightMap, sizeof(float) * xMapSize * yMapSize);
+	return AAICalculateHash(metalMap, (xMapSize/2) * (yMapSize/2), hash);
+}
 
-	FILE *file;
+void AAIMap::ReadMapCacheFile(uint64_t mapHash)
+{
+	// try to read binary cache file
+	const std::string mapCacheFilename = LocateMapCacheFile(true);
+	bool loaded = ReadBinaryMapCacheFile(mapCacheFilename, mapHash);
 
-	if((file = fopen(mapCache_filename.c_str(), "r")) != NULL)
+	// convert cache file of previous (text based) format if available
+	if(!loaded)
 	{
-		// check if correct version
-		fscanf(file, "%s ", buffer);
+		loaded = ReadTextMapCacheFile(LocateMapCacheFile(false));
 
-		if(strcmp(buffer, MAP_CACHE_VERSION))
+		if(loaded)
 		{
-			ai->LogConsole("Mapcache out of date - creating new one");
-			fclose(file);
+			SaveMapCacheFile(mapCacheFilename, mapHash);
+			ai->Log("Map cache file converted to binary format\n");
 		}
-		else
+	}
+
+	if(!loaded)  // create new map data
+	{
+		// detect cliffs/water and create plateau map
+		AnalyseMap();
+
+		DetermineMapType();
+
+		// search for metal spots after analysis of map for cliffs/water to avoid overriding of blocked underwater metal spots (5) with water (4)
+		DetectMetalSpots();
+
+		s_metalSpotsOnLand = 0;
+		s_metalSpotsInSea = 0;
+
+		for(const auto& spot : s_metalSpots.GetSpots())
 		{
-			int temp;
-			float temp_float;
-
-			// load if its a metal map
-			fscanf(file, "%i ", &temp);
-			s_isMetalMap = (bool)temp;
-
-			// load map type
-			fscanf(file, "%s ", buffer);
-
-			if(!strcmp(buffer, "LAND_MAP"))
-				s_mapType.SetMapType(EMapType::LAND);
-			else if(!strcmp(buffer, "LAND_WATER_MAP"))
-				s_mapType.SetMapType(EMapType::LAND_WATER);
-			else if(!strcmp(buffer, "WATER_MAP"))
-				s_mapType.SetMapType(EMapType::WATER);
+			if(spot.pos.y >= 0.0f)
+				++s_metalSpotsOnLand;
 			else
-				s_mapType.SetMapType(EMapType::UNKNOWN);
+				++s_metalSpotsInSea;
+		}
 
-			// load water ratio
-			fscanf(file, "%f ", &s_waterTilesRatio);
+		// save mod independent map data
+		SaveMapCacheFile(mapCacheFilename, mapHash);
 
-			// load buildmap
-			for(int y = 0; y < yMapSize; ++y)
-			{
-				for(int x = 0; x < xMapSize; ++x)
-				{
-					unsigned int value;
-					fscanf(file, "%u", &value);
+		ai->Log("New map cache-file created\n");
+	}
 
-					const int cell = x + y * xMapSize;
-					s_buildmap[cell].m_tileType = static_cast<uint8_t>(value);
-				}
-			}
+	s_metalSpots.CreateIndex(s_continentMap, static_cast<int>(s_continents.size()), xSize, ySize);
+}
 
-			//const springLegacyAI::UnitDef* def = ai->GetAICallback()->GetUnitDef("armmine1");
+bool AAIMap::ReadBinaryMapCacheFile(const std::string& filename, uint64_t mapHash)
+{
+	AAICacheFileReader reader;
 
-			// load plateau map
-			for(int y = 0; y < yMapSize/4; ++y)
-			{
-				for(int x = 0; x < xMapSize/4; ++x)
-				{
-					const int cell = x + y * (xMapSize/4);
-					fscanf(file, "%f ", &plateau_map[cell]);
+	if(reader.ReadFromFile(filename, MAP_CACHE_VERSION, mapHash, xMapSize, yMapSize) == false)
+		return false;
 
-					/*if(	plateau_map[cell] > 0.0f)
-					{
-						float3 myPos(static_cast<float>(x*4), 0.0, static_cast<float>(y*4) );
-						BuildMapPos2Pos(&myPos, def); 
-						myPos.y = ai->GetAICallback()->GetElevation(myPos.x, myPos.z);
-						ai->GetAICallback()->DrawUnit("armmine1", myPos, 0.0f, 1000, ai->GetAICallback()->GetMyAllyTeam(), true, true);	
-					}*/
-				}
-			}
+	int32_t isMetalMap, mapType, numberOfMetalSpots;
 
-			// load metal spots
-			AAIMetalSpot spot;
-			fscanf(file, "%i ", &temp);
+	bool success =    reader.Get(isMetalMap)
+	               && reader.Get(mapType)
+	               && reader.Get(s_waterTilesRatio)
+	               && reader.GetArray(s_buildmap.data(), s_buildmap.size())
+	               && reader.GetArray(plateau_map.data(), plateau_map.size())
+	               && reader.Get(numberOfMetalSpots);
 
-			for(int i = 0; i < temp; ++i)
-			{
-				fscanf(file, "%f %f %f %f ", &(spot.pos.x), &(spot.pos.y), &(spot.pos.z), &(spot.amount));
-				spot.occupied = false;
-				metal_spots.push_back(spot);
-			}
+	// metal spots are stored as x/y/z-position & amount
+	std::vector<float> metalSpotData(success ? 4 * std::max(numberOfMetalSpots, 0) : 0);
 
-			fscanf(file, "%i %i ", &s_metalSpotsOnLand, &s_metalSpotsInSea);
+	success =    success
+	          && reader.GetArray(metalSpotData.data(), metalSpotData.size())
+	          && reader.Get(s_metalSpotsOnLand)
+	          && reader.Get(s_metalSpotsInSea)
+	          && reader.IsAtEnd();
 
-			fclose(file);
+	if(!success)
+	{
+		ai->Log("Error: Invalid content of map cache file %s\n", filename.c_str());
+		return false;
+	}
 
-			ai->Log("Map cache file successfully loaded\n");
+	s_isMetalMap = static_cast<bool>(isMetalMap);
+	s_mapType.SetMapType(static_cast<EMapType>(mapType));
 
-			loaded = true;
-		}
-	}
+	s_buildMapBitPlanes.SetFromBuildMap(s_buildmap);
 
-	if(!loaded)  // create new map data
-	{
-		// detect cliffs/water and create plateau map
-		AnalyseMap();
+	for(size_t i = 0; i < metalSpotData.size(); i += 4)
+		s_metalSpots.AddSpot( AAIMetalSpot(float3(metalSpotData[i], metalSpotData[i+1], metalSpotData[i+2]), metalSpotData[i+3]) );
 
-		DetermineMapType();
+	ai->Log("Map cache file successfully loaded\n");
 
-		// search for metal spots after analysis of map for cliffs/water to avoid overriding of blocked underwater metal spots (5) with water (4)
-		DetectMetalSpots();
+	return true;
+}
 
-		//////////////////////////////////////////////////////////////////////////////////////////////////////
-		// save mod independent map data
-		const std::string mapCache_filename = LocateMapCacheFile();
+bool AAIMap::ReadTextMapCacheFile(const std::string& filename)
+{
+	FILE* file = fopen(filename.c_str(), "r");
 
-		file = fopen(mapCache_filename.c_str(), "w+");
+	if(file == NULL)
+		return false;
 
-		fprintf(file, "%s\n", MAP_CACHE_VERSION);
+	const size_t buffer_sizeMax = 512;
+	char buffer[buffer_sizeMax];
 
-		// save if its a metal map
-		fprintf(file, "%i\n", (int)s_isMetalMap);
+	// check if correct version
+	fscanf(file, "%s ", buffer);
 
-		const char *temp_buffer = GetMapTypeString(s_mapType);
+	if(strcmp(buffer, MAP_CACHE_VERSION))
+	{
+		ai->LogConsole("Mapcache out of date - creating new one");
+		fclose(file);
+		return false;
+	}
 
-		// save map type
-		fprintf(file, "%s\n", temp_buffer);
+	int temp;
 
-		// save water ratio
-		fprintf(file, "%f\n", s_waterTilesRatio);
+	// load if its a metal map
+	fscanf(file, "%i ", &temp);
+	s_isMetalMap = (bool)temp;
 
-		// save buildmap
-		for(int y = 0; y < yMapSize; ++y)
+	// load map type
+	fscanf(file, "%s ", buffer);
+
+	if(!strcmp(buffer, "LAND_MAP"))
+		s_mapType.SetMapType(EMapType::LAND);
+	else if(!strcmp(buffer, "LAND_WATER_MAP"))
+		s_mapType.SetMapType(EMapType::LAND_WATER);
+	else if(!strcmp(buffer, "WATER_MAP"))
+		s_mapType.SetMapType(EMapType::WATER);
+	else
+		s_mapType.SetMapType(EMapType::UNKNOWN);
+
+	// load water ratio
+	fscanf(file, "%f ", &s_waterTilesRatio);
+
+	// load buildmap
+	for(int y = 0; y < yMapSize; ++y)
+	{
+		for(int x = 0; x < xMapSize; ++x)
 		{
-			for(int x = 0; x < xMapSize; ++x)
-			{
-				const int cell = x + y * xMapSize;
-				fprintf(file, "%u ", s_buildmap[cell].m_tileType);
-			}
-			fprintf(file, "\n");
+			unsigned int value;
+			fscanf(file, "%u", &value);
+
+			const int cell = x + y * xMapSize;
+			s_buildmap[cell].m_tileType = static_cast<uint8_t>(value);
 		}
+	}
 
-		// save plateau map
-		for(int y = 0; y < yMapSize/4; ++y)
+	s_buildMapBitPlanes.SetFromBuildMap(s_buildmap);
+
+	// load plateau map
+	for(int y = 0; y < yMapSize/4; ++y)
+	{
+		for(int x = 0; x < xMapSize/4; ++x)
 		{
-			for(int x = 0; x < xMapSize/4; ++x)
-			{
-				const int cell = x + y * (xMapSize/4);
-				fprintf(file, "%f ", plateau_map[cell]);
-			}
-			fprintf(file, "\n");
+			const int cell = x + y * (xMapSize/4);
+			fscanf(file, "%f ", &plateau_map[cell]);
 		}
-			
-		// save mex spots
-		s_metalSpotsOnLand = 0;
-		s_metalSpotsInSea = 0;
+	}
 
-		fprintf(file, "%u\n", static_cast<unsigned int>(metal_spots.size()) );
+	// load metal spots
+	AAIMetalSpot spot;
+	fscanf(file, "%i ", &temp);
 
-		for(std::list<AAIMetalSpot>::iterator spot = metal_spots.begin(); spot != metal_spots.end(); ++spot)
-		{
-			fprintf(file, "%f %f %f %f \n", spot->pos.x, spot->pos.y, spot->pos.z, spot->amount);
+	for(int i = 0; i < temp; ++i)
+	{
+		fscanf(file, "%f %f %f %f ", &(spot.pos.x), &(spot.pos.y), &(spot.pos.z), &(spot.amount));
+		spot.occupied = false;
+		s_metalSpots.AddSpot(spot);
+	}
 
-			if(spot->pos.y >= 0.0f)
-				++s_metalSpotsOnLand;
-			else
-				++s_metalSpotsInSea;
-		}
+	fscanf(file, "%i %i ", &s_metalSpotsOnLand, &s_metalSpotsInSea);
 
-		fprintf(file, "%i %i\n", s_metalSpotsOnLand, s_metalSpotsInSea);
+	fclose(file);
 
-		fclose(file);
+	ai->Log("Map cache file successfully loaded\n");
 
-		ai->Log("New map cache-file created\n");
+	return true;
+}
+
+void AAIMap::SaveMapCacheFile(const std::string& filename, uint64_t mapHash) const
+{
+	AAICacheFileWriter writer;
+
+	writer.Add( static_cast<int32_t>(s_isMetalMap) );
+	writer.Add( static_cast<int32_t>(s_mapType.GetArrayIndex()) );
+	writer.Add( s_waterTilesRatio );
+	writer.AddArray(s_buildmap.data(), s_buildmap.size());
+	writer.AddArray(plateau_map.data(), plateau_map.size());
+
+	writer.Add( static_cast<int32_t>(s_metalSpots.GetNumberOfSpots()) );
+
+	for(const auto& spot : s_metalSpots.GetSpots())
+	{
+		const float spotData[4] = {spot.pos.x, spot.pos.y, spot.pos.z, spot.amount};
+		writer.AddArray(spotData, 4);
 	}
+
+	writer.Add( static_cast<int32_t>(s_metalSpotsOnLand) );
+	writer.Add( static_cast<int32_t>(s_metalSpotsInSea) );
+
+	if(writer.WriteToFile(filename, MAP_CACHE_VERSION, mapHash, xMapSize, yMapSize) == false)
+		ai->Log("Error: Could not write map cache file %s\n", filename.c_str());
 }
 
-void AAIMap::InitContinents()
+void AAIMap::InitContinents(uint64_t mapHash)
 {
 	//-----------------------------------------------------------------------------------------------------------------
-	// try to load continent data from cache file
+	// try to load continent data from cache file (convert cache file of previous text based format if available)
 	//-----------------------------------------------------------------------------------------------------------------
-	const std::string continentsCachefilename = cfg->GetFileName(ai->GetAICallback(), cfg->GetUniqueName(ai->GetAICallback(), true, false, true, false), MAP_CACHE_PATH, "_continent.dat", true);
-	const bool continentsLoadedFromCache = ReadContinentFile(continentsCachefilename);
+	const std::string continentsCacheBaseName = cfg->GetUniqueName(ai->GetAICallback(), true, false, true, false);
+	const std::string continentsCachefilename = cfg->GetFileName(ai->GetAICallback(), continentsCacheBaseName, MAP_CACHE_PATH, "_continent.bin", true);
+
+	bool continentsLoadedFromCache = ReadBinaryContinentFile(continentsCachefilename, mapHash);
+
+	if(continentsLoadedFromCache == false)
+	{
+		continentsLoadedFromCache = ReadContinentFile( cfg->GetFileName(ai->GetAICallback(), continentsCacheBaseName, MAP_CACHE_PATH, "_continent.dat", true) );
+
+		if(continentsLoadedFromCache)
+			SaveContinentFile(continentsCachefilename, mapHash);
+	}
 
 	//-----------------------------------------------------------------------------------------------------------------
 	// create new continent data and store them to cache file if loading failed
@@ -397,20 +494,7 @@ void AAIMap::InitContinents()
 		s_continentMap.DetectContinents(s_continents, heightMap, xMapSize, yMapSize);
 
 		// store results to cache file
-		FILE* file = fopen(continentsCachefilename.c_str(), "w+");
-
-		fprintf(file, "%s\n",  CONTINENT_DATA_VERSION);
-
-		// save continent map
-		s_continentMap.SaveToFile(file);
-
-		// save continents
-		fprintf(file, "\n%i\n", static_cast<int>(s_continents.size()) );
-
-		for(size_t c = 0; c < s_continents.size(); ++c)
-			fprintf(file, "%i %i\n", s_continents[c].size, static_cast<int>(s_continents[c].water) );
-
-		fclose(file);
+		SaveContinentFile(continentsCachefilename, mapHash);
 	}
 
 	//-----------------------------------------------------------------------------------------------------------------
@@ -429,6 +513,56 @@ void AAIMap::InitContinents()
 	s_seaContinentSizeStatistics.Finalize();
 }
 
+bool AAIMap::ReadBinaryContinentFile(const std::string& filename, uint64_t mapHash)
+{
+	AAICacheFileReader reader;
+
+	if(reader.ReadFromFile(filename, CONTINENT_DATA_VERSION, mapHash, xMapSize, yMapSize) == false)
+		return false;
+
+	int32_t numberOfContinents(0);
+
+	bool success = s_continentMap.LoadFromCacheFile(reader) && reader.Get(numberOfContinents);
+
+	// continents are stored as size & water flag
+	std::vector<int32_t> continentData(success ? 2 * std::max(numberOfContinents, 0) : 0);
+
+	success = success && reader.GetArray(continentData.data(), continentData.size()) && reader.IsAtEnd();
+
+	if(!success)
+	{
+		ai->Log("Error: Invalid content of continent cache file %s\n", filename.c_str());
+		return false;
+	}
+
+	s_continents.clear();
+
+	for(int i = 0; i < numberOfContinents; ++i)
+		s_continents.push_back( AAIContinent(i, continentData[2*i], static_cast<bool>(continentData[2*i+1])) );
+
+	ai->Log("Continent cache file successfully loaded\n");
+
+	return true;
+}
+
+void AAIMap::SaveContinentFile(const std::string& filename, uint64_t mapHash) const
+{
+	AAICacheFileWriter writer;
+
+	s_continentMap.SaveToCacheFile(writer);
+
+	writer.Add( static_cast<int32_t>(s_continents.size()) );
+
+	for(const auto& continent : s_continents)
+	{
+		const int32_t continentData[2] = {continent.size, static_cast<int32_t>(continent.water)};
+		writer.AddArray(continentData, 2);
+	}
+
+	if(writer.WriteToFile(filename, CONTINENT_DATA_VERSION, mapHash, xMapSize, yMapSize) == false)
+		ai->Log("Error: Could not write continent cache file %s\n", filename.c_str());
+}
+
 bool AAIMap::ReadContinentFile(const std::string& filename)
 {
 	FILE* file = fopen(filename.c_str(), "r");
@@ -482,9 +616,9 @@ std::string AAIMap::LocateMapLearnFile() const
 	return cfg->GetFileName(ai->GetAICallback(), cfg->GetUniqueName(ai->GetAICallback(), true, true, true, true), MAP_LEARN_PATH, "_maplearn.dat", true);
 }
 
-std::string AAIMap::LocateMapCacheFile() const
+std::string AAIMap::LocateMapCacheFile(bool binaryFormat) const
 {
-	return cfg->GetFileName(ai->GetAICallback(), cfg->GetUniqueName(ai->GetAICallback(), false, false, true, true), MAP_LEARN_PATH, "_mapcache.dat", true);
+	return cfg->GetFileName(ai->GetAICallback(), cfg->GetUniqueName(ai->GetAICallback(), false, false, true, true), MAP_LEARN_PATH, binaryFormat ? "_mapcache.bin" : "_mapcache.dat", true);
 }
 
 void AAIMap::ReadMapLearnFile()
@@ -572,7 +706,7 @@ void AAIMap::UpdateLearningData()
 bool AAIMap::IsSectorBorderToBase(int x, int y) const
 {
 	return     (m_sectorMap[x][y].m_distanceToBase > 0) 
-			&& (m_sectorMap[x][y].m_alliedBuildings < 5) 
+			&& (m_sectorMap[x][y].GetNumberOfAlliedBuildings() < 5) 
 			&& (s_teamSectorMap.IsOccupiedByTeam(SectorIndex(x,y), ai->GetMyTeamId()) == false);
 }
 
@@ -662,6 +796,8 @@ void AAIMap::ChangeBuildMapOccupation(int xPos, int yPos, int xSize, int ySize,
 			else
 				s_buildmap[x+y*xMapSize].FreeTile();
 
+			s_buildMapBitPlanes.UpdateTile(x, y, s_buildmap[x+y*xMapSize]);
+
 			// debug
 			/*if(x%2 == 0 && y%2 == 0)
 			{
@@ -774,7 +910,7 @@ BuildSite AAIMap::DetermineElevatedBuildsite(UnitDefId buildingDefId, int xStart
 
 	const float maxEdgeDistance = 0.5f * static_cast<float>( std::min(AAIMap::xMapSize, AAIMap::yMapSize));
 
-	BuildSite bestBuildSite;
+	std::vector<BuildSiteCandidate> candidates;
 
 	for(int yPos = yStart; yPos < yEnd; yPos += 2)
 	{
@@ -797,23 +933,12 @@ BuildSite AAIMap::DetermineElevatedBuildsite(UnitDefId buildingDefId, int xStart
 
 				const float rating = 0.05f * (float)(rand()%20) + 5.0f * edgeDistanceFactor + 3.0 * elevatedTerrainFactor;
 
-				if(rating > bestBuildSite.GetRating())
-				{
-					float3 possibleBuildsite = ConvertMapPosToUnitPos(mapPos, footprint);
-					ConvertPositionToFinalBuildsite(possibleBuildsite, footprint);
-
-					const springLegacyAI::UnitDef* unitDef = &ai->BuildTable()->GetUnitDef(buildingDefId.id);
-
-					if(ai->GetAICallback()->CanBuildAt(unitDef, possibleBuildsite))
-					{
-						bestBuildSite.SetBuildSite(possibleBuildsite, rating);
-					}
-				}
+				candidates.push_back( BuildSiteCandidate(mapPos, rating) );
 			}
 		}
 	}
 
-	return bestBuildSite;
+	return SelectBestRatedBuildsite(candidates, footprint, &ai->BuildTable()->GetUnitDef(buildingDefId.id));
 }
 
 float3 AAIMap::DetermineBuildsiteForStaticDefence(UnitDefId staticDefence, const AAISector* sector, const AAITargetType& targetType, float terrainModifier) const
@@ -833,93 +958,111 @@ float3 AAIMap::DetermineBuildsiteForStaticDefence(UnitDefId staticDefence, const
 	const int yStart =  index.y      * ySectorSizeMap;
 	const int yEnd   = (index.y + 1) * ySectorSizeMap;
 
+	const int xSize = xEnd - xStart;
+	const int ySize = yEnd - yStart;
+
 	//-----------------------------------------------------------------------------------------------------------------
-	// determine distances to center of base of tiles to be checked and statistcis (for calculation of rating later)
+	// precompute the parts of the rating that depend only on the column or only on the row of a tile
 	//-----------------------------------------------------------------------------------------------------------------
-	const int numberOfTilesToBeChecked = (1+(xEnd-xStart)/4) * (1+(yEnd-yStart)/4);
-	std::vector<float> distancesToBaseCenter(numberOfTilesToBeChecked);
-	StatisticalData distanceStatistics;
+	const AAIFrameAllocator<float> allocator(ai->FrameArena());
+
+	AAIFrameVector<uint8_t> freePositions(allocator);
+	s_buildMapBitPlanes.DetermineFreeBuildPositions(xStart, yStart, xSize, ySize, footprint, freePositions);
 
-	int distanceToBaseArrayIndex(0);
 	const MapPos& baseCenter = ai->Brain()->GetCenterOfBase();
 
-	for(int yPos = yStart; yPos < yEnd; yPos += 4)
+	// squared distance to center of base = squared x distance (per column) + squared y distance (per row)
+	AAIFrameVector<float> squaredXDistances(xSize, 0.0f, allocator), edgeFactorsX(xSize, 0.0f, allocator), randomValuesX(xSize, 0.0f, allocator);
+	float minSquaredXDist(std::numeric_limits<float>::max()), maxSquaredXDist(0.0f);
+
+	for(int x = 0; x < xSize; ++x)
 	{
-		for(int xPos = xStart; xPos < xEnd; xPos += 4)
-		{
-			const int dx = xPos - baseCenter.x;
-			const int dy = yPos - baseCenter.y;
-			const float squaredDist = static_cast<float>(dx*dx + dy*dy);
+		const float dx = static_cast<float>(xStart + x - baseCenter.x);
+		squaredXDistances[x] = dx * dx;
+		minSquaredXDist = std::min(minSquaredXDist, squaredXDistances[x]);
+		maxSquaredXDist = std::max(maxSquaredXDist, squaredXDistances[x]);
 
-			distancesToBaseCenter[distanceToBaseArrayIndex] = squaredDist;
-			distanceStatistics.AddValue(squaredDist);
+		// prevent aai from building defences too close to the edges of the map
+		const int xEdgeDistance = std::min(xStart + x, xMapSize - xStart - x);
+		edgeFactorsX[x] = (range > 0) ? std::min(static_cast<float>(xEdgeDistance) / static_cast<float>(range), 1.0f) : 1.0f;
 
-			++distanceToBaseArrayIndex;
-		}
+		randomValuesX[x] = 0.1f * (float)(rand()%10);
 	}
 
-	distanceStatistics.Finalize();
+	float minSquaredYDist(std::numeric_limits<float>::max()), maxSquaredYDist(0.0f);
+
+	for(int y = yStart; y < yEnd; ++y)
+	{
+		const float dy = static_cast<float>(y - baseCenter.y);
+		minSquaredYDist = std::min(minSquaredYDist, dy * dy);
+		maxSquaredYDist = std::max(maxSquaredYDist, dy * dy);
+	}
+
+	// criterion 2: distance to center of base (prefer static defences closer to base), normalized by range of distances within sector
+	const float maxSquaredDist   = maxSquaredXDist + maxSquaredYDist;
+	const float squaredDistRange = maxSquaredDist - (minSquaredXDist + minSquaredYDist);
+	const float distanceFactor   = (squaredDistRange > 0.00001f) ? 0.75f * AAIConstants::maxCombatPower / squaredDistRange : 0.0f;
 
 	//-----------------------------------------------------------------------------------------------------------------
-	// find highest rated positon with search range
+	// rate all tiles of the sector and keep the highest rated buildable ones
 	//-----------------------------------------------------------------------------------------------------------------
-	float3 buildsite(ZeroVector);
-	float highestRating(0.0f);
-	distanceToBaseArrayIndex = 0;
+	AAIFrameVector<float> cellValues(xSize, 0.0f, allocator), ratings(xSize, 0.0f, allocator);
 
-	/*FILE* file(nullptr);
-	const std::string filename = cfg->GetFileName(ai->GetAICallback(), "AAIDebug.txt", "", "", true);
-	file = fopen(filename.c_str(), "w+");
-	fprintf(file, "Base center: %i, %i\n", baseCenter.x, baseCenter.y);
-	fprintf(file, "Defence Map: Defence value / distance value / terrain value\n");*/
-	
-	for(int yPos = yStart; yPos < yEnd; yPos += 4)
+	std::vector<BuildSiteCandidate> candidates;
+	candidates.reserve(AAIConstants::maxBuildsiteCandidatesCheckedByEngine + 1);
+
+	for(int y = yStart; y < yEnd; ++y)
 	{
-		for(int xPos = xStart; xPos < xEnd; xPos += 4)
+		// defence and terrain value are stored with lower resolution -> only update if new row of cells reached
+		if( (y == yStart) || (y % 4 == 0) )
 		{
-			const MapPos mapPos(xPos, yPos);
+			const int plateauMapRow = (xMapSize/4) * (y/4);
 
-			if(CanBuildAt(mapPos, footprint))
+			for(int x = 0; x < xSize; ++x)
 			{
+				const MapPos mapPos(xStart + x, y);
+
 				// criterion 1: how well is tile already covered by existing static defences
 				const float defenceValue = 2.5f * AAIConstants::maxCombatPower / (1.0f + 0.35f * s_defenceMaps.GetValue(mapPos, targetType) );
 
-				// criterion 2: distance to center of base (prefer static defences closer to base)
-				const float distanceValue = 0.75f * AAIConstants::maxCombatPower * distanceStatistics.GetNormalizedDeviationFromMax(distancesToBaseCenter[distanceToBaseArrayIndex]);
-
 				// criterion 3: terrain (prefer defences on high ground, avoid defences close to walls of canyons/valleys)
-				const int cell = (xPos/4 + (xMapSize/4) * yPos/4);
-				const float terrainValue = std::min(AAIConstants::maxCombatPower, terrainModifier * plateau_map[cell]);
+				const float terrainValue = std::min(AAIConstants::maxCombatPower, terrainModifier * plateau_map[mapPos.x/4 + plateauMapRow]);
 
-				float rating = defenceValue + distanceValue + terrainValue + 0.2f * (float)(rand()%10);
+				cellValues[x] = defenceValue + terrainValue;
+			}
+		}
 
-				// determine minimum distance from buildpos to the edges of the map
-				const int edge_distance = GetEdgeDistance(xPos, yPos);
+		const float dy             = static_cast<float>(y - baseCenter.y);
+		const float rowDistValue   = distanceFactor * (maxSquaredDist - dy * dy);
+		const int   yEdgeDistance  = std::min(y, yMapSize - y);
+		const float edgeFactorY    = (range > 0) ? std::min(static_cast<float>(yEdgeDistance) / static_cast<float>(range), 1.0f) : 1.0f;
+		const float randomValueY   = 0.1f * (float)(rand()%10);
 
-				// prevent aai from building defences too close to the edges of the map
-				if( edge_distance < range)
-					rating *= (1.0f - (range - edge_distance) / range);
+		const float* squaredXDist = squaredXDistances.data();
+		const float* edgeFactorX  = edgeFactorsX.data();
+		const float* randomValueX = randomValuesX.data();
+		const float* cellValue    = cellValues.data();
+		float*       rating       = ratings.data();
 
-				if(rating > highestRating)
-				{
-					float3 possibleBuildsite = ConvertMapPosToUnitPos(mapPos, footprint);
-					ConvertPositionToFinalBuildsite(possibleBuildsite, footprint);
+		// branch free loop over contiguous arrays -> vectorized by the compiler
+		for(int x = 0; x < xSize; ++x)
+		{
+			const float distanceValue = rowDistValue - distanceFactor * squaredXDist[x];
+			rating[x] = (cellValue[x] + distanceValue + randomValueX[x] + randomValueY) * std::min(edgeFactorX[x], edgeFactorY);
+		}
 
-					if(ai->GetAICallback()->CanBuildAt(def, possibleBuildsite))
-					{
-						buildsite = possibleBuildsite;
-						highestRating = rating;
-					}
-				}
-			}
+		const uint8_t* freePositionsRow = &freePositions[(y - yStart) * xSize];
 
-			++distanceToBaseArrayIndex;
+		for(int x = 0; x < xSize; ++x)
+		{
+			if(freePositionsRow[x] && (rating[x] > 0.0f))
+				InsertIntoBestRatedCandidates(candidates, BuildSiteCandidate(MapPos(xStart + x, y), rating[x]), footprint, AAIConstants::maxBuildsiteCandidatesCheckedByEngine);
 		}
 	}
 
-	//fclose(file);
+	const BuildSite buildSite = SelectBestRatedBuildsite(candidates, footprint, def);
 
-	return buildsite;
+	return buildSite.IsValid() ? buildSite.Position() : ZeroVector;
 }
 
 BuildSite AAIMap::CheckIfSuitableBuildSite(const UnitFootprint& footprint, const springLegacyAI::UnitDef* unitDef, const MapPos& mapPos) const
@@ -929,7 +1072,7 @@ BuildSite AAIMap::CheckIfSuitableBuildSite(const UnitFootprint& footprint, const
 		float3 possibleBuildsite = ConvertMapPosToUnitPos(mapPos, footprint);
 		ConvertPositionToFinalBuildsite(possibleBuildsite, footprint);
 
-		if(ai->GetAICallback()->CanBuildAt(unitDef, possibleBuildsite))
+		if(CanEngineBuildAt(unitDef, possibleBuildsite))
 		{
 			const SectorIndex sector(possibleBuildsite.x/xSectorSize, possibleBuildsite.z/ySectorSize);
 
@@ -941,23 +1084,77 @@ BuildSite AAIMap::CheckIfSuitableBuildSite(const UnitFootprint& footprint, const
 	return BuildSite();
 }
 
+bool AAIMap::CanEngineBuildAt(const springLegacyAI::UnitDef* unitDef, const float3& buildsite) const
+{
+	const int frame = ai->GetAICallback()->GetCurrentFrame();
+	bool canBuild(false);
+
+	if(m_buildSiteValidationCache.GetCachedResult(unitDef->id, buildsite, frame, canBuild) == false)
+	{
+		canBuild = ai->GetAICallback()->CanBuildAt(unitDef, buildsite);
+		m_buildSiteValidationCache.AddResult(unitDef->id, buildsite, frame, canBuild);
+	}
+
+	return canBuild;
+}
+
+BuildSite AAIMap::SelectBestRatedBuildsite(std::vector<BuildSiteCandidate>& candidates, const UnitFootprint& footprint, const springLegacyAI::UnitDef* unitDef) const
+{
+	const int candidatesToCheck = std::min(static_cast<int>(candidates.size()), AAIConstants::maxBuildsiteCandidatesCheckedByEngine);
+
+	std::partial_sort(candidates.begin(), candidates.begin() + candidatesToCheck, candidates.end(), 
+						[](const BuildSiteCandidate& lhs, const BuildSiteCandidate& rhs) { return lhs.rating > rhs.rating; } );
+
+	for(int i = 0; i < candidatesToCheck; ++i)
+	{
+		float3 possibleBuildsite = ConvertMapPosToUnitPos(candidates[i].mapPos, footprint);
+		ConvertPositionToFinalBuildsite(possibleBuildsite, footprint);
+
+		if(CanEngineBuildAt(unitDef, possibleBuildsite))
+			return BuildSite(possibleBuildsite, candidates[i].rating, true);
+	}
+
+	return BuildSite();
+}
+
+void AAIMap::InsertIntoBestRatedCandidates(std::vector<BuildSiteCandidate>& candidates, const BuildSiteCandidate& candidate, const UnitFootprint& footprint, int maxCandidates)
+{
+	if( (static_cast<int>(candidates.size()) >= maxCandidates) && (candidate.rating <= candidates.back().rating) )
+		return;
+
+	// neighbouring tiles usually have similar ratings and are likely to be rejected by the engine for the same reason -> only
+	// keep the best rated one of candidates with overlapping footprints (non-maximum suppression)
+	const auto overlaps = [&candidate, &footprint](const BuildSiteCandidate& other)
+	{
+		return    (std::abs(other.mapPos.x - candidate.mapPos.x) < footprint.xSize)
+		       && (std::abs(other.mapPos.y - candidate.mapPos.y) < footprint.ySize);
+	};
+
+	// candidates are sorted by descending rating
+	const auto position = std::upper_bound(candidates.begin(), candidates.end(), candidate, 
+											[](const BuildSiteCandidate& lhs, const BuildSiteCandidate& rhs) { return lhs.rating > rhs.rating; } );
+
+	if(std::any_of(candidates.begin(), position, overlaps))
+		return;
+
+	const auto worseCandidates = std::remove_if(position, candidates.end(), overlaps);
+	candidates.erase(worseCandidates, candidates.end());
+
+	candidates.insert(std::upper_bound(candidates.begin(), candidates.end(), candidate, 
+										[](const BuildSiteCandidate& lhs, const BuildSiteCandidate& rhs) { return lhs.rating > rhs.rating; } ), candidate);
+
+	if(static_cast<int>(candidates.size()) > maxCandidates)
+		candidates.pop_back();
+}
+
 bool AAIMap::CanBuildAt(const MapPos& mapPos, const UnitFootprint& footprint) const
 {
-	if( (mapPos.x+footprint.xSize > xMapSize) || (mapPos.y+footprint.ySize > yMapSize) )
+	if( (mapPos.x < 0) || (mapPos.y < 0) || (mapPos.x+footprint.xSize > xMapSize) || (mapPos.y+footprint.ySize > yMapSize) )
 		return false; // buildsite too close to edges of map
 	else
 	{
-		for(int y = mapPos.y; y < mapPos.y+footprint.ySize; ++y)
-		{
-			for(int x = mapPos.x; x < mapPos.x+footprint.xSize; ++x)
-			{
-				// all squares must be valid
-				if(s_buildmap[x+y*xMapSize].IsTileTypeSet(footprint.invalidTileTypes))
-					return false;
-			}
-		}
-
-		return true;
+		// all squares must be valid
+		return (s_buildMapBitPlanes.IsAnyTileTypeSet(mapPos.x, mapPos.y, footprint.xSize, footprint.ySize, footprint.invalidTileTypes) == false);
 	}
 }
 
@@ -1119,7 +1316,10 @@ void AAIMap::BlockTiles(int xPos, int yPos, int width, int height, bool block)
 				// if no building ordered that cell to be blocked, update buildmap
 				// (only if space is not already occupied by a building)
 				if( (blockmap[tileIndex] == 0) && (s_buildmap[tileIndex].IsTileTypeSet(EBuildMapTileType::FREE)) )
-					s_buildmap[tileIndex].BlockTile();	
+				{
+					s_buildmap[tileIndex].BlockTile();
+					s_buildMapBitPlanes.UpdateTile(x, y, s_buildmap[tileIndex]);
+				}
 
 				++blockmap[tileIndex];
 			}
@@ -1132,7 +1332,10 @@ void AAIMap::BlockTiles(int xPos, int yPos, int width, int height, bool block)
 					// if cell is not blocked anymore, mark cell on buildmap as empty (only if it has been marked bloked
 					//					- if it is not marked as blocked its occupied by another building or unpassable)
 					if(blockmap[tileIndex] == 0 && s_buildmap[tileIndex].IsTileTypeSet(EBuildMapTileType::BLOCKED_SPACE))
-						s_buildmap[tileIndex].FreeTile();	
+					{
+						s_buildmap[tileIndex].FreeTile();
+						s_buildMapBitPlanes.UpdateTile(x, y, s_buildmap[tileIndex]);
+					}
 				}
 			}
 
@@ -1175,6 +1378,9 @@ bool AAIMap::InitBuilding(const UnitDef *def, const float3& position)
 	
 void AAIMap::UpdateBuildMap(const float3& buildPos, const UnitDef *def, bool block)
 {
+	// cached results of engine checks may be outdated after buildings have been placed/removed
+	m_buildSiteValidationCache.Clear();
+
 	const bool factory = ai->s_buildTree.GetUnitType(UnitDefId(def->id)).IsFactory();
 	
 	float3 buildMapPos = buildPos;
@@ -1232,6 +1438,7 @@ int AAIMap::GetCliffyCells(int xPos, int yPos, int xSize, int ySize) const
 void AAIMap::AnalyseMap()
 {
 	const float *height_map = ai->GetAICallback()->GetHeightMap();
+	const float  cliffSlope = cfg->CLIFF_SLOPE;
 
 	const int xPlateauMapSize(xMapSize/4);
 	const int yPlateauMapSize(yMapSize/4);
@@ -1239,87 +1446,159 @@ void AAIMap::AnalyseMap()
 	//-----------------------------------------------------------------------------------------------------------------
 	// determine tile type
 	//-----------------------------------------------------------------------------------------------------------------
-	int waterCells(0);
-	for(int y = 0; y < yMapSize; ++y)
+	std::vector<int> waterCellsInRow(yMapSize, 0);
+
+	ProcessRowsInParallel(yMapSize, [&](int yStart, int yEnd)
 	{
-		for(int x = 0; x < xMapSize; ++x)
+		for(int y = yStart; y < yEnd; ++y)
 		{
-			s_buildmap[x+y*xMapSize].SetTileType(EBuildMapTileType::FREE);
-
-			// determine tile type (land or water)
-			if(height_map[x + y * xMapSize] < 0.0f)
+			for(int x = 0; x < xMapSize; ++x)
 			{
-				s_buildmap[x+y*xMapSize].SetTileType(EBuildMapTileType::WATER);
-				++waterCells;
-			}
-			else
-				s_buildmap[x+y*xMapSize].SetTileType(EBuildMapTileType::LAND);
+				s_buildmap[x+y*xMapSize].SetTileType(EBuildMapTileType::FREE);
 
-			// determine slope to detect cliffs
-			if( (x < xMapSize - 4) && (y < yMapSize - 4) )
-			{
-				const float xSlope = (height_map[y * xMapSize + x] - height_map[y * xMapSize + x + 4])/64.0f;
+				// determine tile type (land or water)
+				if(height_map[x + y * xMapSize] < 0.0f)
+				{
+					s_buildmap[x+y*xMapSize].SetTileType(EBuildMapTileType::WATER);
+					++waterCellsInRow[y];
+				}
+				else
+					s_buildmap[x+y*xMapSize].SetTileType(EBuildMapTileType::LAND);
 
-				// check x-direction
-				if( (xSlope > cfg->CLIFF_SLOPE) || (-xSlope > cfg->CLIFF_SLOPE) )
-					s_buildmap[x+y*xMapSize].SetTileType(EBuildMapTileType::CLIFF);
-				else	// check y-direction
+				// determine slope to detect cliffs
+				if( (x < xMapSize - 4) && (y < yMapSize - 4) )
 				{
-					const float ySlope = (height_map[y * xMapSize + x] - height_map[(y+4) * xMapSize + x])/64.0f;
+					const float xSlope = (height_map[y * xMapSize + x] - height_map[y * xMapSize + x + 4])/64.0f;
 
-					if(ySlope > cfg->CLIFF_SLOPE || -ySlope > cfg->CLIFF_SLOPE)
+					// check x-direction
+					if( (xSlope > cliffSlope) || (-xSlope > cliffSlope) )
 						s_buildmap[x+y*xMapSize].SetTileType(EBuildMapTileType::CLIFF);
-					else
-						s_buildmap[x+y*xMapSize].SetTileType(EBuildMapTileType::FLAT);
+					else	// check y-direction
+					{
+						const float ySlope = (height_map[y * xMapSize + x] - height_map[(y+4) * xMapSize + x])/64.0f;
+
+						if(ySlope > cliffSlope || -ySlope > cliffSlope)
+							s_buildmap[x+y*xMapSize].SetTileType(EBuildMapTileType::CLIFF);
+						else
+							s_buildmap[x+y*xMapSize].SetTileType(EBuildMapTileType::FLAT);
+					}
 				}
+				else
+					s_buildmap[x+y*xMapSize].SetTileType(EBuildMapTileType::FLAT);
 			}
-			else
-				s_buildmap[x+y*xMapSize].SetTileType(EBuildMapTileType::FLAT);
 		}
-	}
+	});
+
+	const int waterCells = std::accumulate(waterCellsInRow.begin(), waterCellsInRow.end(), 0);
 
 	s_waterTilesRatio = static_cast<float>(waterCells) / static_cast<float>(xMapSize*yMapSize);
 
+	s_buildMapBitPlanes.SetFromBuildMap(s_buildmap);
+
 	//-----------------------------------------------------------------------------------------------------------------
 	// calculate plateau map
 	//-----------------------------------------------------------------------------------------------------------------
+	// Every center (x,y) with TERRAIN_DETECTION_RANGE <= x < xPlateauMapSize - TERRAIN_DETECTION_RANGE (same for y) adds the height difference
+	// of each tile within [x-TERRAIN_DETECTION_RANGE, x+TERRAIN_DETECTION_RANGE) x [y-TERRAIN_DETECTION_RANGE, y+TERRAIN_DETECTION_RANGE)
+	// to that center to the tile's plateau value (positive differences are omitted for cliff tiles).
+	// Instead of scattering the differences, the contributions of all covering centers are gathered per tile: For non-cliff tiles this is
+	// (number of centers) * height - (sum of heights of centers), the latter is looked up in a summed area table of the center heights.
 	constexpr int TERRAIN_DETECTION_RANGE(6);
 
-	for(int y = TERRAIN_DETECTION_RANGE; y < yPlateauMapSize - TERRAIN_DETECTION_RANGE; ++y)
+	auto getTileHeight = [&](int x, int y) { return height_map[4 * (x + y * xMapSize)]; };
+
+	const int xCenterMin(TERRAIN_DETECTION_RANGE);
+	const int yCenterMin(TERRAIN_DETECTION_RANGE);
+	const int xCenterMax(xPlateauMapSize - TERRAIN_DETECTION_RANGE - 1);
+	const int yCenterMax(yPlateauMapSize - TERRAIN_DETECTION_RANGE - 1);
+
+	// centerHeightSums[x + y * (xPlateauMapSize+1)] = sum of heights of all centers in [0,x) x [0,y)
+	std::vector<double> centerHeightSums((xPlateauMapSize+1) * (yPlateauMapSize+1), 0.0);
+
+	for(int y = 0; y < yPlateauMapSize; ++y)
 	{
-		for(int x = TERRAIN_DETECTION_RANGE; x < xPlateauMapSize - TERRAIN_DETECTION_RANGE; ++x)
+		double rowSum(0.0);
+
+		for(int x = 0; x < xPlateauMapSize; ++x)
+		{
+			if( (x >= xCenterMin) && (x <= xCenterMax) && (y >= yCenterMin) && (y <= yCenterMax) )
+				rowSum += getTileHeight(x, y);
+
+			centerHeightSums[(x+1) + (y+1) * (xPlateauMapSize+1)] = centerHeightSums[(x+1) + y * (xPlateauMapSize+1)] + rowSum;
+		}
+	}
+
+	ProcessRowsInParallel(yPlateauMapSize, [&](int yStart, int yEnd)
+	{
+		for(int j = yStart; j < yEnd; ++j)
 		{
-			const float height = height_map[4 * (x + y * xMapSize)];
+			const int yFirstCenter = std::max(j - TERRAIN_DETECTION_RANGE + 1, yCenterMin);
+			const int yLastCenter  = std::min(j + TERRAIN_DETECTION_RANGE,     yCenterMax);
 
-			for(int j = y - TERRAIN_DETECTION_RANGE; j < y + TERRAIN_DETECTION_RANGE; ++j)
+			for(int i = 0; i < xPlateauMapSize; ++i)
 			{
-				for(int i = x - TERRAIN_DETECTION_RANGE; i < x + TERRAIN_DETECTION_RANGE; ++i)
+				const int xFirstCenter = std::max(i - TERRAIN_DETECTION_RANGE + 1, xCenterMin);
+				const int xLastCenter  = std::min(i + TERRAIN_DETECTION_RANGE,     xCenterMax);
+
+				float plateauValue(0.0f);
+
+				if( (xFirstCenter <= xLastCenter) && (yFirstCenter <= yLastCenter) )
 				{
-					const float diff = (height_map[4 * (i + j * xMapSize)] - height);
+					const float height = getTileHeight(i, j);
 
-					if(diff > 0.0f)
+					//! @todo Investigate the reason for the special treatment of cliffs
+					if(s_buildmap[4 * (i + j * xMapSize)].IsTileTypeNotSet(EBuildMapTileType::CLIFF) )
 					{
-						//! @todo Investigate the reason for this check
-						if(s_buildmap[4 * (i + j * xMapSize)].IsTileTypeNotSet(EBuildMapTileType::CLIFF) )
-							plateau_map[i + j * xPlateauMapSize] += diff;
+						const int numberOfCenters = (xLastCenter - xFirstCenter + 1) * (yLastCenter - yFirstCenter + 1);
+
+						const double centerHeights =   centerHeightSums[(xLastCenter+1) + (yLastCenter+1) * (xPlateauMapSize+1)]
+													 - centerHeightSums[ xFirstCenter   + (yLastCenter+1) * (xPlateauMapSize+1)]
+													 - centerHeightSums[(xLastCenter+1) +  yFirstCenter   * (xPlateauMapSize+1)]
+													 + centerHeightSums[ xFirstCenter   +  yFirstCenter   * (xPlateauMapSize+1)];
+
+						plateauValue = static_cast<float>(static_cast<double>(numberOfCenters) * static_cast<double>(height) - centerHeights);
 					}
 					else
-						plateau_map[i + j * xPlateauMapSize] += diff;
+					{
+						for(int y = yFirstCenter; y <= yLastCenter; ++y)
+						{
+							for(int x = xFirstCenter; x <= xLastCenter; ++x)
+							{
+								const float diff = height - getTileHeight(x, y);
+
+								if(diff <= 0.0f)
+									plateauValue += diff;
+							}
+						}
+					}
 				}
+
+				if(plateauValue >= 0.0f)
+					plateau_map[i + j * xPlateauMapSize] = sqrt(plateauValue);
+				else
+					plateau_map[i + j * xPlateauMapSize] = -1.0f * sqrt((-1.0f) * plateauValue);
 			}
 		}
-	}
+	});
+}
 
-	for(int y = 0; y < yPlateauMapSize; ++y)
-	{
-		for(int x = 0; x < xPlateauMapSize; ++x)
-		{
-			if(plateau_map[x + y * xPlateauMapSize] >= 0.0f)
-				plateau_map[x + y * xPlateauMapSize] = sqrt(plateau_map[x + y * xPlateauMapSize]);
-			else
-				plateau_map[x + y * xPlateauMapSize] = -1.0f * sqrt((-1.0f) * plateau_map[x + y * xPlateauMapSize]);
-		}
-	}
+void AAIMap::ProcessRowsInParallel(int numberOfRows, const std::function<void(int, int)>& processRows)
+{
+	const int hardwareThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+	const int numberOfThreads = std::max(std::min( std::min(hardwareThreads, AAIConstants::maxMapAnalysisThreads), numberOfRows / AAIConstants::minRowsPerMapAnalysisThread), 1);
+	const int rowsPerThread   = (numberOfRows + numberOfThreads - 1) / numberOfThreads;
+
+	std::vector<std::thread> threads;
+	threads.reserve(numberOfThreads-1);
+
+	for(int firstRow = rowsPerThread; firstRow < numberOfRows; firstRow += rowsPerThread)
+		threads.push_back( std::thread(processRows, firstRow, std::min(firstRow + rowsPerThread, numberOfRows)) );
+
+	// first band is processed by the calling thread
+	processRows(0, std::min(rowsPerThread, numberOfRows));
+
+	for(auto& thread : threads)
+		thread.join();
 }
 
 void AAIMap::DetermineMapType()
@@ -1346,160 +1625,189 @@ void AAIMap::DetectMetalSpots()
 	const UnitFootprint largestExtractorFootprint = ai->s_buildTree.GetFootprint(largestExtractor);
 
 	s_isMetalMap = false;
-	bool Stopme = false;
-	int TotalMetal = 0;
-	int MaxMetal = 0;
-	int TempMetal = 0;
 	int SpotsFound = 0;
-	int coordx = 0, coordy = 0;
-//	float AverageMetal;
 
 	AAIMetalSpot temp;
 	float3 pos;
 
-	int MinMetalForSpot = 30; // from 0-255, the minimum percentage of metal a spot needs to have
+	const int MinMetalForSpot = 30; // from 0-255, the minimum percentage of metal a spot needs to have
 							//from the maximum to be saved. Prevents crappier spots in between taken spaces.
 							//They are still perfectly valid and will generate metal mind you!
-	int MaxSpots = 5000; //If more spots than that are found the map is considered a metalmap, tweak this as needed
-
-	int MetalMapHeight = ai->GetAICallback()->GetMapHeight() / 2; //metal map has 1/2 resolution of normal map
-	int MetalMapWidth = ai->GetAICallback()->GetMapWidth() / 2;
-	int TotalCells = MetalMapHeight * MetalMapWidth;
-	unsigned char XtractorRadius = ai->GetAICallback()->GetExtractorRadius()/ 16.0;
-	unsigned char DoubleRadius = ai->GetAICallback()->GetExtractorRadius() / 8.0;
-	int SquareRadius = (ai->GetAICallback()->GetExtractorRadius() / 16.0) * (ai->GetAICallback()->GetExtractorRadius() / 16.0); //used to speed up loops so no recalculation needed
-	int DoubleSquareRadius = (ai->GetAICallback()->GetExtractorRadius() / 8.0) * (ai->GetAICallback()->GetExtractorRadius() / 8.0); // same as above
-//	int CellsInRadius = PI * XtractorRadius * XtractorRadius; //yadda yadda
-	unsigned char* MexArrayA = new unsigned char [TotalCells];
-	unsigned char* MexArrayB = new unsigned char [TotalCells];
-	int* TempAverage = new int [TotalCells];
+	const int MaxSpots = 5000; //If more spots than that are found the map is considered a metalmap, tweak this as needed
+
+	const int MetalMapHeight = ai->GetAICallback()->GetMapHeight() / 2; //metal map has 1/2 resolution of normal map
+	const int MetalMapWidth = ai->GetAICallback()->GetMapWidth() / 2;
+	const int TotalCells = MetalMapHeight * MetalMapWidth;
+	const int XtractorRadius = static_cast<unsigned char>(ai->GetAICallback()->GetExtractorRadius() / 16.0);
+	const int DoubleRadius = static_cast<unsigned char>(ai->GetAICallback()->GetExtractorRadius() / 8.0);
+	const int SquareRadius = (ai->GetAICallback()->GetExtractorRadius() / 16.0) * (ai->GetAICallback()->GetExtractorRadius() / 16.0); //used to speed up loops so no recalculation needed
+	const int DoubleSquareRadius = (ai->GetAICallback()->GetExtractorRadius() / 8.0) * (ai->GetAICallback()->GetExtractorRadius() / 8.0); // same as above
 
 	//Load up the metal Values in each pixel
-	for (int i = 0; i != TotalCells - 1; i++)
+	const unsigned char* metalMap = ai->GetAICallback()->GetMetalMap();
+	std::vector<unsigned char> MexArrayA(metalMap, metalMap + TotalCells);
+	std::vector<unsigned char> MexArrayB(TotalCells, 0);
+	std::vector<int>           TempAverage(TotalCells, 0);
+
+	// The extractor covers all cells (x+dx, y+dy) with -XtractorRadius <= dx,dy < XtractorRadius and dx*dx + dy*dy <= SquareRadius,
+	// i.e. a contiguous range of cells [minDx, maxDx] for every row dy. Together with prefix sums of the metal of each row of the metal map,
+	// the metal within range of an extractor can be determined with one lookup per row instead of one per cell.
+	std::vector<int> minDx(2*XtractorRadius), maxDx(2*XtractorRadius);
+
+	for(int dy = -XtractorRadius; dy < XtractorRadius; ++dy)
 	{
-		MexArrayA[i] = *(ai->GetAICallback()->GetMetalMap() + i);
-		TotalMetal += MexArrayA[i];		// Count the total metal so you can work out an average of the whole map
+		const int remainingSquareRadius = SquareRadius - dy*dy;
+
+		if(remainingSquareRadius >= 0)
+		{
+			int width(0);
+			while( (width+1)*(width+1) <= remainingSquareRadius)
+				++width;
+
+			minDx[dy+XtractorRadius] = std::max(-width, -XtractorRadius);
+			maxDx[dy+XtractorRadius] = std::min( width, XtractorRadius-1);
+		}
+		else
+		{
+			// row not covered at all
+			minDx[dy+XtractorRadius] =  1;
+			maxDx[dy+XtractorRadius] = -1;
+		}
 	}
 
-//	AverageMetal = ((float)TotalMetal) / ((float)TotalCells);  //do the average
+	// metalInRow[x + y * (MetalMapWidth+1)] = metal of cells [0, x) in row y
+	std::vector<int> metalInRow((MetalMapWidth+1) * MetalMapHeight, 0);
+
+	auto updateMetalInRow = [&](int y)
+	{
+		int* rowSums = &metalInRow[y * (MetalMapWidth+1)];
+
+		for(int x = 0; x < MetalMapWidth; ++x)
+			rowSums[x+1] = rowSums[x] + MexArrayA[y * MetalMapWidth + x];
+	};
+
+	auto calculateMetalInExtractorRange = [&](int x, int y)
+	{
+		int TotalMetal(0);
+
+		for(int dy = -XtractorRadius; dy < XtractorRadius; ++dy)
+		{
+			const int myy = y + dy;
+
+			if( (myy >= 0) && (myy < MetalMapHeight) )
+			{
+				const int xStart = std::max(x + minDx[dy+XtractorRadius], 0);
+				const int xEnd   = std::min(x + maxDx[dy+XtractorRadius], MetalMapWidth-1);
+
+				if(xStart <= xEnd)
+					TotalMetal += metalInRow[xEnd + 1 + myy * (MetalMapWidth+1)] - metalInRow[xStart + myy * (MetalMapWidth+1)];
+			}
+		}
+
+		return TotalMetal;
+	};
 
 	// Now work out how much metal each spot can make by adding up the metal from nearby spots
-	for (int y = 0; y != MetalMapHeight; y++)
+	std::vector<int> maxMetalInRow(MetalMapHeight, 0);
+
+	ProcessRowsInParallel(MetalMapHeight, [&](int yStart, int yEnd)
 	{
-		for (int x = 0; x != MetalMapWidth; x++)
+		for(int y = yStart; y < yEnd; ++y)
+			updateMetalInRow(y);
+	});
+
+	ProcessRowsInParallel(MetalMapHeight, [&](int yStart, int yEnd)
+	{
+		for(int y = yStart; y < yEnd; ++y)
 		{
-			TotalMetal = 0;
-			for (int myx = x - XtractorRadius; myx != x + XtractorRadius; myx++)
+			for(int x = 0; x < MetalMapWidth; ++x)
 			{
-				if (myx >= 0 && myx < MetalMapWidth)
-				{
-					for (int myy = y - XtractorRadius; myy != y + XtractorRadius; myy++)
-					{
-						if (myy >= 0 && myy < MetalMapHeight && ((x - myx)*(x - myx) + (y - myy)*(y - myy)) <= SquareRadius)
-						{
-							TotalMetal += MexArrayA[myy * MetalMapWidth + myx]; //get the metal from all pixels around the extractor radius
-						}
-					}
-				}
+				TempAverage[y * MetalMapWidth + x] = calculateMetalInExtractorRange(x, y); //set that spots metal making ability
+				maxMetalInRow[y] = std::max(maxMetalInRow[y], TempAverage[y * MetalMapWidth + x]);
 			}
-			TempAverage[y * MetalMapWidth + x] = TotalMetal; //set that spots metal making ability (divide by cells to values are small)
-			if (MaxMetal < TotalMetal)
-				MaxMetal = TotalMetal;  //find the spot with the highest metal to set as the map's max
 		}
-	}
+	});
+
+	const int MaxMetal = (MetalMapHeight > 0) ? *std::max_element(maxMetalInRow.begin(), maxMetalInRow.end()) : 0; //find the spot with the highest metal to set as the map's max
+
+	// Candidates for metal spots (cells with even index only) ordered by their metal (cells with lower index first if metal is equal).
+	// Entries are not removed when the metal of a cell changes - an entry is outdated if its value does not match the current one of the cell.
+	std::priority_queue< std::pair<int, int> > candidates;
+
+	auto addCandidate = [&](int cellIndex)
+	{
+		if( (cellIndex % 2 == 0) && (MexArrayB[cellIndex] >= MinMetalForSpot) )
+			candidates.push( std::pair<int, int>(MexArrayB[cellIndex], -cellIndex) );
+	};
+
 	for (int i = 0; i != TotalCells; i++) // this will get the total metal a mex placed at each spot would make
 	{
 		MexArrayB[i] = spring::SafeDivide(TempAverage[i] * 255,  MaxMetal);  //scale the metal so any map will have values 0-255, no matter how much metal it has
+		addCandidate(i);
 	}
 
 	for (int a = 0; a != MaxSpots; a++)
 	{
-		if(!Stopme)
-			TempMetal = 0; //reset tempmetal so it can find new spots
-		for (int i = 0; i != TotalCells; i=i+2)
-		{			//finds the best spot on the map and gets its coords
-			if (MexArrayB[i] > TempMetal && !Stopme)
-			{
-				TempMetal = MexArrayB[i];
-				coordx = i%MetalMapWidth;
-				coordy = i/MetalMapWidth;
-			}
-		}
-		if (TempMetal < MinMetalForSpot)
-			Stopme = true; // if the spots get too crappy it will stop running the loops to speed it all up
+		//finds the best spot on the map and gets its coords
+		while( (candidates.empty() == false) && (MexArrayB[-candidates.top().second] != candidates.top().first) )
+			candidates.pop();
 
-		if (!Stopme)
-		{
-			//pos.x = coordx * 2 * SQUARE_SIZE;
-			//pos.z = coordy * 2 * SQUARE_SIZE;	
-			pos = ConvertMapPosToUnitPos(MapPos(2*coordx, 2*coordy), largestExtractorFootprint);
-			ConvertPositionToFinalBuildsite(pos, largestExtractorFootprint);
+		if(candidates.empty())
+			break; // if the spots get too crappy stop searching
 
-			pos.y = ai->GetAICallback()->GetElevation(pos.x, pos.z);
+		const int TempMetal = candidates.top().first;
+		const int coordx    = (-candidates.top().second) % MetalMapWidth;
+		const int coordy    = (-candidates.top().second) / MetalMapWidth;
+		candidates.pop();
 
-			temp.amount = TempMetal * ai->GetAICallback()->GetMaxMetal() * MaxMetal / 255.0f;
-			temp.occupied = false;
-			temp.pos = pos;
+		pos = ConvertMapPosToUnitPos(MapPos(2*coordx, 2*coordy), largestExtractorFootprint);
+		ConvertPositionToFinalBuildsite(pos, largestExtractorFootprint);
 
-			//if(ai->Getcb()->CanBuildAt(def, pos))
-			//{
-				Pos2BuildMapPos(&pos, def);
-				MapPos mapPos(pos.x, pos.z);
+		pos.y = ai->GetAICallback()->GetElevation(pos.x, pos.z);
 
-				//! @todo Check if this is correct or results in unnecessary shifts / rounding errors.
-				if( (mapPos.x >= 2) && (mapPos.y >= 2) && (mapPos.x < xMapSize-2) && (mapPos.y < yMapSize-2) )
-				{
-					if(CanBuildAt(mapPos, largestExtractorFootprint))
-					{
-						metal_spots.push_back(temp);
-						++SpotsFound;
+		temp.amount = TempMetal * ai->GetAICallback()->GetMaxMetal() * MaxMetal / 255.0f;
+		temp.occupied = false;
+		temp.pos = pos;
 
-						ChangeBuildMapOccupation(mapPos.x-2, mapPos.y-2, largestExtractorFootprint.xSize+2, largestExtractorFootprint.ySize+2, true);
-					}
-				}
-			//}
+		Pos2BuildMapPos(&pos, def);
+		MapPos mapPos(pos.x, pos.z);
 
-			for (int myx = coordx - XtractorRadius; myx != coordx + XtractorRadius; myx++)
+		//! @todo Check if this is correct or results in unnecessary shifts / rounding errors.
+		if( (mapPos.x >= 2) && (mapPos.y >= 2) && (mapPos.x < xMapSize-2) && (mapPos.y < yMapSize-2) )
+		{
+			if(CanBuildAt(mapPos, largestExtractorFootprint))
 			{
-				if (myx >= 0 && myx < MetalMapWidth)
+				s_metalSpots.AddSpot(temp);
+				++SpotsFound;
+
+				ChangeBuildMapOccupation(mapPos.x-2, mapPos.y-2, largestExtractorFootprint.xSize+2, largestExtractorFootprint.ySize+2, true);
+			}
+		}
+
+		for (int myy = std::max(coordy - XtractorRadius, 0); myy < std::min(coordy + XtractorRadius, MetalMapHeight); myy++)
+		{
+			for (int myx = std::max(coordx - XtractorRadius, 0); myx < std::min(coordx + XtractorRadius, MetalMapWidth); myx++)
+			{
+				if( ((coordx - myx)*(coordx - myx) + (coordy - myy)*(coordy - myy)) <= SquareRadius)
 				{
-					for (int myy = coordy - XtractorRadius; myy != coordy + XtractorRadius; myy++)
-					{
-						if (myy >= 0 && myy < MetalMapHeight && ((coordx - myx)*(coordx - myx) + (coordy - myy)*(coordy - myy)) <= SquareRadius)
-						{
-							MexArrayA[myy * MetalMapWidth + myx] = 0; //wipes the metal around the spot so its not counted twice
-							MexArrayB[myy * MetalMapWidth + myx] = 0;
-						}
-					}
+					MexArrayA[myy * MetalMapWidth + myx] = 0; //wipes the metal around the spot so its not counted twice
+					MexArrayB[myy * MetalMapWidth + myx] = 0;
 				}
 			}
 
-			// Redo the whole averaging process around the picked spot so other spots can be found around it
-			for (int y = coordy - DoubleRadius; y != coordy + DoubleRadius; y++)
+			updateMetalInRow(myy);
+		}
+
+		// Redo the whole averaging process around the picked spot so other spots can be found around it
+		for (int y = std::max(coordy - DoubleRadius, 0); y < std::min(coordy + DoubleRadius, MetalMapHeight); y++)
+		{
+			for (int x = std::max(coordx - DoubleRadius, 0); x < std::min(coordx + DoubleRadius, MetalMapWidth); x++)
 			{
-				if(y >=0 && y < MetalMapHeight)
+				//only update spots between r and 2r (cells within r have been wiped)
+				if( ((coordx - x)*(coordx - x) + (coordy - y)*(coordy - y) <= DoubleSquareRadius) && MexArrayB[y * MetalMapWidth + x])
 				{
-					for (int x = coordx - DoubleRadius; x != coordx + DoubleRadius; x++)
-					{//funcion below is optimized so it will only update spots between r and 2r, greatly speeding it up
-						if((coordx - x)*(coordx - x) + (coordy - y)*(coordy - y) <= DoubleSquareRadius && x >=0 && x < MetalMapWidth && MexArrayB[y * MetalMapWidth + x])
-						{
-							TotalMetal = 0;
-							for (int myx = x - XtractorRadius; myx != x + XtractorRadius; myx++)
-							{
-								if (myx >= 0 && myx < MetalMapWidth)
-								{
-									for (int myy = y - XtractorRadius; myy != y + XtractorRadius; myy++)
-									{
-										if (myy >= 0 && myy < MetalMapHeight && ((x - myx)*(x - myx) + (y - myy)*(y - myy)) <= SquareRadius)
-										{
-											TotalMetal += MexArrayA[myy * MetalMapWidth + myx]; //recalculate nearby spots to account for deleted metal from chosen spot
-										}
-									}
-								}
-							}
-							MexArrayB[y * MetalMapWidth + x] = spring::SafeDivide(TotalMetal * 255, MaxMetal); //set that spots metal amount
-						}
-					}
+					MexArrayB[y * MetalMapWidth + x] = spring::SafeDivide(calculateMetalInExtractorRange(x, y) * 255, MaxMetal); //set that spots metal amount
+					addCandidate(y * MetalMapWidth + x);
 				}
 			}
 		}
@@ -1508,15 +1816,11 @@ void AAIMap::DetectMetalSpots()
 	if(SpotsFound > 500)
 	{
 		s_isMetalMap = true;
-		metal_spots.clear();
+		s_metalSpots.Clear();
 		ai->Log("Map is considered to be a metal map\n");
 	}
 	else
 		s_isMetalMap = false;
-
-	spring::SafeDeleteArray(MexArrayA);
-	spring::SafeDeleteArray(MexArrayB);
-	spring::SafeDeleteArray(TempAverage);
 }
 
 void AAIMap::CheckUnitsInLOSUpdate(bool forceUpdate)
@@ -1533,76 +1837,143 @@ void AAIMap::CheckUnitsInLOSUpdate(bool forceUpdate)
 	}
 }
 
-void AAIMap::UpdateEnemyUnitsInLOS()
+void AAIMap::EnemyEnteredLOS(UnitId unitId)
 {
-	//
-	// reset scouted buildings for all cells within current los
-	//
-	const int* losMap = ai->GetLosMap();
+	if(m_enemyUnits.IsValid(unitId) == false)
+		return;
 
-	const int frame = ai->GetAICallback()->GetCurrentFrame();
+	EnemyUnitInfo& enemyUnit = m_enemyUnits.GetEnemyUnit(unitId);
+	m_enemyUnits.SetInLOS(unitId, true);
 
-	int cellIndex(0);
-	for(int y = 0; y < yLOSMapSize; ++y)
+	// units within LOS are not counted as detected by sensor
+	UpdateSensorContact(enemyUnit, -1);
+
+	// unit may have died outside of LOS (no destroyed event) and its id may have been reused by the engine -> determine
+	// build state and suitability as bomb target again
+	enemyUnit.finished          = false;
+	enemyUnit.bombTargetPending = false;
+
+	const UnitDefId unitDefId = ai->UnitSnapshot()->GetUnitDefId(unitId);
+
+	if(unitDefId.IsValid())
 	{
-		for(int x = 0; x < xLOSMapSize; ++x)
-		{
-			if(losMap[cellIndex] > 0)
-			{
-				m_scoutedEnemyUnitsMap.ResetTiles(x, y, frame);
-			}
+		enemyUnit.unitDefId        = unitDefId;
+		enemyUnit.isStatic         = ai->s_buildTree.GetMovementType(unitDefId).IsStatic();
+		enemyUnit.lastSeenPosition = ai->UnitSnapshot()->GetUnitPos(unitId);
+		enemyUnit.lastSeenFrame    = ai->GetAICallback()->GetCurrentFrame();
+
+		// buildings do not change -> check when entering LOS if they are suitable bomb targets; if target list is full,
+		// check again during the following scouting passes (as long as the building stays within LOS)
+		if(m_scoutedEnemyUnitsMap.GetScoutMapTile(enemyUnit.lastSeenPosition).IsValid())
+			enemyUnit.bombTargetPending = ai->UnitTable()->CheckBombTarget(unitId, unitDefId, ai->s_buildTree.GetUnitCategory(unitDefId), enemyUnit.lastSeenPosition);
+	}
+}
 
-			++cellIndex;
-		}
+void AAIMap::EnemyLeftLOS(UnitId unitId)
+{
+	if(m_enemyUnits.IsValid(unitId))
+		m_enemyUnits.SetInLOS(unitId, false);
+}
+
+void AAIMap::EnemyEnteredRadar(UnitId unitId)
+{
+	if(m_enemyUnits.IsValid(unitId))
+		m_enemyUnits.SetInRadar(unitId, true);
+}
+
+void AAIMap::EnemyLeftRadar(UnitId unitId)
+{
+	if(m_enemyUnits.IsValid(unitId))
+	{
+		UpdateSensorContact(m_enemyUnits.GetEnemyUnit(unitId), -1);
+		m_enemyUnits.SetInRadar(unitId, false);
 	}
+}
 
-	for(int y = 0; y < ySectors; ++y)
+void AAIMap::EnemyDestroyed(UnitId unitId)
+{
+	if(m_enemyUnits.IsValid(unitId))
 	{
-		for(int x = 0; x < xSectors; ++x)
-			m_sectorMap[x][y].m_enemyUnitsDetectedBySensor = 0;
+		UpdateSensorContact(m_enemyUnits.GetEnemyUnit(unitId), -1);
+		m_enemyUnits.Remove(unitId);
 	}
+}
 
-	// update enemy units
+void AAIMap::UpdateSensorContact(EnemyUnitInfo& enemyUnit, int gridIndex)
+{
+	if(enemyUnit.sensorContactGridIndex != gridIndex)
+	{
+		if(enemyUnit.sensorContactGridIndex >= 0)
+			m_sectorGrid.RemoveEnemyUnitDetectedBySensor(enemyUnit.sensorContactGridIndex);
+
+		if(gridIndex >= 0)
+			m_sectorGrid.AddEnemyUnitDetectedBySensor(gridIndex);
+
+		enemyUnit.sensorContactGridIndex = gridIndex;
+	}
+}
+
+void AAIMap::UpdateEnemyUnitsInLOS()
+{
+	//
+	// reset scouted buildings for all cells within current los
+	//
+	const int* losMap = ai->GetLosMap();
+
+	const int frame = ai->GetAICallback()->GetCurrentFrame();
+
+	m_scoutedEnemyUnitsMap.ResetTilesInLOS(losMap, xLOSMapSize, m_buildingsOnContinent, frame);
+
+	// update enemy units (only units within LOS/radar coverage, positions of buildings within LOS are already known)
 	MobileTargetTypeValues spottedEnemyCombatUnitsByTargetType;
-	const int numberOfEnemyUnits = ai->GetAICallback()->GetEnemyUnitsInRadarAndLos(&(m_unitsInLOS.front()));
 
-	for(int i = 0; i < numberOfEnemyUnits; ++i)
+	for(const auto unitId : m_enemyUnits.GetTrackedUnits())
 	{
-		const float3                   pos = ai->GetAICallback()->GetUnitPos(m_unitsInLOS[i]);
-		const springLegacyAI::UnitDef* def = ai->GetAICallback()->GetUnitDef(m_unitsInLOS[i]);
+		EnemyUnitInfo& enemyUnit = m_enemyUnits.GetEnemyUnit(unitId);
 
-		if(def) // unit is within los
+		if(enemyUnit.inLOS && enemyUnit.unitDefId.IsValid())
 		{
-			ScoutMapTile tile = m_scoutedEnemyUnitsMap.GetScoutMapTile(pos);
+			if(enemyUnit.isStatic == false)
+			{
+				enemyUnit.lastSeenPosition = ai->UnitSnapshot()->GetUnitPos(unitId);
+				enemyUnit.lastSeenFrame    = frame;
+			}
+
+			ScoutMapTile tile = m_scoutedEnemyUnitsMap.GetScoutMapTile(enemyUnit.lastSeenPosition);
 
 			// make sure unit is within the map (e.g. no aircraft that has flown outside of the map)
 			if(tile.IsValid())
 			{
-				const UnitDefId defId(def->id);
-				const AAIUnitCategory& category = ai->s_buildTree.GetUnitCategory(defId);
+				const AAIUnitCategory& category = ai->s_buildTree.GetUnitCategory(enemyUnit.unitDefId);
 
 				// add (finished) buildings/combat units to scout map
 				if( category.IsBuilding() || category.IsCombatUnit() )
 				{
-					if(ai->GetAICallback()->UnitBeingBuilt(m_unitsInLOS[i]) == false)
-						m_scoutedEnemyUnitsMap.AddEnemyUnit(defId, tile);
+					if(enemyUnit.finished == false)
+						enemyUnit.finished = (ai->UnitSnapshot()->UnitBeingBuilt(unitId) == false);
 
-					ai->UnitTable()->CheckBombTarget(UnitId(m_unitsInLOS[i]), defId, category, pos);
+					if(enemyUnit.finished)
+						m_scoutedEnemyUnitsMap.AddEnemyUnit(enemyUnit.unitDefId, tile, m_buildingsOnContinent, frame);
 				}
 
+				if(enemyUnit.bombTargetPending)
+					enemyUnit.bombTargetPending = ai->UnitTable()->CheckBombTarget(unitId, enemyUnit.unitDefId, category, enemyUnit.lastSeenPosition);
+
 				if(category.IsCombatUnit())
 				{
-					const AAITargetType& targetType = ai->s_buildTree.GetTargetType(defId);
+					const AAITargetType& targetType = ai->s_buildTree.GetTargetType(enemyUnit.unitDefId);
 					spottedEnemyCombatUnitsByTargetType.AddValueForTargetType(targetType, 1.0f);
 				}
 			}
 		}
 		else // unit on radar only
 		{
-			AAISector* sector = GetSectorOfPos(pos);
+			enemyUnit.lastSeenPosition = ai->UnitSnapshot()->GetUnitPos(unitId);
+			enemyUnit.lastSeenFrame    = frame;
 
-			if(sector)
-				sector->m_enemyUnitsDetectedBySensor += 1;
+			const AAISector* sector = GetSectorOfPos(enemyUnit.lastSeenPosition);
+
+			UpdateSensorContact(enemyUnit, sector ? sector->m_gridIndex : -1);
 		}
 	}
 
@@ -1611,56 +1982,173 @@ void AAIMap::UpdateEnemyUnitsInLOS()
 
 void AAIMap::UpdateFriendlyUnitsInLos()
 {
-	for(int y = 0; y < ySectors; ++y)
+	// own units are added/removed by unit finished/destroyed events -> only sectors of mobile units need to be updated (positions
+	// taken from the unit snapshot, i.e. not queried again if already requested within the current frame)
+	for(const auto unitId : m_friendlyUnits.GetTrackedUnits())
 	{
-		for(int x = 0; x < xSectors; ++x)
-			m_sectorMap[x][y].ResetLocalCombatPower();
+		FriendlyUnitInfo& friendlyUnit = m_friendlyUnits.GetFriendlyUnit(unitId);
+
+		if(friendlyUnit.ownUnit && (friendlyUnit.isStatic == false))
+		{
+			const AAISector* sector = GetSectorOfPos( ai->UnitSnapshot()->GetUnitPos(unitId) );
+			MoveFriendlyUnit(friendlyUnit, sector ? sector->m_gridIndex : -1);
+		}
 	}
 
+	// allied units can only be determined by querying all friendly units from the engine -> done less frequently
+	++m_friendlyUnitsUpdates;
+
+	if(m_friendlyUnitsUpdates % AAIConstants::alliedUnitsUpdateInterval == 0)
+		UpdateAlliedUnits();
+}
+
+void AAIMap::UpdateAlliedUnits()
+{
+	const int currentFrame = ai->GetAICallback()->GetCurrentFrame();
 	const int numberOfFriendlyUnits = ai->GetAICallback()->GetFriendlyUnits(&(m_unitsInLOS.front()));
 
 	for(int i = 0; i < numberOfFriendlyUnits; ++i)
 	{
-		// get unit def & category
-		const springLegacyAI::UnitDef* def = ai->GetAICallback()->GetUnitDef(m_unitsInLOS[i]);
-		const UnitDefId unitDefId(def->id);
+		const UnitId unitId(m_unitsInLOS[i]);
 
-		const AAIUnitCategory& category = ai->s_buildTree.GetUnitCategory(unitDefId);
+		if(m_friendlyUnits.IsValid(unitId) == false)
+			continue;
 
-		if( category.IsBuilding() || category.IsCombatUnit() )
+		if(m_friendlyUnits.IsTracked(unitId))
 		{
-			AAISector* sector = GetSectorOfPos( ai->GetAICallback()->GetUnitPos(m_unitsInLOS[i]) );
+			FriendlyUnitInfo& friendlyUnit = m_friendlyUnits.GetFriendlyUnit(unitId);
+			friendlyUnit.lastUpdateFrame = currentFrame;
 
-			if(sector)
+			// only mobile units may have moved to another sector (own units already updated)
+			if( (friendlyUnit.ownUnit == false) && (friendlyUnit.isStatic == false) )
 			{
-				if(category.IsBuilding() && (ai->GetAICallback()->GetUnitTeam(m_unitsInLOS[i]) != ai->GetMyTeamId()))
-				{
-					++sector->m_alliedBuildings;
-				}
-
-				if(category.IsCombatUnit() || category.IsStaticDefence())
-				{
-					sector->AddFriendlyCombatPower( ai->s_buildTree.GetCombatPower(unitDefId) );
-				}	
+				const AAISector* sector = GetSectorOfPos( ai->UnitSnapshot()->GetUnitPos(unitId) );
+				MoveFriendlyUnit(friendlyUnit, sector ? sector->m_gridIndex : -1);
 			}
 		}
+		// own units are added when finished, allied ones when spotted for the first time
+		else if(ai->UnitSnapshot()->GetUnitTeam(unitId) != ai->GetMyTeamId())
+		{
+			const UnitDefId unitDefId = ai->UnitSnapshot()->GetUnitDefId(unitId);
+
+			if(unitDefId.IsValid())
+				AddFriendlyUnit(unitId, unitDefId, false, ai->UnitSnapshot()->GetUnitPos(unitId));
+		}
+	}
+
+	// remove allied units that no longer exist (iterate backwards as removal moves the last unit to the position of the removed one)
+	const std::vector<UnitId>& trackedUnits = m_friendlyUnits.GetTrackedUnits();
+
+	for(int i = static_cast<int>(trackedUnits.size()) - 1; i >= 0; --i)
+	{
+		const UnitId unitId = trackedUnits[i];
+		const FriendlyUnitInfo& friendlyUnit = m_friendlyUnits.GetFriendlyUnit(unitId);
+
+		if( (friendlyUnit.ownUnit == false) && (friendlyUnit.lastUpdateFrame != currentFrame) )
+			RemoveFriendlyUnit(unitId);
 	}
 }
 
-void AAIMap::UpdateEnemyScoutingData()
+void AAIMap::FriendlyUnitFinished(UnitId unitId, UnitDefId unitDefId)
+{
+	if(m_friendlyUnits.IsValid(unitId) == false)
+		return;
+
+	// unit may already be tracked as allied unit if it has been given to this AAI instance
+	RemoveFriendlyUnit(unitId);
+	AddFriendlyUnit(unitId, unitDefId, true, ai->UnitSnapshot()->GetUnitPos(unitId));
+}
+
+void AAIMap::FriendlyUnitDestroyed(UnitId unitId)
+{
+	if(m_friendlyUnits.IsValid(unitId))
+		RemoveFriendlyUnit(unitId);
+}
+
+void AAIMap::AddFriendlyUnit(UnitId unitId, UnitDefId unitDefId, bool ownUnit, const float3& position)
+{
+	const AAIUnitCategory& category = ai->s_buildTree.GetUnitCategory(unitDefId);
+
+	FriendlyUnitInfo friendlyUnit;
+	friendlyUnit.unitDefId       = unitDefId;
+	friendlyUnit.lastUpdateFrame = ai->GetAICallback()->GetCurrentFrame();
+	friendlyUnit.ownUnit         = ownUnit;
+	friendlyUnit.isStatic        = ai->s_buildTree.GetMovementType(unitDefId).IsStatic();
+	friendlyUnit.alliedBuilding  = category.IsBuilding() && (ownUnit == false);
+	friendlyUnit.hasCombatPower  = category.IsCombatUnit() || category.IsStaticDefence();
+
+	// units that neither count as allied building nor contribute combat power do not need to be tracked
+	if( (friendlyUnit.alliedBuilding == false) && (friendlyUnit.hasCombatPower == false) )
+		return;
+
+	if(friendlyUnit.hasCombatPower)
+		friendlyUnit.combatPower = ai->s_buildTree.GetCombatPower(unitDefId);
+
+	const AAISector* sector = GetSectorOfPos(position);
+	friendlyUnit.gridIndex = sector ? sector->m_gridIndex : -1;
+
+	ApplyFriendlyUnitToSector(friendlyUnit, 1.0f);
+	m_friendlyUnits.Add(unitId, friendlyUnit);
+}
+
+void AAIMap::RemoveFriendlyUnit(UnitId unitId)
+{
+	if(m_friendlyUnits.IsTracked(unitId))
+	{
+		ApplyFriendlyUnitToSector(m_friendlyUnits.GetFriendlyUnit(unitId), -1.0f);
+		m_friendlyUnits.Remove(unitId);
+	}
+}
+
+void AAIMap::MoveFriendlyUnit(FriendlyUnitInfo& friendlyUnit, int gridIndex)
+{
+	if(friendlyUnit.gridIndex != gridIndex)
+	{
+		ApplyFriendlyUnitToSector(friendlyUnit, -1.0f);
+		friendlyUnit.gridIndex = gridIndex;
+		ApplyFriendlyUnitToSector(friendlyUnit, 1.0f);
+	}
+}
+
+void AAIMap::ApplyFriendlyUnitToSector(const FriendlyUnitInfo& friendlyUnit, float modifier)
 {
-	std::fill(m_buildingsOnContinent.begin(), m_buildingsOnContinent.end(), 0);
+	if(friendlyUnit.gridIndex < 0)
+		return;
+
+	if(friendlyUnit.alliedBuilding)
+	{
+		if(modifier > 0.0f)
+			m_sectorGrid.AddAlliedBuilding(friendlyUnit.gridIndex);
+		else
+			m_sectorGrid.RemoveAlliedBuilding(friendlyUnit.gridIndex);
+	}
 
+	if(friendlyUnit.hasCombatPower)
+	{
+		if(modifier > 0.0f)
+			m_sectorGrid.AddFriendlyCombatUnit(friendlyUnit.gridIndex, friendlyUnit.combatPower);
+		else
+			m_sectorGrid.RemoveFriendlyCombatUnit(friendlyUnit.gridIndex, friendlyUnit.combatPower);
+	}
+}
+
+void AAIMap::UpdateEnemyScoutingData()
+{
 	const int currentFrame = ai->GetAICallback()->GetCurrentFrame();
 	
-	// map of known enemy buildings has been updated -> update sector data
+	// map of known enemy buildings has been updated -> update data of sectors with modified tiles (or enemy combat units 
+	// whose values depend on the time since they have been scouted/the current combat power of their unit type)
 	for(int y = 0; y < ySectors; ++y)
 	{
 		for(int x = 0; x < xSectors; ++x)
 		{
-			m_sectorMap[x][y].ResetScoutedEnemiesData();
+			AAISector& sector = m_sectorMap[x][y];
 
-			m_scoutedEnemyUnitsMap.UpdateSectorWithScoutedUnits(&m_sectorMap[x][y], m_buildingsOnContinent, currentFrame);
+			if( m_scoutedEnemyUnitsMap.HasSectorChanged(sector.GetSectorIndex()) || (sector.GetTotalEnemyCombatUnits() > 0.0f) )
+			{
+				sector.ResetScoutedEnemiesData();
+				m_scoutedEnemyUnitsMap.UpdateSectorWithScoutedUnits(&sector, currentFrame);
+			}
 		}
 	}
 }
@@ -1755,33 +2243,46 @@ float3 AAIMap::DeterminePositionOfEnemyBuildingInSector(int xStart, int xEnd, in
 	return selectedPosition;
 }
 
-void AAIMap::UpdateSectors(AAIThreatMap *threatMap)
+bool AAIMap::UpdateSectors(AAIThreatMap *threatMap)
 {
-	int scoutedEnemyBuildings(0);
-	MapPos sectorLocationOfEnemyBuidlings(0, 0);
+	if(m_nextSectorRowToUpdate == 0)
+	{
+		m_sectorGrid.DecreaseLostUnits(AAIConstants::lostUnitsMemoryFadeRate);
 
-	for(int x = 0; x < xSectors; ++x)
+		m_scoutedEnemyBuildings = 0;
+		m_sectorLocationOfEnemyBuildings = MapPos(0, 0);
+	}
+
+	const int lastRow = std::min(m_nextSectorRowToUpdate + AAIConstants::sectorRowsPerUpdate, ySectors);
+
+	for(int y = m_nextSectorRowToUpdate; y < lastRow; ++y)
 	{
-		for(int y = 0; y < ySectors; ++y)
+		for(int x = 0; x < xSectors; ++x)
 		{
-			m_sectorMap[x][y].DecreaseLostUnits();
-
-			const int enemyBuildings = m_sectorMap[x][y].GetNumberOfEnemyBuildings();
+			const int enemyBuildings = m_sectorGrid.GetEnemyBuildings( m_sectorGrid.GetIndex(x, y) );
 			if(enemyBuildings > 0)
 			{
-				scoutedEnemyBuildings += enemyBuildings;
+				m_scoutedEnemyBuildings += enemyBuildings;
 
-				sectorLocationOfEnemyBuidlings.x += enemyBuildings * x;
-				sectorLocationOfEnemyBuidlings.y += enemyBuildings * y;
+				m_sectorLocationOfEnemyBuildings.x += enemyBuildings * x;
+				m_sectorLocationOfEnemyBuildings.y += enemyBuildings * y;
 			}
 		}
 	}
 
-	if(scoutedEnemyBuildings > 0)
+	if(lastRow < ySectors)
 	{
-		m_centerOfEnemyBase.x =   static_cast<float>(xSectorSizeMap * sectorLocationOfEnemyBuidlings.x) / static_cast<float>(scoutedEnemyBuildings) 
+		m_nextSectorRowToUpdate = lastRow;
+		return false;
+	}
+
+	m_nextSectorRowToUpdate = 0;
+
+	if(m_scoutedEnemyBuildings > 0)
+	{
+		m_centerOfEnemyBase.x =   static_cast<float>(xSectorSizeMap * m_sectorLocationOfEnemyBuildings.x) / static_cast<float>(m_scoutedEnemyBuildings) 
 								+ static_cast<float>(xSectorSizeMap/2);
-		m_centerOfEnemyBase.y =   static_cast<float>(ySectorSizeMap * sectorLocationOfEnemyBuidlings.y) / static_cast<float>(scoutedEnemyBuildings) 
+		m_centerOfEnemyBase.y =   static_cast<float>(ySectorSizeMap * m_sectorLocationOfEnemyBuildings.y) / static_cast<float>(m_scoutedEnemyBuildings) 
 								+ static_cast<float>(ySectorSizeMap/2);
 	}
 
@@ -1791,6 +2292,8 @@ void AAIMap::UpdateSectors(AAIThreatMap *threatMap)
 		ai->Log("%i: %i   ", static_cast<int>(continentId), m_buildingsOnContinent[continentId]);
 	}
 	ai->Log("\n");*/
+
+	return true;
 }
 
 float AAIMap::GetDistanceToCenterOfEnemyBase(const float3& position) const
@@ -17,8 +17,11 @@
 #include "AAIThreatMap.h"
 #include "AAIUnitTypes.h"
 #include "AAISector.h"
+#include "AAIEnemyUnitRegistry.h"
+#include "AAIFriendlyUnitRegistry.h"
 #include "System/float3.h"
 
+#include <functional>
 #include <vector>
 #include <list>
 #include <string>
@@ -39,6 +42,9 @@ public:
 	//! @brief Returns the map containing the sectors
 	SectorMap& GetSectorMap() { return m_sectorMap; }
 
+	//! @brief Returns the grid storing the values of all sectors that are evaluated for all sectors at once (e.g. combat power)
+	const AAISectorGrid& GetSectorGrid() const { return m_sectorGrid; }
+
 	//! @brief Returns max distance (in sectors) a sector can have to base
 	int GetMaxSectorDistanceToBase() const { return (xSectors + ySectors - 2); }
 
@@ -123,6 +129,27 @@ public:
 
 	//! @brief Triggers an update of the current units in LOS if there are enough frames since the last update or it is enforced
 	void CheckUnitsInLOSUpdate(bool forceUpdate = false);
+
+	//! @brief Registers enemy unit that entered LOS (checks whether it is a suitable bomb target)
+	void EnemyEnteredLOS(UnitId unitId);
+
+	//! @brief Registers enemy unit that left LOS
+	void EnemyLeftLOS(UnitId unitId);
+
+	//! @brief Registers enemy unit that entered radar coverage
+	void EnemyEnteredRadar(UnitId unitId);
+
+	//! @brief Registers enemy unit that left radar coverage
+	void EnemyLeftRadar(UnitId unitId);
+
+	//! @brief Removes destroyed enemy unit from registry
+	void EnemyDestroyed(UnitId unitId);
+
+	//! @brief Adds combat power/building of finished own unit to the sector it is located in
+	void FriendlyUnitFinished(UnitId unitId, UnitDefId unitDefId);
+
+	//! @brief Removes combat power/building of destroyed own unit from the sector it has been located in
+	void FriendlyUnitDestroyed(UnitId unitId);
 	
 	//! @brief Returns whether given unit is still known to be at given position (used to detect buildings that have been destroyed while not within LOS)
 	bool CheckPositionForScoutedUnit(const float3& position, UnitId unitId);
@@ -140,7 +167,8 @@ public:
 	float3 DeterminePositionOfEnemyBuildingInSector(int xStart, int xEnd, int yStart, int yEnd) const;
 
 	//! @brief Decreases the lost units and updates the the "center of gravity" of the enemy base(s)
-	void UpdateSectors(AAIThreatMap *threatMap);
+	//!        Processes a limited number of rows of sectors per call - returns true if all sectors have been updated, false if update shall be continued
+	bool UpdateSectors(AAIThreatMap *threatMap);
 
 	//! @brief Checks for new neighbours (and removes old ones if necessary)
 	void UpdateNeighbouringSectors(std::vector< std::list<AAISector*> >& sectorsInDistToBase);
@@ -184,6 +212,9 @@ public:
 	//! Number of metal spots on land
 	static int s_metalSpotsOnLand;
 
+	//! All metal spots of the map (including spatial index and free spots per continent)
+	static AAIMetalSpotMap s_metalSpots;
+
 	//! Indicates if map is considered to be a metal map (i.e. exctractors can be built anywhere)
 	static bool s_isMetalMap;
 
@@ -193,21 +224,52 @@ public:
 	//! The buildmap stores the type/occupation status of every cell;
 	static std::vector<BuildMapTileType> s_buildmap;
 
+	//! Bit planes of the buildmap (must be updated whenever the buildmap is changed) used for fast checks of possible build sites
+	static AAIBuildMapBitPlanes s_buildMapBitPlanes;
+
 	static constexpr int ignoreContinentID = -1;
 
 private:
 	//! @brief Updates spotted enemy buildings/units on the map (incl. data per sector)
 	void UpdateEnemyUnitsInLOS();
 
-	//! @brief Updates own/allied buildings/units on the map (in each sector)
+	//! @brief Moves the enemy unit to the given sector (grid index, -1 for none) in which it is counted as detected by sensor
+	void UpdateSensorContact(EnemyUnitInfo& enemyUnit, int gridIndex);
+
+	//! @brief Updates sectors of own mobile units (and of allied units every n-th call, see UpdateAlliedUnits())
 	void UpdateFriendlyUnitsInLos();
 
+	//! @brief Updates sectors of allied mobile units and adds/removes allied units that appeared/disappeared since last update
+	void UpdateAlliedUnits();
+
+	//! @brief Starts tracking the given own/allied unit and adds its combat power/building to the sector it is located in
+	void AddFriendlyUnit(UnitId unitId, UnitDefId unitDefId, bool ownUnit, const float3& position);
+
+	//! @brief Stops tracking the given unit and removes its combat power/building from the sector it has been located in
+	void RemoveFriendlyUnit(UnitId unitId);
+
+	//! @brief Moves combat power/building of the given unit to the given sector (grid index, -1 for none)
+	void MoveFriendlyUnit(FriendlyUnitInfo& friendlyUnit, int gridIndex);
+
+	//! @brief Adds (modifier = 1) or removes (modifier = -1) combat power/building of the given unit to/from the sector it is located in
+	void ApplyFriendlyUnitToSector(const FriendlyUnitInfo& friendlyUnit, float modifier);
+
 	//! @brief Updates enemy buildings/enemy combat power in sectors based on scout map entris updated by UpdateEnemyUnitsInLOS()
 	void UpdateEnemyScoutingData();
 
 	//! @brief Helper function to check if the given building may be constructed at the given map position
 	BuildSite CheckIfSuitableBuildSite(const UnitFootprint& footprint, const springLegacyAI::UnitDef* unitDef, const MapPos& mapPos) const;
 
+	//! @brief Returns whether the engine allows construction of the given building at the given (final) build site (uses cached results if available)
+	bool CanEngineBuildAt(const springLegacyAI::UnitDef* unitDef, const float3& buildsite) const;
+
+	//! @brief Checks the highest rated candidates with the engine and returns the best valid one (only a limited number of candidates is checked)
+	BuildSite SelectBestRatedBuildsite(std::vector<BuildSiteCandidate>& candidates, const UnitFootprint& footprint, const springLegacyAI::UnitDef* unitDef) const;
+
+	//! @brief Inserts the candidate into the given list of best rated candidates (sorted by descending rating, limited to given number). Candidates whose
+	//!        footprints would overlap with a better rated one are skipped, i.e. the list contains distinct build sites instead of neighbouring tiles
+	static void InsertIntoBestRatedCandidates(std::vector<BuildSiteCandidate>& candidates, const BuildSiteCandidate& candidate, const UnitFootprint& footprint, int maxCandidates);
+
 	//! @brief Converts the given position (in map coordinates) to a position in buildmap coordinates
 	void Pos2BuildMapPos(float3* position, const springLegacyAI::UnitDef* def) const;
 
@@ -223,6 +285,10 @@ private:
 	//! @brief Determine the type of every map tile (e.g. water, flat. cliff) and calculates the plateue map
 	void AnalyseMap();
 
+	//! @brief Splits the given number of rows into bands and calls processRows(firstRow, endRow) for each band in a separate thread
+	//!        (processRows must not call the engine and must only write to data belonging to the given rows)
+	static void ProcessRowsInParallel(int numberOfRows, const std::function<void(int, int)>& processRows);
+
 	//! @brief Determines the type of map
 	void DetermineMapType();
 
@@ -232,15 +298,36 @@ private:
 	//! @brief Read the learning data for this map (or initialize with defualt data if none are available)
 	void ReadMapLearnFile();
 
-	//! 
-	void InitContinents();
+	//! @brief Resets the map data shared by all AAI instances (called when last user is deleted)
+	static void ReleaseSharedMapData();
+
+	//! @brief Loads continent data from cache file or detects continents (and stores them to a new cache file) if not available
+	void InitContinents(uint64_t mapHash);
 
-	//! @brief Reads continent data from given cache file (returns whether successful)
+	//! @brief Reads continent data from given (binary) cache file (returns whether successful)
+	bool ReadBinaryContinentFile(const std::string& filename, uint64_t mapHash);
+
+	//! @brief Reads continent data from given cache file in previous text based format (returns whether successful)
 	bool ReadContinentFile(const std::string& filename);
 
+	//! @brief Stores continent data to given (binary) cache file
+	void SaveContinentFile(const std::string& filename, uint64_t mapHash) const;
+
 	// reads map cache file (and creates new one if necessary)
 	// loads mex spots, cliffs etc. from file or creates new one
-	void ReadMapCacheFile();
+	void ReadMapCacheFile(uint64_t mapHash);
+
+	//! @brief Reads map data (buildmap, plateau map, metal spots, ...) from given (binary) cache file (returns whether successful)
+	bool ReadBinaryMapCacheFile(const std::string& filename, uint64_t mapHash);
+
+	//! @brief Reads map data from given cache file in previous text based format (returns whether successful)
+	bool ReadTextMapCacheFile(const std::string& filename);
+
+	//! @brief Stores map data to given (binary) cache file
+	void SaveMapCacheFile(const std::string& filename, uint64_t mapHash) const;
+
+	//! @brief Returns hash of height and metal map (used to detect outdated cache files)
+	uint64_t CalculateMapHash() const;
 
 	//! @brief Returns whether x/y specify a valid sector
 	bool IsValidSector(const SectorIndex& index) const { return( (index.x >= 0) && (index.y >= 0) && (index.x < xSectors) && (index.y < ySectors) ); }
@@ -274,16 +361,25 @@ private:
 	}
 
 	std::string LocateMapLearnFile() const;
-	std::string LocateMapCacheFile() const;
+	std::string LocateMapCacheFile(bool binaryFormat) const;
 
 	AAI *ai;
 
 	//! The sectors of the map
 	SectorMap          m_sectorMap;
 
+	//! Combat power, lost units and number of buildings of all sectors (accessed via the sectors or for operations on all sectors)
+	AAISectorGrid      m_sectorGrid;
+
 	//! Used for scouting, stores all friendly/enemy units with current line of sight
 	std::vector<int>   m_unitsInLOS;
 
+	//! Enemy units within LOS/radar coverage (updated by the corresponding events)
+	AAIEnemyUnitRegistry m_enemyUnits;
+
+	//! Own/allied buildings and combat units accounted for in the sectors (own units updated by events, allied ones by UpdateFriendlyUnitsInLos())
+	AAIFriendlyUnitRegistry m_friendlyUnits;
+
 	//! Stores the defId of the building or combat unit placed on that cell (0 if none), same resolution as los map
 	AAIScoutedUnitsMap m_scoutedEnemyUnitsMap;
 
@@ -296,10 +392,28 @@ private:
 	//! The frame in which the last update of the units in LOS has been performed
 	int                m_lastLOSUpdateInFrame;
 
+	//! Number of updates of the friendly units in LOS (allied units only updated every n-th time)
+	int                m_friendlyUnitsUpdates;
+
+	//! Next row of sectors to be processed by UpdateSectors() (0 if no update in progress)
+	int                m_nextSectorRowToUpdate;
+
+	//! Number of scouted enemy buildings in the rows of sectors processed so far by the current update of the sectors
+	int                m_scoutedEnemyBuildings;
+
+	//! Sum of the sector coordinates of the scouted enemy buildings (weighted by number of buildings) processed so far by the current update of the sectors
+	MapPos             m_sectorLocationOfEnemyBuildings;
+
+	//! Results of recent checks of build sites by the engine
+	mutable AAIBuildSiteValidationCache m_buildSiteValidationCache;
+
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// static (shared with other ai players)
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+	//! Number of AAIMap instances using the shared map data (data created by first user and released by last one)
+	static int s_mapDataUsers;
+
 	//! The defence maps (storing combat power by static defences vs the different mobile target types)
 	static AAIDefenceMaps s_defenceMaps;
 
@@ -315,7 +429,6 @@ private:
 	static int losMapResolution;				// resolution of the LOS map
 	static int xLOSMapSize, yLOSMapSize;		// x and y size of the LOS map
 	static int xDefMapSize, yDefMapSize;		// x and y size of the defence maps (1/4 resolution of map)
-	static std::list<AAIMetalSpot> metal_spots;
 
 	static std::vector<int>   blockmap;		// number of buildings which ordered a cell to blocked
 	static std::vector<float> plateau_map;	// positive values indicate plateaus, same resolution as continent map 1/4 of resolution of blockmap/buildmap
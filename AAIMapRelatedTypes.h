@@ -31,6 +31,15 @@ struct MapPos
 	int y;
 };
 
+//! A possible build site (in build map coordinates) with its rating - used to rank build sites before checking them with the engine
+struct BuildSiteCandidate
+{
+	BuildSiteCandidate(const MapPos& position, float buildSiteRating) : mapPos(position), rating(buildSiteRating) {}
+
+	MapPos mapPos;
+	float  rating;
+};
+
 //! A continent is made up of  tiles of the same type (land or water) that are connected with each other
 struct AAIContinent
 {
@@ -11,21 +11,26 @@
 #include "AAIConfig.h"
 #include "AAIMap.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 void AAIDefenceMaps::Init(int xMapSize, int yMapSize)
 { 
 	m_xDefenceMapSize = xMapSize/defenceMapResolution;
 	m_yDefenceMapSize = yMapSize/defenceMapResolution;
-	m_defenceMaps.resize(AAITargetType::numberOfMobileTargetTypes, std::vector<float>(m_xDefenceMapSize*m_yDefenceMapSize, 0.0f) );
+	m_defenceMaps.resize(numberOfLanes * m_xDefenceMapSize * m_yDefenceMapSize, 0.0f);
 }
 
 void AAIDefenceMaps::ModifyTiles(const float3& position, float maxWeaponRange, const UnitFootprint& footprint, const TargetTypeValues& combatPower, bool addValues)
 {
-	// decide which function shall be used to modify tile values
-	void (AAIDefenceMaps::*modifyDefenceMapTile) (int , const TargetTypeValues& ) = addValues ? &AAIDefenceMaps::AddDefence : &AAIDefenceMaps::RemoveDefence;
+	int xPos, yPos, range;
+	DetermineCenterAndRange(position, maxWeaponRange, footprint, xPos, yPos, range);
+
+	const std::vector<int>& stencil = GetDiscStencil(range);
 
-	const int range = static_cast<int>(maxWeaponRange) / (SQUARE_SIZE * defenceMapResolution);
-	const int xPos  = static_cast<int>(position.x) / (SQUARE_SIZE * defenceMapResolution) + footprint.xSize/defenceMapResolution;
-	const int yPos  = static_cast<int>(position.z) / (SQUARE_SIZE * defenceMapResolution) + footprint.ySize/defenceMapResolution;
+	float values[numberOfLanes];
+	DetermineLaneValues(combatPower, addValues ? 1.0f : -1.0f, values);
 
 	// x range will change from line to line -  y range is const
 	const int yStart = std::max(yPos - range, 0);
@@ -33,70 +38,381 @@ void AAIDefenceMaps::ModifyTiles(const float3& position, float maxWeaponRange, c
 
 	for(int y = yStart; y < yEnd; ++y)
 	{
-		// determine x-range
-		const int xRange = (int) floor( fastmath::apxsqrt2( (float) ( std::max(1, range * range - (y - yPos) * (y - yPos)) ) ) + 0.5f );
+		const int xRange = stencil[y - yPos + range];
 
 		const int xStart = std::max(xPos - xRange, 0);
 		const int xEnd   = std::min(xPos + xRange, m_xDefenceMapSize);
 
-		for(int x = xStart; x < xEnd; ++x)
+		if(xEnd > xStart)
+			ModifyRowSpan(&m_defenceMaps[numberOfLanes * (xStart + m_xDefenceMapSize*y)], xEnd - xStart, values, !addValues);
+	}
+}
+
+void AAIDefenceMaps::DetermineCenterAndRange(const float3& position, float maxWeaponRange, const UnitFootprint& footprint, int& xPos, int& yPos, int& range) const
+{
+	range = static_cast<int>(maxWeaponRange) / (SQUARE_SIZE * defenceMapResolution);
+	xPos  = static_cast<int>(position.x) / (SQUARE_SIZE * defenceMapResolution) + footprint.xSize/defenceMapResolution;
+	yPos  = static_cast<int>(position.z) / (SQUARE_SIZE * defenceMapResolution) + footprint.ySize/defenceMapResolution;
+}
+
+void AAIDefenceMaps::DetermineLaneValues(const TargetTypeValues& combatPower, float sign, float* values)
+{
+	values[AAITargetType::surfaceIndex]   = sign * combatPower.GetValue(ETargetType::SURFACE);
+	values[AAITargetType::airIndex]       = sign * combatPower.GetValue(ETargetType::AIR);
+	values[AAITargetType::floaterIndex]   = sign * combatPower.GetValue(ETargetType::FLOATER);
+	values[AAITargetType::submergedIndex] = sign * combatPower.GetValue(ETargetType::SUBMERGED);
+}
+
+const std::vector<int>& AAIDefenceMaps::GetDiscStencil(int range)
+{
+	if(range >= static_cast<int>(m_discStencils.size()))
+		m_discStencils.resize(range+1);
+
+	std::vector<int>& stencil = m_discStencils[range];
+
+	if(stencil.empty() && (range > 0))
+	{
+		stencil.resize(2 * range);
+
+		for(int dy = -range; dy < range; ++dy)
+			stencil[dy + range] = (int) floor( fastmath::apxsqrt2( (float) ( std::max(1, range * range - dy * dy) ) ) + 0.5f );
+	}
+
+	return stencil;
+}
+
+void AAIDefenceMaps::ModifyRowSpan(float* tiles, int numberOfTiles, const float* values, bool clampToZero)
+{
+	static_assert(numberOfLanes == 4, "Number of lanes does not fit to implementation");
+
+	const float v0 = values[0], v1 = values[1], v2 = values[2], v3 = values[3];
+	float* const end = tiles + numberOfLanes * numberOfTiles;
+
+	// one tile corresponds to one 4-float vector -> loops are vectorized by the compiler
+	if(clampToZero)
+	{
+		for(float* tile = tiles; tile < end; tile += numberOfLanes)
+		{
+			tile[0] = std::max(tile[0] + v0, 0.0f);
+			tile[1] = std::max(tile[1] + v1, 0.0f);
+			tile[2] = std::max(tile[2] + v2, 0.0f);
+			tile[3] = std::max(tile[3] + v3, 0.0f);
+		}
+	}
+	else
+	{
+		for(float* tile = tiles; tile < end; tile += numberOfLanes)
 		{
-			const int tile = x + m_xDefenceMapSize*y;
-			(this->*modifyDefenceMapTile)(tile, combatPower);
+			tile[0] += v0;
+			tile[1] += v1;
+			tile[2] += v2;
+			tile[3] += v3;
 		}
 	}
 }
 
-void AAIDefenceMaps::AddDefence(int tile, const TargetTypeValues& combatPower)
+void AAIBuildMapBitPlanes::Init(int xMapSize, int yMapSize)
 {
-	m_defenceMaps[AAITargetType::surfaceIndex][tile]   += combatPower.GetValue(ETargetType::SURFACE);
-	m_defenceMaps[AAITargetType::airIndex][tile]       += combatPower.GetValue(ETargetType::AIR);
-	m_defenceMaps[AAITargetType::floaterIndex][tile]   += combatPower.GetValue(ETargetType::FLOATER);
-	m_defenceMaps[AAITargetType::submergedIndex][tile] += combatPower.GetValue(ETargetType::SUBMERGED);
+	m_wordsPerRow   = (xMapSize + 63) / 64;
+	m_wordsPerPlane = m_wordsPerRow * yMapSize;
+	m_bitPlanes.resize(numberOfPlanes * m_wordsPerPlane, 0u);
 }
 
-void AAIDefenceMaps::RemoveDefence(int tile, const TargetTypeValues& combatPower)
+void AAIBuildMapBitPlanes::SetFromBuildMap(const std::vector<BuildMapTileType>& buildmap)
 {
-	m_defenceMaps[AAITargetType::surfaceIndex][tile]   -= combatPower.GetValue(ETargetType::SURFACE);
-	m_defenceMaps[AAITargetType::airIndex][tile]       -= combatPower.GetValue(ETargetType::AIR);
-	m_defenceMaps[AAITargetType::floaterIndex][tile]   -= combatPower.GetValue(ETargetType::FLOATER);
-	m_defenceMaps[AAITargetType::submergedIndex][tile] -= combatPower.GetValue(ETargetType::SUBMERGED);
+	std::fill(m_bitPlanes.begin(), m_bitPlanes.end(), 0u);
+
+	const int xMapSize = AAIMap::xMapSize;
+	const int yMapSize = AAIMap::yMapSize;
 
-	for(int targetTypeIndex = 0; targetTypeIndex < AAITargetType::numberOfMobileTargetTypes; ++targetTypeIndex)
+	for(int y = 0; y < yMapSize; ++y)
 	{
-		if(m_defenceMaps[targetTypeIndex][tile] < 0.0f)
-			m_defenceMaps[targetTypeIndex][tile] = 0.0f;
+		for(int x = 0; x < xMapSize; ++x)
+		{
+			const uint8_t tileType = buildmap[x + y * xMapSize].m_tileType;
+			const int     word     = y * m_wordsPerRow + x / 64;
+			const uint64_t bit     = static_cast<uint64_t>(1u) << (x % 64);
+
+			for(int plane = 0; plane < numberOfPlanes; ++plane)
+			{
+				if(tileType & (1u << plane))
+					m_bitPlanes[plane * m_wordsPerPlane + word] |= bit;
+			}
+		}
 	}
 }
 
+void AAIBuildMapBitPlanes::UpdateTile(int x, int y, const BuildMapTileType& tileType)
+{
+	const int      word = y * m_wordsPerRow + x / 64;
+	const uint64_t bit  = static_cast<uint64_t>(1u) << (x % 64);
+
+	for(int plane = 0; plane < numberOfPlanes; ++plane)
+	{
+		if(tileType.m_tileType & (1u << plane))
+			m_bitPlanes[plane * m_wordsPerPlane + word] |= bit;
+		else
+			m_bitPlanes[plane * m_wordsPerPlane + word] &= ~bit;
+	}
+}
+
+bool AAIBuildMapBitPlanes::IsAnyTileTypeSet(int xStart, int yStart, int xSize, int ySize, const BuildMapTileType& tileTypes) const
+{
+	if( (xSize <= 0) || (ySize <= 0) )
+		return false;
+
+	const int xLast     = xStart + xSize - 1;
+	const int firstWord = xStart / 64;
+	const int lastWord  = xLast  / 64;
+
+	const uint64_t firstWordMask = ~static_cast<uint64_t>(0u) << (xStart % 64);
+	const uint64_t lastWordMask  = ~static_cast<uint64_t>(0u) >> (63 - (xLast % 64));
+
+	for(int plane = 0; plane < numberOfPlanes; ++plane)
+	{
+		if( (tileTypes.m_tileType & (1u << plane)) == 0)
+			continue;
+
+		const uint64_t* row = &m_bitPlanes[plane * m_wordsPerPlane + yStart * m_wordsPerRow];
+
+		for(int y = 0; y < ySize; ++y)
+		{
+			if(firstWord == lastWord)
+			{
+				if(row[firstWord] & firstWordMask & lastWordMask)
+					return true;
+			}
+			else
+			{
+				if( (row[firstWord] & firstWordMask) || (row[lastWord] & lastWordMask) )
+					return true;
+
+				for(int word = firstWord + 1; word < lastWord; ++word)
+				{
+					if(row[word])
+						return true;
+				}
+			}
+
+			row += m_wordsPerRow;
+		}
+	}
+
+	return false;
+}
+
+void AAIBuildMapBitPlanes::DetermineFreeBuildPositions(int xStart, int yStart, int xSize, int ySize, const UnitFootprint& footprint, AAIFrameVector<uint8_t>& freePositions) const
+{
+	freePositions.assign(xSize * ySize, 0u);
+
+	if( (xSize <= 0) || (ySize <= 0) || (footprint.xSize <= 0) || (footprint.ySize <= 0) )
+		return;
+
+	// tiles that may be covered by a building placed at any of the positions (clipped to the map)
+	const int xTileStart = std::max(xStart, 0);
+	const int yTileStart = std::max(yStart, 0);
+	const int xTileEnd   = std::min(xStart + xSize + footprint.xSize - 1, AAIMap::xMapSize);
+	const int yTileEnd   = std::min(yStart + ySize + footprint.ySize - 1, AAIMap::yMapSize);
+
+	if( (xTileEnd <= xTileStart) || (yTileEnd <= yTileStart) )
+		return;
+
+	// number of blocked tiles within the last footprint.ySize rows for every column
+	AAIFrameVector<int> blockedTilesInColumn(xTileEnd - xTileStart, 0, freePositions.get_allocator());
+
+	const auto updateColumns = [&](int y, int change)
+	{
+		for(int x = xTileStart; x < xTileEnd; )
+		{
+			// combine the bit planes of all invalid tile types
+			const int word = y * m_wordsPerRow + x / 64;
+			uint64_t  blockedTiles(0u);
+
+			for(int plane = 0; plane < numberOfPlanes; ++plane)
+			{
+				if(footprint.invalidTileTypes.m_tileType & (1u << plane))
+					blockedTiles |= m_bitPlanes[plane * m_wordsPerPlane + word];
+			}
+
+			const int wordEnd = std::min((x / 64 + 1) * 64, xTileEnd);
+
+			for(; x < wordEnd; ++x)
+			{
+				if(blockedTiles & (static_cast<uint64_t>(1u) << (x % 64)))
+					blockedTilesInColumn[x - xTileStart] += change;
+			}
+		}
+	};
+
+	for(int y = yTileStart; y < yTileEnd; ++y)
+	{
+		updateColumns(y, 1);
+
+		if(y - footprint.ySize >= yTileStart)
+			updateColumns(y - footprint.ySize, -1);
+
+		// row of positions whose footprint ends in current row
+		const int yPos = y - footprint.ySize + 1;
+
+		if( (yPos < yStart) || (yPos < 0) )
+			continue;
+
+		// slide window of footprint.xSize columns over the row
+		uint8_t* freePositionsRow = &freePositions[(yPos - yStart) * xSize];
+		int blockedTilesInWindow(0);
+
+		for(int x = xTileStart; x < xTileEnd; ++x)
+		{
+			blockedTilesInWindow += blockedTilesInColumn[x - xTileStart];
+
+			if(x - footprint.xSize >= xTileStart)
+				blockedTilesInWindow -= blockedTilesInColumn[x - footprint.xSize - xTileStart];
+
+			const int xPos = x - footprint.xSize + 1;
+
+			if( (xPos >= xTileStart) && (xPos < xStart + xSize) && (blockedTilesInWindow == 0) )
+				freePositionsRow[xPos - xStart] = 1u;
+		}
+	}
+}
+
+bool AAIBuildSiteValidationCache::GetCachedResult(int unitDefId, const float3& buildsite, int frame, bool& canBuild) const
+{
+	const auto cachedResult = m_cachedResults.find( GetKey(unitDefId, buildsite) );
+
+	if( (cachedResult != m_cachedResults.end()) && (frame - cachedResult->second.frame <= AAIConstants::maxBuildsiteValidationCacheAge) )
+	{
+		canBuild = cachedResult->second.canBuild;
+		return true;
+	}
+	else
+		return false;
+}
+
+void AAIBuildSiteValidationCache::AddResult(int unitDefId, const float3& buildsite, int frame, bool canBuild)
+{
+	if(m_cachedResults.size() >= static_cast<size_t>(AAIConstants::maxBuildsiteValidationCacheSize))
+	{
+		for(auto cachedResult = m_cachedResults.begin(); cachedResult != m_cachedResults.end(); )
+		{
+			if(frame - cachedResult->second.frame > AAIConstants::maxBuildsiteValidationCacheAge)
+				cachedResult = m_cachedResults.erase(cachedResult);
+			else
+				++cachedResult;
+		}
+
+		if(m_cachedResults.size() >= static_cast<size_t>(AAIConstants::maxBuildsiteValidationCacheSize))
+			m_cachedResults.clear();
+	}
+
+	CachedResult& cachedResult = m_cachedResults[ GetKey(unitDefId, buildsite) ];
+	cachedResult.frame    = frame;
+	cachedResult.canBuild = canBuild;
+}
+
+uint64_t AAIBuildSiteValidationCache::GetKey(int unitDefId, const float3& buildsite)
+{
+	// final build sites are snapped to multiples of SQUARE_SIZE
+	const uint64_t x = static_cast<uint64_t>( static_cast<int>(buildsite.x) / SQUARE_SIZE ) & 0xFFFFu;
+	const uint64_t z = static_cast<uint64_t>( static_cast<int>(buildsite.z) / SQUARE_SIZE ) & 0xFFFFu;
+
+	return (static_cast<uint64_t>(unitDefId) << 32) | (x << 16) | z;
+}
+
 AAIScoutedUnitsMap::AAIScoutedUnitsMap(int xMapSize, int yMapSize, int losMapResolution) :
 	m_xScoutMapSize(xMapSize / scoutMapResolution),
 	m_yScoutMapSize(yMapSize / scoutMapResolution),
-	m_losToScoutMapResolution(losMapResolution / scoutMapResolution),
+	m_losMapResolution(losMapResolution),
 	m_scoutedUnitsMap(m_xScoutMapSize*m_yScoutMapSize, 0),
-	m_lastUpdateInFrameMap(m_xScoutMapSize*m_yScoutMapSize, 0)
+	m_lastUpdateInFrameMap(m_xScoutMapSize*m_yScoutMapSize, 0),
+	m_occupiedTilesListIndex(m_xScoutMapSize*m_yScoutMapSize, -1),
+	m_xSectors(0)
 {
 }
 
-void AAIScoutedUnitsMap::ResetTiles(int xLosMap, int yLosMap, int frame)
+void AAIScoutedUnitsMap::InitSectorLookupTables(int xSectors, int ySectors, int xSectorSizeMap, int ySectorSizeMap)
 {
-	int tileIndex = xLosMap*m_losToScoutMapResolution + yLosMap*m_losToScoutMapResolution * m_xScoutMapSize;
+	m_xSectors = xSectors;
+	m_sectorChanged.resize(xSectors*ySectors, true);
 
-	for(int y = 0; y < m_losToScoutMapResolution; ++y)
+	// same tiles per sector as used in UpdateSectorWithScoutedUnits()
+	m_xTileToSector.resize(m_xScoutMapSize, -1);
+	m_yTileToSector.resize(m_yScoutMapSize, -1);
+
+	for(int x = 0; x < xSectors; ++x)
 	{
-		for(int x = 0; x < m_losToScoutMapResolution; ++x)
-		{
-			m_scoutedUnitsMap[tileIndex]      = 0;
-			m_lastUpdateInFrameMap[tileIndex] = frame;
+		const int xStart = (x * xSectorSizeMap) / scoutMapResolution;
 
-			++tileIndex;
+		for(int xTile = xStart; xTile < std::min(xStart + xSectorSizeMap/scoutMapResolution, m_xScoutMapSize); ++xTile)
+			m_xTileToSector[xTile] = x;
+	}
+
+	for(int y = 0; y < ySectors; ++y)
+	{
+		const int yStart = (y * ySectorSizeMap) / scoutMapResolution;
+
+		for(int yTile = yStart; yTile < std::min(yStart + ySectorSizeMap/scoutMapResolution, m_yScoutMapSize); ++yTile)
+			m_yTileToSector[yTile] = y;
+	}
+}
+
+void AAIScoutedUnitsMap::ResetTilesInLOS(const int* losMap, int xLOSMapSize, std::vector<int>& unitsOnContinent, int frame)
+{
+	// iterate backwards as reset tiles are removed from the list (last element is moved to position of removed one)
+	for(int i = static_cast<int>(m_occupiedTiles.size()) - 1; i >= 0; --i)
+	{
+		const int tileIndex = m_occupiedTiles[i];
+		const int xLOSMap   = (tileIndex % m_xScoutMapSize) * scoutMapResolution / m_losMapResolution;
+		const int yLOSMap   = (tileIndex / m_xScoutMapSize) * scoutMapResolution / m_losMapResolution;
+
+		if(losMap[xLOSMap + yLOSMap * xLOSMapSize] > 0)
+			SetTile(tileIndex, 0, unitsOnContinent, frame);
+	}
+}
+
+void AAIScoutedUnitsMap::SetTile(int tileIndex, int unitDefId, std::vector<int>& unitsOnContinent, int frame)
+{
+	const int  xTile              = tileIndex % m_xScoutMapSize;
+	const int  yTile              = tileIndex / m_xScoutMapSize;
+	const bool previouslyOccupied = (m_scoutedUnitsMap[tileIndex] > 0);
+	const bool occupied           = (unitDefId > 0);
+
+	const int xSector = m_xTileToSector[xTile];
+	const int ySector = m_yTileToSector[yTile];
+
+	// units on tiles not belonging to any sector are never taken into account
+	if( (xSector >= 0) && (ySector >= 0) )
+	{
+		m_sectorChanged[xSector + ySector * m_xSectors] = true;
+
+		if(previouslyOccupied != occupied)
+		{
+			const int continentId = AAIMap::s_continentMap.GetContinentID( MapPos(xTile*scoutMapResolution, yTile*scoutMapResolution) );
+			unitsOnContinent[continentId] += occupied ? 1 : -1;
 		}
+	}
+
+	if(occupied && !previouslyOccupied)
+	{
+		m_occupiedTilesListIndex[tileIndex] = static_cast<int>(m_occupiedTiles.size());
+		m_occupiedTiles.push_back(tileIndex);
+	}
+	else if(!occupied && previouslyOccupied)
+	{
+		const int listIndex = m_occupiedTilesListIndex[tileIndex];
+		const int lastTile  = m_occupiedTiles.back();
 
-		tileIndex += (m_xScoutMapSize-m_losToScoutMapResolution);
+		m_occupiedTiles[listIndex]          = lastTile;
+		m_occupiedTilesListIndex[lastTile]  = listIndex;
+		m_occupiedTiles.pop_back();
+		m_occupiedTilesListIndex[tileIndex] = -1;
 	}
+
+	m_scoutedUnitsMap[tileIndex]      = unitDefId;
+	m_lastUpdateInFrameMap[tileIndex] = frame;
 }
 
-void AAIScoutedUnitsMap::UpdateSectorWithScoutedUnits(AAISector *sector, std::vector<int>& buildingsOnContinent, int currentFrame)
+void AAIScoutedUnitsMap::UpdateSectorWithScoutedUnits(AAISector *sector, int currentFrame)
 {
 	const SectorIndex& index = sector->GetSectorIndex();
 
@@ -114,19 +430,15 @@ void AAIScoutedUnitsMap::UpdateSectorWithScoutedUnits(AAISector *sector, std::ve
 			const UnitDefId unitDefId(m_scoutedUnitsMap[tileIndex]);
 
 			if(unitDefId.IsValid())
-			{
 				sector->AddScoutedEnemyUnit(unitDefId, currentFrame - m_lastUpdateInFrameMap[tileIndex]);
-
-				const int continentId = AAIMap::s_continentMap.GetContinentID( MapPos((xStart+x)*scoutMapResolution, (yStart+y)*scoutMapResolution) );
-				
-				++buildingsOnContinent[continentId];
-			}
 			
 			++tileIndex;
 		}
 
 		tileIndex += (m_xScoutMapSize-xCells);
 	}
+
+	m_sectorChanged[index.x + index.y * m_xSectors] = false;
 }
 
 void AAIContinentMap::Init(int xMapSize, int yMapSize)
@@ -178,122 +490,376 @@ int AAIContinentMap::GetContinentID(const float3& pos) const
 	return m_continentMap[x + y * m_xContMapSize];
 }
 
-void AAIContinentMap::CheckIfTileBelongsToLandContinent(int continentMapTileIndex, float tileHeight, std::vector<AAIContinent>& continents, int continentId, std::vector<int>* nextEdgeCells)
+void AAIContinentMap::DetermineConnectedTiles(const std::vector<uint8_t>& connectable, std::vector<int>& componentRoots) const
 {
-	if(m_continentMap[continentMapTileIndex] == -1)
+	// componentRoots is used to store the parent of every tile during labelling (tile is a root if it is its own parent);
+	// the root of a component is always the tile with the lowest index, i.e. parent index <= tile index
+	componentRoots.assign(connectable.size(), -1);
+
+	auto findRoot = [&componentRoots](int tile)
 	{
-		// if height is above sea level, the tile belongs to the same continent
-		// -> set it on list whose neighbours shall be checked in the next iteration
-		if(tileHeight >= 0.0f)
+		while(componentRoots[tile] != tile)
 		{
-			m_continentMap[continentMapTileIndex] = continentId;
-			continents[continentId].size += 1;
-			nextEdgeCells->push_back( continentMapTileIndex );
+			componentRoots[tile] = componentRoots[componentRoots[tile]];
+			tile = componentRoots[tile];
 		}
-		// if height is below sea level but not below maximum water depth for non amphibious land units
-		// -> tile does not belong to land continent but check its neighbours in the next iteration
-		// -> ensures that connected land masses are detected as one continent
-		else if(tileHeight >= - cfg->NON_AMPHIB_MAX_WATERDEPTH)
+
+		return tile;
+	};
+
+	auto unite = [&componentRoots, &findRoot](int tile1, int tile2)
+	{
+		const int root1 = findRoot(tile1);
+		const int root2 = findRoot(tile2);
+
+		if(root1 < root2)
+			componentRoots[root2] = root1;
+		else if(root2 < root1)
+			componentRoots[root1] = root2;
+	};
+
+	// first pass: link every tile with its left and upper neighbour
+	for(int y = 0; y < m_yContMapSize; ++y)
+	{
+		for(int x = 0; x < m_xContMapSize; ++x)
 		{
-			m_continentMap[continentMapTileIndex] = -2;
-			nextEdgeCells->push_back( continentMapTileIndex );
+			const int tile = x + y * m_xContMapSize;
+
+			if(connectable[tile])
+			{
+				componentRoots[tile] = tile;
+
+				if( (x > 0) && connectable[tile-1] )
+					unite(tile, tile-1);
+
+				if( (y > 0) && connectable[tile-m_xContMapSize] )
+					unite(tile, tile-m_xContMapSize);
+			}
 		}
 	}
+
+	// second pass: the parent of every tile with a lower index already points to its root
+	for(int tile = 0; tile < static_cast<int>(componentRoots.size()); ++tile)
+	{
+		if(componentRoots[tile] >= 0)
+			componentRoots[tile] = componentRoots[componentRoots[tile]];
+	}
 }
 
-void AAIContinentMap::CheckIfTileBelongsToSeaContinent(int continentMapTileIndex, float tileHeight, std::vector<AAIContinent>& continents, int continentId, std::vector<int>* nextEdgeCells)
+void AAIContinentMap::AddContinents(const std::vector<int>& componentRoots, const std::vector<uint8_t>& continentTiles, bool water, std::vector<AAIContinent>& continents)
 {
-	if( (m_continentMap[continentMapTileIndex] < 0) && (tileHeight < 0.0f) )
+	// continent ids are assigned in the order of the first tile of every component when iterating column by column
+	constexpr int noTile = std::numeric_limits<int>::max();
+	std::vector<int> firstTileOfComponent(componentRoots.size(), noTile);
+
+	for(int y = 0; y < m_yContMapSize; ++y)
+	{
+		for(int x = 0; x < m_xContMapSize; ++x)
+		{
+			const int tile = x + y * m_xContMapSize;
+
+			if(continentTiles[tile])
+			{
+				int& firstTile = firstTileOfComponent[componentRoots[tile]];
+				firstTile = std::min(firstTile, y + x * m_yContMapSize);
+			}
+		}
+	}
+
+	std::vector< std::pair<int, int> > components; // first tile (column by column), root
+
+	for(int tile = 0; tile < static_cast<int>(firstTileOfComponent.size()); ++tile)
 	{
-		m_continentMap[continentMapTileIndex] = continentId;
-		continents[continentId].size += 1;
-		nextEdgeCells->push_back(continentMapTileIndex);	
+		if(firstTileOfComponent[tile] != noTile)
+			components.push_back( std::pair<int, int>(firstTileOfComponent[tile], tile) );
+	}
+
+	std::sort(components.begin(), components.end());
+
+	// reuse buffer to store continent id of every component root
+	std::vector<int>& continentIdOfRoot = firstTileOfComponent;
+
+	for(const auto& component : components)
+	{
+		continentIdOfRoot[component.second] = static_cast<int>(continents.size());
+		continents.push_back( AAIContinent(static_cast<int>(continents.size()), 0, water) );
+	}
+
+	for(int tile = 0; tile < static_cast<int>(continentTiles.size()); ++tile)
+	{
+		if(continentTiles[tile])
+		{
+			const int continentId = continentIdOfRoot[componentRoots[tile]];
+
+			m_continentMap[tile] = continentId;
+			continents[continentId].size += 1;
+		}
 	}
 }
-				
+
 void AAIContinentMap::DetectContinents(std::vector<AAIContinent>& continents, const float *heightMap, const int xMapSize, const int yMapSize)
 {
-	// In every iteration, one of those two containers will be used to store the newly identified edge tiles
-	// After each iteration, the containers will be flipped  to check for further neighbours.
-	// When no new edge cells are found the detection of the current continent has been completed.
-	std::vector<int> edgeTiles1, edgeTiles2;
+	const int numberOfTiles = m_xContMapSize * m_yContMapSize;
 
-	std::vector<int>* new_edge_cells(&edgeTiles1);
-	std::vector<int>* old_edge_cells(&edgeTiles2);
+	std::fill(m_continentMap.begin(), m_continentMap.end(), -1);
+	continents.clear();
 
-	int continentId(0);
+	std::vector<float> tileHeights(numberOfTiles);
 
-	std::array<bool, 2> detectSeaContinents = {false, true};
+	for(int y = 0; y < m_yContMapSize; ++y)
+	{
+		for(int x = 0; x < m_xContMapSize; ++x)
+			tileHeights[x + y * m_xContMapSize] = heightMap[continentMapResolution * (y * xMapSize + x)];
+	}
+
+	std::vector<uint8_t> connectable(numberOfTiles), continentTiles(numberOfTiles);
+	std::vector<int>     componentRoots;
 
-	for(auto water : detectSeaContinents)
+	//-----------------------------------------------------------------------------------------------------------------
+	// land continents: tiles above sea level belong to a land continent, tiles below sea level but not below maximum
+	// water depth for non amphibious land units connect land masses (but do not belong to a continent themselves)
+	//-----------------------------------------------------------------------------------------------------------------
+	const float maxWaterDepth = cfg->NON_AMPHIB_MAX_WATERDEPTH;
+
+	for(int tile = 0; tile < numberOfTiles; ++tile)
 	{
-		// decide which function shall be used to check if a tile belongs to the current continent
-		void (AAIContinentMap::*checkMapTile) (int, float, std::vector<AAIContinent>&, int, std::vector<int>* ) = water ? 
-								&AAIContinentMap::CheckIfTileBelongsToSeaContinent : &AAIContinentMap::CheckIfTileBelongsToLandContinent;
+		continentTiles[tile] = (tileHeights[tile] >= 0.0f);
+		connectable[tile]    = (tileHeights[tile] >= - maxWaterDepth) || continentTiles[tile];
+	}
 
-		for(int i = 0; i < m_xContMapSize; i += 1)
-		{
-			for(int j = 0; j < m_yContMapSize; j += 1)
-			{
-				// sea continents are checked in the second iteration
-				const bool tileHeightCheckPassed = water || (heightMap[4 * (j * xMapSize + i)] >= 0.0f);
+	DetermineConnectedTiles(connectable, componentRoots);
+	AddContinents(componentRoots, continentTiles, false, continents);
 
-				// add new continent if cell has not been visited yet
-				if( (m_continentMap[j * m_xContMapSize + i] < 0) && tileHeightCheckPassed )
-				{
-					AAIContinent newContinent(continentId, 1, water);
-					continents.push_back(newContinent);
+	//-----------------------------------------------------------------------------------------------------------------
+	// sea continents: all connected tiles below sea level (regardless of whether they connect land continents)
+	//-----------------------------------------------------------------------------------------------------------------
+	for(int tile = 0; tile < numberOfTiles; ++tile)
+		continentTiles[tile] = (tileHeights[tile] < 0.0f);
 
-					m_continentMap[j * m_xContMapSize + i] = continentId;
+	DetermineConnectedTiles(continentTiles, componentRoots);
+	AddContinents(componentRoots, continentTiles, true, continents);
+}
 
-					old_edge_cells->push_back(j * m_xContMapSize + i);
+void AAIMetalSpotMap::Clear()
+{
+	m_xCells = 0;
+	m_yCells = 0;
+	m_wordsPerContinent = 0;
+
+	m_spots.clear();
+	m_continentOfSpot.clear();
+	m_spotsSortedByCell.clear();
+	m_cellOffsets.clear();
+	m_freeSpotsOfContinent.clear();
+}
 
-					// check edges of the continent as long as new cells have been added to the continent during the last loop
-					while(old_edge_cells->size() > 0)
-					{
-						for(auto cell : *old_edge_cells)
-						{
-							// get cell indizes
-							const int x = cell%m_xContMapSize;
-							const int y = (cell - x) / m_xContMapSize;
+void AAIMetalSpotMap::CreateIndex(const AAIContinentMap& continentMap, int numberOfContinents, int xSize, int ySize)
+{
+	const int numberOfSpots = GetNumberOfSpots();
 
-							const int continentMapTileIndex = y * m_xContMapSize + x;
-							const int heightMapTileIndex    = 4 * (y * xMapSize + x);
+	m_xCells = std::max(1, static_cast<int>(std::ceil(static_cast<float>(xSize) / AAIConstants::metalSpotGridCellSize)));
+	m_yCells = std::max(1, static_cast<int>(std::ceil(static_cast<float>(ySize) / AAIConstants::metalSpotGridCellSize)));
 
-							if(x > 0)
-								(this->*checkMapTile)(continentMapTileIndex-1, heightMap[heightMapTileIndex-continentMapResolution], continents, continentId, new_edge_cells);
+	//-----------------------------------------------------------------------------------------------------------------
+	// sort spots by cell (counting sort)
+	//-----------------------------------------------------------------------------------------------------------------
+	std::vector<int> cellOfSpot(numberOfSpots);
+	m_cellOffsets.assign(m_xCells * m_yCells + 1, 0);
 
-							if(x < m_xContMapSize-1)
-								(this->*checkMapTile)(continentMapTileIndex+1, heightMap[heightMapTileIndex+continentMapResolution], continents, continentId, new_edge_cells);
+	for(int i = 0; i < numberOfSpots; ++i)
+	{
+		cellOfSpot[i] = DetermineCell(m_spots[i].pos.x, m_xCells) + DetermineCell(m_spots[i].pos.z, m_yCells) * m_xCells;
+		++m_cellOffsets[cellOfSpot[i] + 1];
+	}
 
-							if(y > 0)
-								(this->*checkMapTile)(continentMapTileIndex-m_xContMapSize, heightMap[heightMapTileIndex-continentMapResolution*xMapSize], continents, continentId, new_edge_cells);					
+	for(int cell = 0; cell < m_xCells * m_yCells; ++cell)
+		m_cellOffsets[cell + 1] += m_cellOffsets[cell];
 
-							if(y < m_yContMapSize-1)
-								(this->*checkMapTile)(continentMapTileIndex+m_xContMapSize, heightMap[heightMapTileIndex+continentMapResolution*xMapSize], continents, continentId, new_edge_cells);
-						}
+	std::vector<int> nextSlot(m_cellOffsets.begin(), m_cellOffsets.end() - 1);
+	m_spotsSortedByCell.resize(numberOfSpots);
 
-						old_edge_cells->clear();
+	for(int i = 0; i < numberOfSpots; ++i)
+		m_spotsSortedByCell[nextSlot[cellOfSpot[i]]++] = i;
 
-						// invert pointers to new/old edge cells
-						if(new_edge_cells == &edgeTiles1)
-						{
-							new_edge_cells = &edgeTiles2;
-							old_edge_cells = &edgeTiles1;
-						}
-						else
+	//-----------------------------------------------------------------------------------------------------------------
+	// occupancy bitsets
+	//-----------------------------------------------------------------------------------------------------------------
+	m_wordsPerContinent = (numberOfSpots + 63) / 64;
+	m_freeSpotsOfContinent.assign(std::max(numberOfContinents, 0) * m_wordsPerContinent, 0u);
+	m_continentOfSpot.resize(numberOfSpots);
+
+	for(int i = 0; i < numberOfSpots; ++i)
+	{
+		m_continentOfSpot[i] = continentMap.GetContinentID(m_spots[i].pos);
+
+		if( (m_spots[i].occupied == false) && (m_continentOfSpot[i] >= 0) && (m_continentOfSpot[i] < numberOfContinents) )
+			m_freeSpotsOfContinent[m_continentOfSpot[i] * m_wordsPerContinent + i / 64] |= (1ull << (i % 64));
+	}
+}
+
+int AAIMetalSpotMap::DetermineCell(float coordinate, int numberOfCells) const
+{
+	const int cell = static_cast<int>(coordinate / AAIConstants::metalSpotGridCellSize);
+	return std::max(0, std::min(cell, numberOfCells - 1));
+}
+
+bool AAIMetalSpotMap::IsFreeSpotOnContinent(int spotIndex, int continent) const
+{
+	if(continent < 0)
+		return (m_spots[spotIndex].occupied == false);
+	else
+		return (m_freeSpotsOfContinent[continent * m_wordsPerContinent + spotIndex / 64] & (1ull << (spotIndex % 64))) != 0u;
+}
+
+void AAIMetalSpotMap::SetOccupied(AAIMetalSpot* spot)
+{
+	const int index     = GetIndex(spot);
+	const int continent = m_continentOfSpot[index];
+
+	spot->occupied = true;
+
+	if( (continent >= 0) && (continent * m_wordsPerContinent < static_cast<int>(m_freeSpotsOfContinent.size())) )
+		m_freeSpotsOfContinent[continent * m_wordsPerContinent + index / 64] &= ~(1ull << (index % 64));
+}
+
+void AAIMetalSpotMap::SetUnoccupied(AAIMetalSpot* spot)
+{
+	const int index     = GetIndex(spot);
+	const int continent = m_continentOfSpot[index];
+
+	spot->SetUnoccupied();
+
+	if( (continent >= 0) && (continent * m_wordsPerContinent < static_cast<int>(m_freeSpotsOfContinent.size())) )
+		m_freeSpotsOfContinent[continent * m_wordsPerContinent + index / 64] |= (1ull << (index % 64));
+}
+
+bool AAIMetalSpotMap::AreFreeSpotsOnContinent(int continent) const
+{
+	if( (continent < 0) || (continent * m_wordsPerContinent >= static_cast<int>(m_freeSpotsOfContinent.size())) )
+		return false;
+
+	const uint64_t* freeSpots = &m_freeSpotsOfContinent[continent * m_wordsPerContinent];
+
+	for(int word = 0; word < m_wordsPerContinent; ++word)
+	{
+		if(freeSpots[word] != 0u)
+			return true;
+	}
+
+	return false;
+}
+
+AAIMetalSpot* AAIMetalSpotMap::FindClosestFreeSpot(const float3& position, int continent, const MetalSpotFilter& filter)
+{
+	if( (continent >= 0) && (AreFreeSpotsOnContinent(continent) == false) )
+		return nullptr;
+
+	const int xCell = DetermineCell(position.x, m_xCells);
+	const int yCell = DetermineCell(position.z, m_yCells);
+	const int maxRing = std::max( std::max(xCell, m_xCells - 1 - xCell), std::max(yCell, m_yCells - 1 - yCell) );
+
+	AAIMetalSpot* closestSpot(nullptr);
+	float minSquaredDistance = std::numeric_limits<float>::max();
+
+	// search in rings of cells around the given position until no closer spot can be found in the next ring
+	for(int ring = 0; ring <= maxRing; ++ring)
+	{
+		for(int y = std::max(yCell - ring, 0); y <= std::min(yCell + ring, m_yCells - 1); ++y)
+		{
+			const bool borderRow = (y == yCell - ring) || (y == yCell + ring);
+			const int  xStep     = borderRow ? 1 : 2 * ring;
+
+			for(int x = xCell - ring; x <= xCell + ring; x += xStep)
+			{
+				if( (x < 0) || (x >= m_xCells) )
+					continue;
+
+				const int cell = x + y * m_xCells;
+
+				for(int i = m_cellOffsets[cell]; i < m_cellOffsets[cell + 1]; ++i)
+				{
+					const int spotIndex = m_spotsSortedByCell[i];
+
+					if(IsFreeSpotOnContinent(spotIndex, continent))
+					{
+						const float dx = m_spots[spotIndex].pos.x - position.x;
+						const float dz = m_spots[spotIndex].pos.z - position.z;
+						const float squaredDistance = dx*dx + dz*dz;
+
+						if( (squaredDistance < minSquaredDistance) && filter(m_spots[spotIndex]) )
 						{
-							new_edge_cells = &edgeTiles1;
-							old_edge_cells = &edgeTiles2;
+							minSquaredDistance = squaredDistance;
+							closestSpot        = &m_spots[spotIndex];
 						}
 					}
-
-					// finished adding continent
-					++continentId;
-					old_edge_cells->clear();
-					new_edge_cells->clear();
 				}
 			}
 		}
+
+		// all spots in the following rings are at least ring * cell size away from the given position
+		const float minDistanceOfNextRing = static_cast<float>(ring) * AAIConstants::metalSpotGridCellSize;
+
+		if( closestSpot && (minSquaredDistance <= minDistanceOfNextRing * minDistanceOfNextRing) )
+			break;
 	}
+
+	return closestSpot;
+}
+
+void AAIMetalSpotMap::FindSpotsInRadius(std::vector<AAIMetalSpot*>& spots, const float3& position, float radius)
+{
+	if(m_spots.empty())
+		return;
+
+	const int xStart = DetermineCell(position.x - radius, m_xCells);
+	const int xEnd   = DetermineCell(position.x + radius, m_xCells);
+	const int yStart = DetermineCell(position.z - radius, m_yCells);
+	const int yEnd   = DetermineCell(position.z + radius, m_yCells);
+
+	const float squaredRadius = radius * radius;
+
+	for(int y = yStart; y <= yEnd; ++y)
+	{
+		for(int cell = xStart + y * m_xCells; cell <= xEnd + y * m_xCells; ++cell)
+		{
+			for(int i = m_cellOffsets[cell]; i < m_cellOffsets[cell + 1]; ++i)
+			{
+				AAIMetalSpot& spot = m_spots[m_spotsSortedByCell[i]];
+
+				const float dx = spot.pos.x - position.x;
+				const float dz = spot.pos.z - position.z;
+
+				if(dx*dx + dz*dz <= squaredRadius)
+					spots.push_back(&spot);
+			}
+		}
+	}
+}
+
+AAIMetalSpot* AAIMetalSpotMap::GetSpotAtPosition(const float3& position)
+{
+	if(m_spots.empty())
+		return nullptr;
+
+	// a spot belongs to all positions within 16 units in x and z direction (see AAIMetalSpot::DoesSpotBelongToPosition())
+	const int xStart = DetermineCell(position.x - 16.0f, m_xCells);
+	const int xEnd   = DetermineCell(position.x + 16.0f, m_xCells);
+	const int yStart = DetermineCell(position.z - 16.0f, m_yCells);
+	const int yEnd   = DetermineCell(position.z + 16.0f, m_yCells);
+
+	for(int y = yStart; y <= yEnd; ++y)
+	{
+		for(int cell = xStart + y * m_xCells; cell <= xEnd + y * m_xCells; ++cell)
+		{
+			for(int i = m_cellOffsets[cell]; i < m_cellOffsets[cell + 1]; ++i)
+			{
+				AAIMetalSpot& spot = m_spots[m_spotsSortedByCell[i]];
+
+				if(spot.DoesSpotBelongToPosition(position))
+					return &spot;
+			}
+		}
+	}
+
+	return nullptr;
 }
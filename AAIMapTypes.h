@@ -13,7 +13,12 @@
 #include "AAIUnitTypes.h"
 #include "AAISector.h"
 #include "AAIMapRelatedTypes.h"
+#include "AAICacheFile.h"
+#include "AAIFrameArena.h"
 #include <vector>
+#include <unordered_map>
+#include <functional>
+#include <cstdint>
 
 //! The map storing which sector has been taken (as base) by which AAI team. Used to avoid that multiple AAI instances expand 
 //! into the same sector or build defences in the sector of an allied player.
@@ -62,7 +67,7 @@ public:
 	float GetValue(MapPos mapPosition, const AAITargetType& targetType) const 
 	{
 		const int tileIndex = mapPosition.x/defenceMapResolution + m_xDefenceMapSize * (mapPosition.y/defenceMapResolution);
-		return m_defenceMaps[targetType.GetArrayIndex()][tileIndex];
+		return m_defenceMaps[numberOfLanes * tileIndex + targetType.GetArrayIndex()];
 	}
 
 	//! @brief Modifies tiles within range of given position by combat power values
@@ -70,14 +75,26 @@ public:
 	void ModifyTiles(const float3& position, float maxWeaponRange, const UnitFootprint& footprint, const TargetTypeValues& combatPower, bool addValues);
 
 private:
-	//! @brief Adds combat power values to given tile
-	void AddDefence(int tile, const TargetTypeValues& combatPower);
+	//! @brief Determines the tile in the center of the defence and its range (in defence map tiles)
+	void DetermineCenterAndRange(const float3& position, float maxWeaponRange, const UnitFootprint& footprint, int& xPos, int& yPos, int& range) const;
 
-	//! @brief Removes combat power values to given tile
-	void RemoveDefence(int tile, const TargetTypeValues& combatPower);
+	//! @brief Stores the combat power values multiplied with the given sign in the lane order of the defence maps
+	static void DetermineLaneValues(const TargetTypeValues& combatPower, float sign, float* values);
 
-	//! The maps itself
-	std::vector< std::vector<float> > m_defenceMaps;
+	//! @brief Returns the half width of every row of a disc with the given range (computed once per range)
+	const std::vector<int>& GetDiscStencil(int range);
+
+	//! @brief Adds the given values (one per lane) to a consecutive span of tiles in one row, optionally clamps results to zero
+	static void ModifyRowSpan(float* tiles, int numberOfTiles, const float* values, bool clampToZero);
+
+	//! Number of values per tile (one for each mobile target type)
+	static constexpr int numberOfLanes = AAITargetType::numberOfMobileTargetTypes;
+
+	//! The maps itself, values of the different target types are stored interleaved (numberOfLanes consecutive values per tile)
+	std::vector<float> m_defenceMaps;
+
+	//! Disc stencils indexed by range: half width of row y - yCenter + range
+	std::vector< std::vector<int> > m_discStencils;
 
 	//! Horizontal size of the defence map
 	int m_xDefenceMapSize;
@@ -89,6 +106,71 @@ private:
 	static constexpr int defenceMapResolution = 4;
 };
 
+//! Stores one bit plane (one bit per tile) of the buildmap for every tile type flag. Allows to check whether any tile within 
+//! a rectangle has one of the given tile types set with a few word operations per row instead of checking every tile.
+class AAIBuildMapBitPlanes
+{
+public:
+	//! @brief Initializes all bit planes as empty
+	void Init(int xMapSize, int yMapSize);
+
+	//! @brief Sets all bit planes according to the given buildmap
+	void SetFromBuildMap(const std::vector<BuildMapTileType>& buildmap);
+
+	//! @brief Updates the bits of the given tile according to its (new) tile type
+	void UpdateTile(int x, int y, const BuildMapTileType& tileType);
+
+	//! @brief Returns true if any tile within the given rectangle has at least one of the given tile types set (rectangle must be within map)
+	bool IsAnyTileTypeSet(int xStart, int yStart, int xSize, int ySize, const BuildMapTileType& tileTypes) const;
+
+	//! @brief Determines for every position of the given rectangle (row by row) whether a building with the given footprint placed there
+	//!        lies within the map and does not cover any tile of the footprint's invalid tile types (1 if free, 0 otherwise)
+	void DetermineFreeBuildPositions(int xStart, int yStart, int xSize, int ySize, const UnitFootprint& footprint, AAIFrameVector<uint8_t>& freePositions) const;
+
+private:
+	//! One bit plane for each bit of the tile type
+	static constexpr int numberOfPlanes = 8;
+
+	//! Number of 64 bit words per row of a bit plane
+	int m_wordsPerRow;
+
+	//! Number of 64 bit words per bit plane
+	int m_wordsPerPlane;
+
+	//! The bit planes (stored consecutively)
+	std::vector<uint64_t> m_bitPlanes;
+};
+
+//! Caches the results of the engine's check whether a certain unit type can be constructed at a given (final) build site
+class AAIBuildSiteValidationCache
+{
+public:
+	//! @brief Returns true if a result not older than the max age is available for the given unit type/position (result stored in canBuild)
+	bool GetCachedResult(int unitDefId, const float3& buildsite, int frame, bool& canBuild) const;
+
+	//! @brief Stores the result of a check (removes stale entries if max size is exceeded)
+	void AddResult(int unitDefId, const float3& buildsite, int frame, bool canBuild);
+
+	//! @brief Removes all entries (necessary whenever buildings are placed/removed)
+	void Clear() { m_cachedResults.clear(); }
+
+private:
+	//! @brief Returns the key for the given unit type and build site
+	static uint64_t GetKey(int unitDefId, const float3& buildsite);
+
+	struct CachedResult
+	{
+		//! Frame of the check
+		int  frame;
+
+		//! Result of the check
+		bool canBuild;
+	};
+
+	//! The cached results
+	std::unordered_map<uint64_t, CachedResult> m_cachedResults;
+};
+
 //! This type is used to access a specific tile of a scout map
 class ScoutMapTile
 {
@@ -111,6 +193,9 @@ public:
 	//! @brief Initializes all tiles as empty
 	AAIScoutedUnitsMap(int xMapSize, int yMapSize, int losMapResolution);
 
+	//! @brief Initializes the lookup tables to determine the sector of a tile (must be called after number/size of sectors has been determined)
+	void InitSectorLookupTables(int xSectors, int ySectors, int xSectorSizeMap, int ySectorSizeMap);
+
 	//! @brief Converts given build map coordinate to scout map coordinate
 	int BuildMapToScoutMapCoordinate(int buildMapCoordinate) const { return buildMapCoordinate/scoutMapResolution; }
 
@@ -122,10 +207,10 @@ public:
 	int GetUnitAt(const ScoutMapTile& tile) const { return m_scoutedUnitsMap[tile.m_tileIndex]; }
 
 	//! @brief Adds unit to tile
-	void AddEnemyUnit(UnitDefId defId, ScoutMapTile tile) { m_scoutedUnitsMap[tile.m_tileIndex] = defId.id; }
+	void AddEnemyUnit(UnitDefId defId, ScoutMapTile tile, std::vector<int>& unitsOnContinent, int frame) { SetTile(tile.m_tileIndex, defId.id, unitsOnContinent, frame); }
 
-	//! @brief Erases the given tiles
-	void ResetTiles(int xLosMap, int yLosMap, int frame);
+	//! @brief Erases all scouted units located on tiles within the current LOS (only occupied tiles are checked)
+	void ResetTilesInLOS(const int* losMap, int xLOSMapSize, std::vector<int>& unitsOnContinent, int frame);
 
 	//! @brief Return tile index to corresponding position (int unit coordinates)
 	ScoutMapTile GetScoutMapTile(const float3& position) const
@@ -139,18 +224,24 @@ public:
 			return ScoutMapTile(-1);	
 	}
 
+	//! @brief Returns true if any tile within the given sector has been modified since the last update of the sector
+	bool HasSectorChanged(const SectorIndex& sectorIndex) const { return m_sectorChanged[sectorIndex.x + sectorIndex.y * m_xSectors]; }
+
 	//! @brief Updates the scouted units within the given sector
-	void UpdateSectorWithScoutedUnits(AAISector *sector, std::vector<int>& buildingsOnContinent, int currentFrame);
+	void UpdateSectorWithScoutedUnits(AAISector *sector, int currentFrame);
 
 private:
+	//! @brief Sets the unit (definition id or 0 for none) on the given tile and updates the list of occupied tiles, units per continent, and sector changed flags accordingly
+	void SetTile(int tileIndex, int unitDefId, std::vector<int>& unitsOnContinent, int frame);
+
 	//! Horizontal size of the scouted units map
 	int m_xScoutMapSize;
 	
 	//! Vertical size of the scouted units map
 	int m_yScoutMapSize;
 
-	//! Factor how much larger the resolution of the scout map is compared to the LOS map
-	int m_losToScoutMapResolution;
+	//! Resolution of the LOS map with respect to map resolution
+	int m_losMapResolution;
 
 	//! Lower resolution factor with respect to map resolution
 	static constexpr int scoutMapResolution = 2;
@@ -160,6 +251,22 @@ private:
 
 	//! The map storing the frame of the last update of each tile
 	std::vector<int> m_lastUpdateInFrameMap;
+
+	//! Indices of all tiles currently occupied by a scouted unit
+	std::vector<int> m_occupiedTiles;
+
+	//! Position of each tile within m_occupiedTiles (-1 if not occupied)
+	std::vector<int> m_occupiedTilesListIndex;
+
+	//! Number of sectors in x direction
+	int m_xSectors;
+
+	//! Sector x/y-index for each column/row of the scout map (-1 if not covered by any sector)
+	std::vector<int> m_xTileToSector;
+	std::vector<int> m_yTileToSector;
+
+	//! Flag for every sector indicating that at least one of its tiles has been modified since the last update of the sector
+	std::vector<bool> m_sectorChanged;
 };
 
 //! This class stores the continent map
@@ -175,6 +282,12 @@ public:
 	//! @brief Stores continent map to given file
 	void SaveToFile(FILE* file);
 
+	//! @brief Loads continent map from given binary cache file (returns whether successful)
+	bool LoadFromCacheFile(AAICacheFileReader& reader) { return reader.GetArray(m_continentMap.data(), m_continentMap.size()); }
+
+	//! @brief Appends continent map to given binary cache file
+	void SaveToCacheFile(AAICacheFileWriter& writer) const { writer.AddArray(m_continentMap.data(), m_continentMap.size()); }
+
 	//! @brief Returns the id of continent the cell belongs to
 	int GetContinentID(const MapPos& mapPosition) const { return m_continentMap[(mapPosition.y/continentMapResolution) * m_xContMapSize + mapPosition.x / continentMapResolution]; }
 
@@ -184,15 +297,17 @@ public:
 	//! @brief Returns the number of tiles of the continent map
 	int GetSize() const { return m_xContMapSize * m_yContMapSize; }
 
-	//! @brief Determines the continents, i.e. which parts of the map are connected
+	//! @brief Determines the continents, i.e. which parts of the map are connected (previously detected continents are discarded)
 	void DetectContinents(std::vector<AAIContinent>& continents, const float *heightMap, const int xMapSize, const int yMapSize);
 
 private:
-	//! @brief Helper function for detection of continents - checks if a given tile belongs to a continent and sets values accordingly
-	void CheckIfTileBelongsToLandContinent(int continentMapTileIndex, float tileHeight, std::vector<AAIContinent>& continents, int continentId, std::vector<int>* nextEdgeCells);
+	//! @brief Helper function for detection of continents - determines the connected components of the given tiles (two pass union-find labelling) 
+	//!        and stores the index of the root tile of its component for every connectable tile (-1 for all other tiles)
+	void DetermineConnectedTiles(const std::vector<uint8_t>& connectable, std::vector<int>& componentRoots) const;
 
-	//! @brief Helper function for detection of continents - checks if a given tile belongs to a sea continent and sets values accordingly
-	void CheckIfTileBelongsToSeaContinent(int continentMapTileIndex, float tileHeight, std::vector<AAIContinent>& continents, int continentId, std::vector<int>* nextEdgeCells);
+	//! @brief Helper function for detection of continents - adds a continent for every component containing at least one of the given continent tiles
+	//!        and sets continent id of these tiles
+	void AddContinents(const std::vector<int>& componentRoots, const std::vector<uint8_t>& continentTiles, bool water, std::vector<AAIContinent>& continents);
 
 	//! Id of continent a map tile belongs to
 	std::vector<int> m_continentMap;
@@ -207,4 +322,82 @@ private:
 	static constexpr int continentMapResolution = 4;
 };
 
+//! @brief Function to decide whether a metal spot shall be considered by a search (e.g. if it is located in a suitable sector)
+typedef std::function<bool(const AAIMetalSpot&)> MetalSpotFilter;
+
+//! Stores all metal spots of the map contiguously (pointers to spots remain valid until the spots are cleared). The spots are sorted into
+//! a uniform grid for spatial queries, and for every continent a bitset marks which of the spots located on it are currently free.
+class AAIMetalSpotMap
+{
+public:
+	AAIMetalSpotMap() : m_xCells(0), m_yCells(0), m_wordsPerContinent(0) {}
+
+	//! @brief Removes all metal spots
+	void Clear();
+
+	//! @brief Adds a metal spot (only allowed before the index is created)
+	void AddSpot(const AAIMetalSpot& spot) { m_spots.push_back(spot); }
+
+	//! @brief Sorts the metal spots into the grid and initializes the occupancy bitsets (to be called after all spots have been added)
+	void CreateIndex(const AAIContinentMap& continentMap, int numberOfContinents, int xSize, int ySize);
+
+	//! @brief Returns the number of metal spots
+	int GetNumberOfSpots() const { return static_cast<int>(m_spots.size()); }
+
+	//! @brief Returns all metal spots
+	std::vector<AAIMetalSpot>& GetSpots() { return m_spots; }
+
+	//! @brief Returns all metal spots
+	const std::vector<AAIMetalSpot>& GetSpots() const { return m_spots; }
+
+	//! @brief Marks the given spot as occupied by an extractor
+	void SetOccupied(AAIMetalSpot* spot);
+
+	//! @brief Marks the given spot as free
+	void SetUnoccupied(AAIMetalSpot* spot);
+
+	//! @brief Returns whether there is at least one free metal spot on the given continent
+	bool AreFreeSpotsOnContinent(int continent) const;
+
+	//! @brief Returns the free metal spot on the given continent (any continent if negative) accepted by the filter that is closest to the given position (nullptr if none)
+	AAIMetalSpot* FindClosestFreeSpot(const float3& position, int continent, const MetalSpotFilter& filter);
+
+	//! @brief Adds all metal spots within the given radius around the given position to the given list
+	void FindSpotsInRadius(std::vector<AAIMetalSpot*>& spots, const float3& position, float radius);
+
+	//! @brief Returns the metal spot belonging to the given position (nullptr if none)
+	AAIMetalSpot* GetSpotAtPosition(const float3& position);
+
+private:
+	//! @brief Returns the index of the spot within m_spots
+	int GetIndex(const AAIMetalSpot* spot) const { return static_cast<int>(spot - m_spots.data()); }
+
+	//! @brief Returns the grid cell (x or y) for the given coordinate (clamped to the grid)
+	int DetermineCell(float coordinate, int numberOfCells) const;
+
+	//! @brief Returns whether the given spot is free and located on the given continent (any continent if negative)
+	bool IsFreeSpotOnContinent(int spotIndex, int continent) const;
+
+	//! Number of cells of the grid in x and y direction
+	int m_xCells, m_yCells;
+
+	//! Number of 64 bit words of the occupancy bitset of one continent
+	int m_wordsPerContinent;
+
+	//! All metal spots of the map
+	std::vector<AAIMetalSpot> m_spots;
+
+	//! For every metal spot, the continent it is located on
+	std::vector<int>          m_continentOfSpot;
+
+	//! Indices of the metal spots sorted by grid cell
+	std::vector<int>          m_spotsSortedByCell;
+
+	//! For every cell, the index of its first spot in m_spotsSortedByCell (one additional element marks the end)
+	std::vector<int>          m_cellOffsets;
+
+	//! One bitset per continent in which bit i is set if spot i is located on that continent and free
+	std::vector<uint64_t>     m_freeSpotsOfContinent;
+};
+
 #endif
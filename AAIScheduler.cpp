@@ -0,0 +1,136 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#include <algorithm>
+#include <chrono>
+
+#include "AAIScheduler.h"
+#include "AAI.h"
+
+AAIScheduler::AAIScheduler(AAI* ai) :
+	ai(ai)
+{
+}
+
+AAIScheduler::~AAIScheduler(void)
+{
+	m_tasks.clear();
+}
+
+void AAIScheduler::AddTask(const std::string& name, int period, int offset, int priority, int budgetInMicroseconds, ScheduledTaskFunction function)
+{
+	m_tasks.push_back( AAIScheduledTask(name, period, offset % period, priority, budgetInMicroseconds, function) );
+	m_dueTasks.reserve(m_tasks.size());
+}
+
+void AAIScheduler::Update(int frame)
+{
+	//-----------------------------------------------------------------------------------------------------------------
+	// determine tasks that are due (or have been postponed/yielded in a previous frame)
+	//-----------------------------------------------------------------------------------------------------------------
+	m_dueTasks.clear();
+
+	for(int taskIndex = 0; taskIndex < static_cast<int>(m_tasks.size()); ++taskIndex)
+	{
+		AAIScheduledTask& task = m_tasks[taskIndex];
+
+		if( (task.m_pending == false) && (frame >= task.m_nextDueFrame) )
+		{
+			task.m_pending       = true;
+			task.m_dueSinceFrame = task.m_nextDueFrame;
+		}
+
+		if(task.m_pending)
+			m_dueTasks.push_back(taskIndex);
+	}
+
+	if(m_dueTasks.empty())
+		return;
+
+	// resumed tasks first, then tasks with highest priority increased by the number of frames they have been delayed
+	std::sort(m_dueTasks.begin(), m_dueTasks.end(), [this, frame](int lhs, int rhs)
+	{
+		const AAIScheduledTask& lhsTask = m_tasks[lhs];
+		const AAIScheduledTask& rhsTask = m_tasks[rhs];
+
+		if(lhsTask.m_resuming != rhsTask.m_resuming)
+			return lhsTask.m_resuming;
+
+		return (lhsTask.m_priority + frame - lhsTask.m_dueSinceFrame) > (rhsTask.m_priority + frame - rhsTask.m_dueSinceFrame);
+	} );
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// execute tasks until time budget for this frame is used up (at least one task is executed every frame to ensure progress)
+	//-----------------------------------------------------------------------------------------------------------------
+	const auto frameStart = std::chrono::steady_clock::now();
+	bool taskExecuted(false);
+
+	for(const int taskIndex : m_dueTasks)
+	{
+		AAIScheduledTask& task = m_tasks[taskIndex];
+
+		const long usedMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - frameStart).count();
+
+		if( taskExecuted && (usedMicroseconds + task.m_budgetInMicroseconds > AAIConstants::schedulerFrameBudgetInMicroseconds) )
+			continue;
+
+		if(task.m_resuming == false)
+			++task.m_latencyHistogram[ GetLatencyBin(frame - task.m_dueSinceFrame) ];
+
+		const auto taskStart = std::chrono::steady_clock::now();
+		const bool finished  = task.m_function();
+		const long taskMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - taskStart).count();
+
+		task.m_totalMicroseconds += taskMicroseconds;
+		task.m_maxMicroseconds    = std::max(task.m_maxMicroseconds, taskMicroseconds);
+		taskExecuted = true;
+
+		if(finished)
+		{
+			++task.m_executions;
+			task.m_pending  = false;
+			task.m_resuming = false;
+
+			// keep phase of task but do not try to catch up on executions missed due to delays
+			task.m_nextDueFrame = std::max(task.m_dueSinceFrame + task.m_period, frame + 1);
+		}
+		else
+			task.m_resuming = true;
+	}
+}
+
+void AAIScheduler::PrintStatistics() const
+{
+	ai->Log("\nScheduled tasks - executions, average time per execution/max time per call (microseconds), latency histogram (0, 1, 2-3, 4-7, 8-15, 16-31, 32+ frames):\n");
+
+	for(const auto& task : m_tasks)
+	{
+		const long averageMicroseconds = (task.m_executions > 0) ? (task.m_totalMicroseconds / static_cast<long>(task.m_executions)) : 0;
+
+		ai->Log("%-30s: %5i %7li %7li  ", task.m_name.c_str(), task.m_executions, averageMicroseconds, task.m_maxMicroseconds);
+
+		for(const int executions : task.m_latencyHistogram)
+			ai->Log(" %5i", executions);
+
+		ai->Log("\n");
+	}
+}
+
+int AAIScheduler::GetLatencyBin(int delay)
+{
+	int bin(0);
+
+	while( (delay > 0) && (bin < AAIScheduledTask::numberOfLatencyBins-1) )
+	{
+		delay >>= 1;
+		++bin;
+	}
+
+	return bin;
+}
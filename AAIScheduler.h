@@ -0,0 +1,117 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#ifndef AAI_SCHEDULER_H
+#define AAI_SCHEDULER_H
+
+#include <array>
+#include <functional>
+#include <string>
+#include <vector>
+
+class AAI;
+
+//! @brief Function executed by a scheduled task - returns true if work is finished, false if task shall be resumed in the next frame
+typedef std::function<bool()> ScheduledTaskFunction;
+
+//! A periodic job (e.g. checking construction of buildings) that is executed by the scheduler
+class AAIScheduledTask
+{
+public:
+	AAIScheduledTask(const std::string& name, int period, int offset, int priority, int budgetInMicroseconds, ScheduledTaskFunction function) :
+		m_name(name),
+		m_period(period),
+		m_priority(priority),
+		m_budgetInMicroseconds(budgetInMicroseconds),
+		m_function(function),
+		m_nextDueFrame(offset),
+		m_dueSinceFrame(0),
+		m_pending(false),
+		m_resuming(false),
+		m_executions(0),
+		m_totalMicroseconds(0),
+		m_maxMicroseconds(0)
+	{
+		m_latencyHistogram.fill(0);
+	}
+
+	//! Number of bins of the latency histogram: 0, 1, 2-3, 4-7, 8-15, 16-31, 32+ frames
+	static constexpr int numberOfLatencyBins = 7;
+
+	//! Name of the task (used for logging)
+	std::string m_name;
+
+	//! The task shall be executed every m_period frames
+	int m_period;
+
+	//! Tasks with higher priority are executed first if several tasks are due in the same frame
+	int m_priority;
+
+	//! Expected execution time - task will only be started if the remaining budget of the current frame is sufficient
+	int m_budgetInMicroseconds;
+
+	//! The function to be executed
+	ScheduledTaskFunction m_function;
+
+	//! Frame when the task shall be executed next time
+	int m_nextDueFrame;
+
+	//! Frame since the current execution of the task is due
+	int m_dueSinceFrame;
+
+	//! True if task is due but has not been (completely) executed yet
+	bool m_pending;
+
+	//! True if task has been started but not finished yet (i.e. it yielded)
+	bool m_resuming;
+
+	//! Number of completed executions
+	int m_executions;
+
+	//! Total time spent executing this task (in microseconds)
+	long m_totalMicroseconds;
+
+	//! Longest time spent in a single call of this task (in microseconds)
+	long m_maxMicroseconds;
+
+	//! Number of executions that have been started with the given delay (in frames) after the task became due
+	std::array<int, numberOfLatencyBins> m_latencyHistogram;
+};
+
+//! The scheduler executes periodic tasks and spreads them over several frames if their combined cost would exceed the time budget for a single frame
+class AAIScheduler
+{
+public:
+	AAIScheduler(AAI* ai);
+
+	~AAIScheduler(void);
+
+	//! @brief Registers a new task that is executed every period frames starting at the given offset
+	void AddTask(const std::string& name, int period, int offset, int priority, int budgetInMicroseconds, ScheduledTaskFunction function);
+
+	//! @brief Executes due tasks (highest priority/longest delay first) until the time budget of the current frame is used up
+	void Update(int frame);
+
+	//! @brief Prints execution times and latency histogram of every task to the log file
+	void PrintStatistics() const;
+
+private:
+	//! @brief Returns the bin of the latency histogram for the given delay (in frames)
+	static int GetLatencyBin(int delay);
+
+	AAI* ai;
+
+	//! The registered tasks
+	std::vector<AAIScheduledTask> m_tasks;
+
+	//! Buffer for indices of the tasks that are due in the current frame (kept to avoid reallocation every frame)
+	std::vector<int> m_dueTasks;
+};
+
+#endif
@@ -14,6 +14,7 @@
 #include "AAIConfig.h"
 #include "AAIMap.h"
 #include "AAIThreatMap.h"
+#include "AAIFileWriter.h"
 
 #include "LegacyCpp/IGlobalAICallback.h"
 #include "LegacyCpp/UnitDef.h"
@@ -21,12 +22,10 @@
 AAISector::AAISector() :
 	m_sectorIndex(0, 0),
 	m_distanceToBase(-1),
-	m_lostUnits(),
+	m_sectorGrid(nullptr),
+	m_gridIndex(0),
 	m_ownBuildingsOfCategory(AAIUnitCategory::numberOfUnitCategories, 0),
 	m_enemyCombatUnits(0.0f),
-	m_enemyBuildings(0),
-	m_alliedBuildings(0),
-	m_enemyUnitsDetectedBySensor(0),
 	m_skippedAsScoutDestination(0),
 	m_failedAttemptsToConstructStaticDefence(0)
 {
@@ -37,7 +36,7 @@ AAISector::~AAISector(void)
 	m_ownBuildingsOfCategory.clear();
 }
 
-void AAISector::Init(AAI *ai, int x, int y)
+void AAISector::Init(AAI *ai, int x, int y, AAISectorGrid* sectorGrid)
 {
 	this->ai = ai;
 
@@ -45,6 +44,9 @@ void AAISector::Init(AAI *ai, int x, int y)
 	m_sectorIndex.x = x;
 	m_sectorIndex.y = y;
 
+	m_sectorGrid = sectorGrid;
+	m_gridIndex  = sectorGrid->GetIndex(x, y);
+
 	// determine map border distance
 	const int xEdgeDist = std::min(x, AAIMap::xSectors - 1 - x);
 	const int yEdgeDist = std::min(y, AAIMap::ySectors - 1 - y);
@@ -78,11 +80,17 @@ void AAISector::LoadDataFromFile(FILE* file)
 	importance_this_game = importance_learned;
 }
 
-void AAISector::SaveDataToFile(FILE* file)
+void MobileTargetTypeValues::SaveToBuffer(AAITextBuffer& buffer) const
 {
-	fprintf(file, "%f %f %f ", m_flatTilesRatio, m_waterTilesRatio, importance_this_game);
+	static_assert(AAITargetType::numberOfMobileTargetTypes == 4, "Number of mobile target types does not fit to implementation");
+	buffer.Printf("%f %f %f %f ", m_values[0], m_values[1], m_values[2], m_values[3]);	
+}
 
-	m_attacksByTargetTypeInPreviousGames.SaveToFile(file);
+void AAISector::SaveDataToBuffer(AAITextBuffer& buffer) const
+{
+	buffer.Printf("%f %f %f ", m_flatTilesRatio, m_waterTilesRatio, importance_this_game);
+
+	m_attacksByTargetTypeInPreviousGames.SaveToBuffer(buffer);
 }
 
 void AAISector::UpdateLearnedData()
@@ -126,19 +134,10 @@ bool AAISector::AddToBase(bool addToBase)
 	}
 }
 
-void AAISector::ResetLocalCombatPower() 
-{
-	m_alliedBuildings = 0;
-	m_friendlyStaticCombatPower.Reset();
-	m_friendlyMobileCombatPower.Reset();
-}
-
 void AAISector::ResetScoutedEnemiesData() 
 { 
-	m_enemyBuildings = 0;
 	m_enemyCombatUnits.Fill(0.0f);
-	m_enemyStaticCombatPower.Reset();
-	m_enemyMobileCombatPower.Reset();
+	m_sectorGrid->ResetEnemyData(m_gridIndex);
 };
 
 void AAISector::AddScoutedEnemyUnit(UnitDefId enemyDefId, int framesSinceLastUpdate)
@@ -147,11 +146,11 @@ void AAISector::AddScoutedEnemyUnit(UnitDefId enemyDefId, int framesSinceLastUpd
 	// add building to sector (and update stat_combat_power if it's a stat defence)
 	if(categoryOfEnemyUnit.IsBuilding())
 	{
-		++m_enemyBuildings;
+		m_sectorGrid->AddEnemyBuilding(m_gridIndex);
 
 		if(categoryOfEnemyUnit.IsStaticDefence())
 		{
-			m_enemyStaticCombatPower.AddCombatPower( ai->s_buildTree.GetCombatPower(enemyDefId) );
+			m_sectorGrid->AddEnemyStaticCombatPower(m_gridIndex, ai->s_buildTree.GetCombatPower(enemyDefId) );
 			m_enemyCombatUnits.AddValue(ETargetType::STATIC, 1.0f);
 		}
 	}
@@ -164,15 +163,10 @@ void AAISector::AddScoutedEnemyUnit(UnitDefId enemyDefId, int framesSinceLastUpd
 
 		m_enemyCombatUnits.AddValue(targetType, lastSeen);
 
-		m_enemyMobileCombatPower.AddCombatPower( ai->s_buildTree.GetCombatPower(enemyDefId), lastSeen );
+		m_sectorGrid->AddEnemyMobileCombatPower(m_gridIndex, ai->s_buildTree.GetCombatPower(enemyDefId), lastSeen );
 	}
 }
 
-void AAISector::DecreaseLostUnits()
-{
-	m_lostUnits.MultiplyValues(AAIConstants::lostUnitsMemoryFadeRate);
-}
-
 void AAISector::AddMetalSpot(AAIMetalSpot *spot)
 {
 	metalSpots.push_back(spot);
@@ -182,14 +176,13 @@ void AAISector::AddExtractor(UnitId unitId, UnitDefId unitDefId, float3 position
 {
 	ai->Map()->ConvertPositionToFinalBuildsite(position, ai->s_buildTree.GetFootprint(unitDefId));
 
-	for(auto spot : metalSpots)
+	AAIMetalSpot* spot = AAIMap::s_metalSpots.GetSpotAtPosition(position);
+
+	// only check occupied spots
+	if(spot && spot->occupied)
 	{
-		// only check occupied spots
-		if(spot->occupied && spot->DoesSpotBelongToPosition(position))
-		{
-			spot->extractorUnitId = unitId;
-			spot->extractorDefId  = unitDefId;
-		}
+		spot->extractorUnitId = unitId;
+		spot->extractorDefId  = unitDefId;
 	}
 }
 
@@ -198,15 +191,11 @@ void AAISector::FreeMetalSpot(float3 position, UnitDefId extractorDefId)
 	ai->Map()->ConvertPositionToFinalBuildsite(position, ai->s_buildTree.GetFootprint(extractorDefId));
 
 	// get metalspot according to position
-	for(auto spot : metalSpots)
-	{
-		// only check occupied spots
-		if(spot->occupied && spot->DoesSpotBelongToPosition(position) )
-		{
-			spot->SetUnoccupied();
-			return;
-		}	
-	}
+	AAIMetalSpot* spot = AAIMap::s_metalSpots.GetSpotAtPosition(position);
+
+	// only check occupied spots
+	if(spot && spot->occupied)
+		AAIMap::s_metalSpots.SetUnoccupied(spot);
 }
 
 float3 AAISector::GetCenter() const
@@ -353,7 +342,7 @@ float AAISector::GetRatingAsNextScoutDestination(const AAIMovementType& scoutMov
 
 		// factor between 1 and 0.4 (depending on number of recently lost units)
 		//const float lostUnits =  // scoutMoveType.IsAir() ? m_lostAirUnits : m_lostUnits;
-		const float lostScoutsFactor = 0.4f + 0.6f / (0.5f * m_lostUnits.GetValueOfTargetType(scoutTargetType) + 1.0f);
+		const float lostScoutsFactor = 0.4f + 0.6f / (0.5f * GetLostUnits(scoutTargetType) + 1.0f);
 
 		const float metalSpotsFactor = 2.0f + static_cast<float>(metalSpots.size());
 
@@ -421,7 +410,7 @@ float AAISector::GetRatingForPowerPlant(float weightPreviousGames, float weightC
 
 bool AAISector::IsSectorSuitableForBaseExpansion() const
 {
-	const bool consideredToBeSafe = (m_lostUnits.CalculateSum() < 1.0f) || m_friendlyMobileCombatPower.CalculateSum() > 2.0f;
+	const bool consideredToBeSafe = (GetTotalLostUnits() < 1.0f) || m_sectorGrid->GetTotalFriendlyMobileCombatPower(m_gridIndex) > 2.0f;
 
 	return     (IsOccupiedByEnemies() == false)
 			&& (GetNumberOfAlliedBuildings() < 3)
@@ -431,7 +420,7 @@ bool AAISector::IsSectorSuitableForBaseExpansion() const
 
 bool AAISector::ShallBeConsideredForExtractorConstruction() const
 {
-	const bool consideredToBeSafe = (m_distanceToBase == 0) || (m_lostUnits.CalculateSum() < 1.0f) || m_friendlyMobileCombatPower.CalculateSum() > 2.0f;
+	const bool consideredToBeSafe = (m_distanceToBase == 0) || (GetTotalLostUnits() < 1.0f) || m_sectorGrid->GetTotalFriendlyMobileCombatPower(m_gridIndex) > 2.0f;
 
 	return 	   (AAIMap::s_teamSectorMap.IsOccupiedByOtherTeam(m_sectorIndex, ai->GetMyTeamId()) == false)
 			&& (IsOccupiedByEnemies() == false)
@@ -538,7 +527,7 @@ float AAISector::GetEnemyCombatPowerVsUnits(const MobileTargetTypeValues& unitsO
 	float defencePower(0.0f);
 	for(const auto& targetType : AAITargetType::m_mobileTargetTypes)
 	{
-		const float totalDefPower = m_enemyStaticCombatPower.GetValueOfTargetType(targetType) + m_enemyMobileCombatPower.GetValueOfTargetType(targetType);
+		const float totalDefPower = GetEnemyCombatPower(targetType);
 		defencePower += unitsOfTargetType.GetValueOfTargetType(targetType) * totalDefPower;
 	}
 
@@ -591,7 +580,7 @@ void AAISector::UpdateThreatValues(UnitDefId destroyedDefId, UnitDefId attackerD
 	else // unit was lost
 	{
 		const AAITargetType& targetType = ai->s_buildTree.GetTargetType(destroyedDefId);
-		m_lostUnits.AddValueForTargetType(targetType, 1.0f);
+		m_sectorGrid->AddLostUnit(m_gridIndex, targetType);
 	}
 }
 
@@ -15,6 +15,7 @@
 #include "AAITypes.h"
 #include "AAIUnitTypes.h"
 #include "AAIBuildTree.h"
+#include "AAISectorGrid.h"
 
 #include <list>
 #include <vector>
@@ -66,13 +67,14 @@ public:
 	//! @brief Looks for metal spot that corresponds to given position and marks it as free
 	void FreeMetalSpot(float3 position, UnitDefId extractorDefId);
 
-	void Init(AAI *ai, int x, int y);
+	//! @brief Sets index of the sector and the grid storing the values that are updated for all sectors at once
+	void Init(AAI *ai, int x, int y, AAISectorGrid* sectorGrid);
 
 	//! @brief Loads sector data from given file
 	void LoadDataFromFile(FILE* file);
 
-	//! @brief Saves sector data to given file
-	void SaveDataToFile(FILE* file);
+	//! @brief Appends sector data (as stored in map learn file) to given buffer
+	void SaveDataToBuffer(AAITextBuffer& buffer) const;
 
 	//! @brief Updates learning data for sector
 	void UpdateLearnedData();
@@ -93,13 +95,10 @@ public:
 	int GetNumberOfBuildings(const AAIUnitCategory& category) const { return m_ownBuildingsOfCategory[category.GetArrayIndex()]; }
 
 	//! @brief Returns the number of buildings belonging to allied players 
-	int GetNumberOfAlliedBuildings() const { return m_alliedBuildings; }
+	int GetNumberOfAlliedBuildings() const { return m_sectorGrid->GetAlliedBuildings(m_gridIndex); }
 
 	//! @brief Returns the number of buildings belonging to hostile players 
-	int GetNumberOfEnemyBuildings() const { return m_enemyBuildings; }
-
-	//! @brief Resets the own combat power / number of allied buildings
-	void ResetLocalCombatPower();
+	int GetNumberOfEnemyBuildings() const { return m_sectorGrid->GetEnemyBuildings(m_gridIndex); }
 
 	//! @brief Resets the number / combat power of spotted enemy units
 	void ResetScoutedEnemiesData();
@@ -111,15 +110,12 @@ public:
 	float GetTotalEnemyCombatUnits() const { return m_enemyCombatUnits.CalcuateSum(); };
 
 	//! @brief Returns whether sector is supsected to be occupied by enemy units (according to scouting or sensor)
-	bool IsOccupiedByEnemies() const{ return (GetTotalEnemyCombatUnits() > 0.1f) || (m_enemyBuildings > 0) || (m_enemyUnitsDetectedBySensor > 0); }
+	bool IsOccupiedByEnemies() const{ return (GetTotalEnemyCombatUnits() > 0.1f) || (GetNumberOfEnemyBuildings() > 0) || (m_sectorGrid->GetEnemyUnitsDetectedBySensor(m_gridIndex) > 0); }
 
 	//! @brief Returns number of enemy units of given target type spotted in this sector (float as number decreases over time if sector is not scouted)
 	float GetNumberOfEnemyCombatUnits(const AAITargetType& targetType) const  { return m_enemyCombatUnits.GetValue(targetType); };
 	const TargetTypeValues& GetNumberOfEnemyCombatUnits() const  { return m_enemyCombatUnits; };
 
-	//! @brief Decreases number of lost units by a factor < 1 such that AAI "forgets" about lost unit over time
-	void DecreaseLostUnits();
-
 	//! @brief Returns whether sector can be considered for expansion of base
 	bool IsSectorSuitableForBaseExpansion() const;
 
@@ -154,25 +150,22 @@ public:
 	float GetEnemyCombatPowerVsUnits(const MobileTargetTypeValues& unitsOfTargetType) const;
 
 	//! @brief Get total (mobile + static) defence power vs given target type
-	float GetEnemyCombatPower(const AAITargetType& targetType) const { return m_enemyStaticCombatPower.GetValueOfTargetType(targetType) + m_enemyMobileCombatPower.GetValueOfTargetType(targetType); }
+	float GetEnemyCombatPower(const AAITargetType& targetType) const { return m_sectorGrid->GetEnemyCombatPower(m_gridIndex, targetType); }
 
 	//! @brief Returns combat power of own/allied static defences against given target type
-	float GetFriendlyStaticDefencePower(const AAITargetType& targetType) const { return m_friendlyStaticCombatPower.GetValueOfTargetType(targetType); }
+	float GetFriendlyStaticDefencePower(const AAITargetType& targetType) const { return m_sectorGrid->GetFriendlyStaticCombatPower(m_gridIndex, targetType); }
 
 	//! @brief Returns cmbat power of own/allied static defences against given target type
-	float GetFriendlyCombatPower(const AAITargetType& targetType) const { return m_friendlyStaticCombatPower.GetValueOfTargetType(targetType) + m_friendlyMobileCombatPower.GetValueOfTargetType(targetType); }
-
-	//! @brief Adds given values to friendly combat power in this sector
-	void AddFriendlyCombatPower(const TargetTypeValues& combatPower) { m_friendlyMobileCombatPower.AddCombatPower(combatPower); }
+	float GetFriendlyCombatPower(const AAITargetType& targetType) const { return m_sectorGrid->GetFriendlyCombatPower(m_gridIndex, targetType); }
 
 	//! @brief Updates threat map storing where own buildings/units got killed
 	void UpdateThreatValues(UnitDefId destroyedDefId, UnitDefId attackerDefId);
 
 	//! @brief Returns lost units in that sector
-	float GetLostUnits(const AAITargetType& targetType) const { return m_lostUnits.GetValueOfTargetType(targetType); }
+	float GetLostUnits(const AAITargetType& targetType) const { return m_sectorGrid->GetLostUnits(m_gridIndex, targetType); }
 
 	//! @brief Returns the total number (i.e. of all target types) of lost units in this sector
-	float GetTotalLostUnits() const { return m_lostUnits.CalculateSum(); }
+	float GetTotalLostUnits() const { return m_sectorGrid->GetTotalLostUnits(m_gridIndex); }
 
 	//! @brief Returns number of attacks by the main combat categories (ground, hover, air)
 	float GetTotalAttacksInThisGame() const 
@@ -248,7 +241,7 @@ public:
 	void DetermineBuildsiteRectangle(int *xStart, int *xEnd, int *yStart, int *yEnd) const;
 
 	// list of all metal spots in the sector
-	std::list<AAIMetalSpot*> metalSpots;
+	std::vector<AAIMetalSpot*> metalSpots;
 
 	// importance of the sector
 	float importance_this_game;
@@ -285,8 +278,11 @@ private:
 	//! Minimum distance to one of the map edges (in sector sizes)
 	int m_minSectorDistanceToMapEdge;
 
-	//! How many units have recently been lost in that sector (float as the number decays over time)
-	MobileTargetTypeValues m_lostUnits;
+	//! Grid storing combat power, lost units and number of enemy/allied buildings of all sectors
+	AAISectorGrid* m_sectorGrid;
+
+	//! Index of this sector within the sector grid
+	int m_gridIndex;
 
 	//! Number of own buildings of each category in the sector
 	std::vector<int> m_ownBuildingsOfCategory;
@@ -294,27 +290,6 @@ private:
 	//! Number of spotted enemy combat units (float values as number decays over time)
 	TargetTypeValues m_enemyCombatUnits; // 0 surface, 1 air, 3 ship, 4 submarine, 5 static defences
 
-	//! Number of buildings enemy players have constructed in this sector
-	int m_enemyBuildings;
-
-	//! Number of buildings allied players have constructed in this sector
-	int m_alliedBuildings;
-
-	//! Number of enemy units detected by sensor (radar/sonar)
-	int m_enemyUnitsDetectedBySensor;
-
-	//! The combat power against mobile targets of all hostile static defences in this sector
-	MobileTargetTypeValues m_enemyStaticCombatPower;
-	
-	//! The combat power against mobile targets of all hostile combat units in this sector
-	MobileTargetTypeValues m_enemyMobileCombatPower;
-
-	//! The combat power against mobile targets of all friendly static defences in this sector
-	MobileTargetTypeValues m_friendlyStaticCombatPower;
-
-	//! The combat power against mobile targets of all friendly combat units in this sector
-	MobileTargetTypeValues m_friendlyMobileCombatPower;
-
 	//! Stores how often buildings in this sector have been attacked(=destroyed) by a certain target type in previous games
 	MobileTargetTypeValues m_attacksByTargetTypeInPreviousGames;
 
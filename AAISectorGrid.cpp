@@ -0,0 +1,98 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#include "AAISectorGrid.h"
+
+#include <algorithm>
+
+void AAISectorGrid::Init(int xSectors, int ySectors)
+{
+	m_xSectors        = xSectors;
+	m_numberOfSectors = xSectors * ySectors;
+
+	const int planesSize = AAITargetType::numberOfMobileTargetTypes * m_numberOfSectors;
+
+	m_enemyStaticCombatPower.assign(planesSize, 0.0f);
+	m_enemyMobileCombatPower.assign(planesSize, 0.0f);
+	m_friendlyStaticCombatPower.assign(planesSize, 0.0f);
+	m_friendlyMobileCombatPower.assign(planesSize, 0.0f);
+	m_lostUnits.assign(planesSize, 0.0f);
+
+	m_friendlyCombatUnits.assign(m_numberOfSectors, 0);
+	m_enemyBuildings.assign(m_numberOfSectors, 0);
+	m_alliedBuildings.assign(m_numberOfSectors, 0);
+	m_enemyUnitsDetectedBySensor.assign(m_numberOfSectors, 0);
+}
+
+void AAISectorGrid::ResetEnemyData(int sector)
+{
+	m_enemyBuildings[sector] = 0;
+
+	for(int plane = sector; plane < static_cast<int>(m_enemyStaticCombatPower.size()); plane += m_numberOfSectors)
+	{
+		m_enemyStaticCombatPower[plane] = 0.0f;
+		m_enemyMobileCombatPower[plane] = 0.0f;
+	}
+}
+
+void AAISectorGrid::RemoveFriendlyCombatUnit(int sector, const TargetTypeValues& combatPower)
+{
+	--m_friendlyCombatUnits[sector];
+
+	if(m_friendlyCombatUnits[sector] > 0)
+	{
+		AddCombatPower(m_friendlyMobileCombatPower, sector, combatPower, -1.0f);
+
+		for(int plane = sector; plane < static_cast<int>(m_friendlyMobileCombatPower.size()); plane += m_numberOfSectors)
+			m_friendlyMobileCombatPower[plane] = std::max(m_friendlyMobileCombatPower[plane], 0.0f);
+	}
+	else
+	{
+		m_friendlyCombatUnits[sector] = 0;
+
+		for(int plane = sector; plane < static_cast<int>(m_friendlyMobileCombatPower.size()); plane += m_numberOfSectors)
+			m_friendlyMobileCombatPower[plane] = 0.0f;
+	}
+}
+
+void AAISectorGrid::DecreaseLostUnits(float factor)
+{
+	float* lostUnits = m_lostUnits.data();
+	const int size   = static_cast<int>(m_lostUnits.size());
+
+	for(int i = 0; i < size; ++i)
+		lostUnits[i] *= factor;
+}
+
+void AAISectorGrid::DetermineEnemyCombatPower(const AAITargetType& targetType, float* combatPower) const
+{
+	const float* staticCombatPower = &m_enemyStaticCombatPower[Plane(targetType)];
+	const float* mobileCombatPower = &m_enemyMobileCombatPower[Plane(targetType)];
+
+	for(int sector = 0; sector < m_numberOfSectors; ++sector)
+		combatPower[sector] = staticCombatPower[sector] + mobileCombatPower[sector];
+}
+
+void AAISectorGrid::AddCombatPower(std::vector<float>& planes, int sector, const TargetTypeValues& combatPower, float modifier)
+{
+	static_assert(AAITargetType::numberOfMobileTargetTypes == 4, "Number of mobile target types does not fit to implementation");
+	planes[0 * m_numberOfSectors + sector] += modifier * combatPower.m_values[0];
+	planes[1 * m_numberOfSectors + sector] += modifier * combatPower.m_values[1];
+	planes[2 * m_numberOfSectors + sector] += modifier * combatPower.m_values[2];
+	planes[3 * m_numberOfSectors + sector] += modifier * combatPower.m_values[3];
+}
+
+float AAISectorGrid::SumOverTargetTypes(const std::vector<float>& planes, int sector) const
+{
+	static_assert(AAITargetType::numberOfMobileTargetTypes == 4, "Number of mobile target types does not fit to implementation");
+	return    planes[0 * m_numberOfSectors + sector]
+			+ planes[1 * m_numberOfSectors + sector]
+			+ planes[2 * m_numberOfSectors + sector]
+			+ planes[3 * m_numberOfSectors + sector];
+}
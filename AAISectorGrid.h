@@ -0,0 +1,146 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#ifndef AAI_SECTORGRID_H
+#define AAI_SECTORGRID_H
+
+#include "AAITypes.h"
+#include "AAIUnitTypes.h"
+
+#include <vector>
+
+//! Stores the per sector values that are evaluated/updated for all sectors of the map at once (combat power, lost units, buildings)
+//! as contiguous arrays with one plane per target type (index of a sector: x + y * xSectors) instead of within each sector.
+class AAISectorGrid
+{
+public:
+	AAISectorGrid() : m_xSectors(0), m_numberOfSectors(0) {}
+
+	//! @brief Initializes all values with zero
+	void Init(int xSectors, int ySectors);
+
+	//! @brief Returns the index of the given sector within the planes
+	int GetIndex(int x, int y) const { return x + y * m_xSectors; }
+
+	//! @brief Returns the number of sectors
+	int GetNumberOfSectors() const { return m_numberOfSectors; }
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// values of single sectors
+	//-----------------------------------------------------------------------------------------------------------------
+	float GetEnemyStaticCombatPower(int sector, const AAITargetType& targetType) const { return m_enemyStaticCombatPower[Plane(targetType) + sector]; }
+
+	float GetEnemyCombatPower(int sector, const AAITargetType& targetType) const
+	{
+		return m_enemyStaticCombatPower[Plane(targetType) + sector] + m_enemyMobileCombatPower[Plane(targetType) + sector];
+	}
+
+	float GetFriendlyStaticCombatPower(int sector, const AAITargetType& targetType) const { return m_friendlyStaticCombatPower[Plane(targetType) + sector]; }
+
+	float GetFriendlyCombatPower(int sector, const AAITargetType& targetType) const
+	{
+		return m_friendlyStaticCombatPower[Plane(targetType) + sector] + m_friendlyMobileCombatPower[Plane(targetType) + sector];
+	}
+
+	//! @brief Returns the sum of the friendly mobile combat power vs all mobile target types
+	float GetTotalFriendlyMobileCombatPower(int sector) const { return SumOverTargetTypes(m_friendlyMobileCombatPower, sector); }
+
+	float GetLostUnits(int sector, const AAITargetType& targetType) const { return m_lostUnits[Plane(targetType) + sector]; }
+
+	//! @brief Returns the sum of lost units of all mobile target types
+	float GetTotalLostUnits(int sector) const { return SumOverTargetTypes(m_lostUnits, sector); }
+
+	int GetEnemyBuildings(int sector) const { return m_enemyBuildings[sector]; }
+
+	int GetAlliedBuildings(int sector) const { return m_alliedBuildings[sector]; }
+
+	int GetEnemyUnitsDetectedBySensor(int sector) const { return m_enemyUnitsDetectedBySensor[sector]; }
+
+	void AddEnemyStaticCombatPower(int sector, const TargetTypeValues& combatPower) { AddCombatPower(m_enemyStaticCombatPower, sector, combatPower, 1.0f); }
+
+	void AddEnemyMobileCombatPower(int sector, const TargetTypeValues& combatPower, float modifier) { AddCombatPower(m_enemyMobileCombatPower, sector, combatPower, modifier); }
+
+	//! @brief Adds the combat power of a friendly unit to the given sector
+	void AddFriendlyCombatUnit(int sector, const TargetTypeValues& combatPower)
+	{
+		++m_friendlyCombatUnits[sector];
+		AddCombatPower(m_friendlyMobileCombatPower, sector, combatPower, 1.0f);
+	}
+
+	//! @brief Removes the combat power of a friendly unit from the given sector (reset to zero when the last unit is removed to discard accumulated rounding errors)
+	void RemoveFriendlyCombatUnit(int sector, const TargetTypeValues& combatPower);
+
+	void AddLostUnit(int sector, const AAITargetType& targetType) { m_lostUnits[Plane(targetType) + sector] += 1.0f; }
+
+	void AddEnemyBuilding(int sector) { ++m_enemyBuildings[sector]; }
+
+	void AddAlliedBuilding(int sector) { ++m_alliedBuildings[sector]; }
+
+	void RemoveAlliedBuilding(int sector) { --m_alliedBuildings[sector]; }
+
+	void AddEnemyUnitDetectedBySensor(int sector) { ++m_enemyUnitsDetectedBySensor[sector]; }
+
+	void RemoveEnemyUnitDetectedBySensor(int sector) { --m_enemyUnitsDetectedBySensor[sector]; }
+
+	//! @brief Resets number of enemy buildings and enemy combat power of given sector
+	void ResetEnemyData(int sector);
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// operations on all sectors
+	//-----------------------------------------------------------------------------------------------------------------
+
+	//! @brief Multiplies lost units of all sectors with the given factor (< 1) such that AAI "forgets" about lost units over time
+	void DecreaseLostUnits(float factor);
+
+	//! @brief Stores the enemy (static + mobile) combat power vs the given target type of every sector in the given buffer
+	void DetermineEnemyCombatPower(const AAITargetType& targetType, float* combatPower) const;
+
+private:
+	//! @brief Returns offset of the plane for the given target type
+	int Plane(const AAITargetType& targetType) const { return targetType.GetArrayIndex() * m_numberOfSectors; }
+
+	void AddCombatPower(std::vector<float>& planes, int sector, const TargetTypeValues& combatPower, float modifier);
+
+	float SumOverTargetTypes(const std::vector<float>& planes, int sector) const;
+
+	//! Number of sectors in x direction
+	int m_xSectors;
+
+	//! Total number of sectors (i.e. size of one plane)
+	int m_numberOfSectors;
+
+	//! The combat power against mobile targets of all hostile static defences (one plane per mobile target type)
+	std::vector<float> m_enemyStaticCombatPower;
+
+	//! The combat power against mobile targets of all hostile combat units (one plane per mobile target type)
+	std::vector<float> m_enemyMobileCombatPower;
+
+	//! The combat power against mobile targets of all friendly static defences (one plane per mobile target type)
+	std::vector<float> m_friendlyStaticCombatPower;
+
+	//! The combat power against mobile targets of all friendly combat units (one plane per mobile target type)
+	std::vector<float> m_friendlyMobileCombatPower;
+
+	//! How many units have recently been lost (one plane per mobile target type, float as the number decays over time)
+	std::vector<float> m_lostUnits;
+
+	//! Number of friendly units whose combat power is accounted for in m_friendlyMobileCombatPower
+	std::vector<int>   m_friendlyCombatUnits;
+
+	//! Number of buildings enemy players have constructed
+	std::vector<int>   m_enemyBuildings;
+
+	//! Number of buildings allied players have constructed
+	std::vector<int>   m_alliedBuildings;
+
+	//! Number of enemy units detected by sensor (radar/sonar)
+	std::vector<int>   m_enemyUnitsDetectedBySensor;
+};
+
+#endif
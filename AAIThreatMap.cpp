@@ -10,8 +10,16 @@
 #include "AAIThreatMap.h"
 #include "AAIMap.h"
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
 AAIThreatMap::AAIThreatMap(int xSectors, int ySectors) :
-	m_estimatedEnemyCombatPowerForSector( xSectors, std::vector<MobileTargetTypeValues>(ySectors) )
+	m_xSectors(xSectors),
+	m_ySectors(ySectors),
+	m_estimatedEnemyCombatPowerForSector(AAITargetType::numberOfMobileTargetTypes * xSectors * ySectors, 0.0f),
+	m_minimumThreatToSector(xSectors * ySectors, 0.0f)
 {
 }
 
@@ -19,21 +27,18 @@ AAIThreatMap::~AAIThreatMap(void)
 {
 }
 
-void AAIThreatMap::UpdateLocalEnemyCombatPower(const AAITargetType& targetType, const SectorMap& sectors)
+void AAIThreatMap::UpdateLocalEnemyCombatPower(const AAITargetType& targetType, const AAISectorGrid& sectorGrid)
 {
-	for(size_t x = 0; x < sectors.size(); ++x)
-	{
-		for(size_t y = 0; y < sectors[x].size(); ++y)
-		{
-			m_estimatedEnemyCombatPowerForSector[x][y].SetValueForTargetType(targetType, sectors[x][y].GetEnemyCombatPower(targetType) );
-		}
-	}
+	sectorGrid.DetermineEnemyCombatPower(targetType, &m_estimatedEnemyCombatPowerForSector[targetType.GetArrayIndex() * m_xSectors * m_ySectors]);
 }
 
 const AAISector* AAIThreatMap::DetermineSectorToAttack(const AAITargetType& attackerTargetType, const MapPos& mapPosition, const SectorMap& sectors) const
 {
 	const float3 position( static_cast<float>(mapPosition.x * SQUARE_SIZE), 0.0f, static_cast<float>(mapPosition.y * SQUARE_SIZE));
-	const SectorIndex startSectorIndex = AAIMap::GetSectorIndex(position);
+	const SectorIndex startSectorIndex = ClampToMap( AAIMap::GetSectorIndex(position) );
+
+	// determine enemy combat power on the way to every sector at once
+	CalculateMinimumThreatToSectors<EThreatType::COMBAT_POWER>(attackerTargetType, startSectorIndex, sectors);
 
 	float highestRating(0.0f);
 	const AAISector* selectedSector = nullptr;
@@ -58,7 +63,7 @@ const AAISector* AAIThreatMap::DetermineSectorToAttack(const AAITargetType& atta
 				// value between 0.1 (15 or more recently lost units) and 1 (no lost units)
 				const float lostUnitsRating = std::max(1.0f - sectors[x][y].GetTotalLostUnits() / 15.0f, 0.1f);
 
-				const float enemyCombatPower = CalculateThreat<EThreatType::COMBAT_POWER>(attackerTargetType, startSectorIndex, SectorIndex(x, y), sectors);
+				const float enemyCombatPower = m_minimumThreatToSector[x + y * m_xSectors];
 
 				const float rating =  static_cast<float>(enemyBuildings) / (0.1f + enemyCombatPower) * (1.0 - distRating) * lostUnitsRating;
 
@@ -76,55 +81,94 @@ const AAISector* AAIThreatMap::DetermineSectorToAttack(const AAITargetType& atta
 
 float AAIThreatMap::CalculateEnemyDefencePower(const AAITargetType& targetType, const float3& startPosition, const float3& targetPosition, const SectorMap& sectors) const
 {
-	const SectorIndex startSectorIndex  = AAIMap::GetSectorIndex(startPosition);
-	const SectorIndex targetSectorIndex = AAIMap::GetSectorIndex(targetPosition);
+	const SectorIndex startSectorIndex  = ClampToMap( AAIMap::GetSectorIndex(startPosition) );
+	const SectorIndex targetSectorIndex = ClampToMap( AAIMap::GetSectorIndex(targetPosition) );
 
 	return CalculateThreat<EThreatType::ALL>(targetType, startSectorIndex, targetSectorIndex, sectors);
 }
 
+SectorIndex AAIThreatMap::ClampToMap(const SectorIndex& sectorIndex) const
+{
+	return SectorIndex( std::max(std::min(sectorIndex.x, m_xSectors-1), 0), std::max(std::min(sectorIndex.y, m_ySectors-1), 0) );
+}
+
+template<EThreatType threatTypeToConsider>
+float AAIThreatMap::GetThreatOfSector(const AAITargetType& targetType, int x, int y, const SectorMap& sectors) const
+{
+	float threat(0.0f);
+
+	if( static_cast<int>(threatTypeToConsider) & static_cast<int>(EThreatType::COMBAT_POWER) )
+		threat += m_estimatedEnemyCombatPowerForSector[targetType.GetArrayIndex() * m_xSectors * m_ySectors + x + y * m_xSectors];
+
+	if( static_cast<int>(threatTypeToConsider) & static_cast<int>(EThreatType::LOST_UNITS) )
+		threat += sectors[x][y].GetLostUnits(targetType);
+
+	return threat;
+}
+
 template<EThreatType threatTypeToConsider>
 float AAIThreatMap::CalculateThreat(const AAITargetType& targetType, const SectorIndex& startSectorIndex, const SectorIndex& targetSectorIndex, const SectorMap& sectors) const
 {
 	float totalThreat(0.0f);
 
-	const float dx = static_cast<float>( targetSectorIndex.x - startSectorIndex.x );
-	const float dy = static_cast<float>( targetSectorIndex.y - startSectorIndex.y );
+	const int dx = targetSectorIndex.x - startSectorIndex.x;
+	const int dy = targetSectorIndex.y - startSectorIndex.y;
 
-	const float invDist = fastmath::isqrt2_nosse(dx * dx + dy * dy);
+	// every step moves to an adjacent (incl. diagonal) sector, i.e. each sector on the line is counted exactly once
+	const int steps = std::max(std::abs(dx), std::abs(dy));
 
-	SectorIndex lastSector(startSectorIndex);
-	bool targetSectorReached(false);
-	float step(1);
+	for(int step = 1; step <= steps; ++step)
+	{
+		const int x = startSectorIndex.x + static_cast<int>( std::round(static_cast<float>(step * dx) / static_cast<float>(steps)) );
+		const int y = startSectorIndex.y + static_cast<int>( std::round(static_cast<float>(step * dy) / static_cast<float>(steps)) );
 
-	/*FILE* file = fopen("AAIAttackDebug.txt", "w+");
-	fprintf(file, "Start sector:  (%i, %i)\n", startSector.x, startSector.y);
-	fprintf(file, "Target sector: (%i, %i)\n", targetSector.x, targetSector.y);
-	fprintf(file, "Distance: %f\n", 1.0f / invDist);*/
+		totalThreat += GetThreatOfSector<threatTypeToConsider>(targetType, x, y, sectors);
+	}
 
-	while(targetSectorReached == false)
-	{
-		const int x = startSectorIndex.x + static_cast<int>( step * dx * invDist );
-		const int y = startSectorIndex.y + static_cast<int>( step * dy * invDist );
+	return totalThreat;
+}
 
-		if( (x !=lastSector.x) || (y != lastSector.y) ) // avoid counting the same sector twice if step size is too low because of rounding errors
-		{
-			if( static_cast<int>(threatTypeToConsider) & static_cast<int>(EThreatType::COMBAT_POWER) )
-				totalThreat += m_estimatedEnemyCombatPowerForSector[x][y].GetValueOfTargetType(targetType);
+template<EThreatType threatTypeToConsider>
+void AAIThreatMap::CalculateMinimumThreatToSectors(const AAITargetType& targetType, const SectorIndex& startSectorIndex, const SectorMap& sectors) const
+{
+	std::fill(m_minimumThreatToSector.begin(), m_minimumThreatToSector.end(), std::numeric_limits<float>::max());
+	m_sectorsToVisit.clear();
 
-			if( static_cast<int>(threatTypeToConsider) & static_cast<int>(EThreatType::LOST_UNITS) )
-				totalThreat += sectors[x][y].GetLostUnits(targetType);
-		}
+	// min heap of sectors to be visited (lowest threat first)
+	const std::greater< std::pair<float, int> > lowestThreatFirst;
 
-		//fprintf(file, "Step: %f, sector (%i, %i), combat power: %f\n", step, x, y, m_estimatedEnemyCombatPowerForSector[x][y].GetValueOfTargetType(targetType));
+	const int startIndex = startSectorIndex.x + startSectorIndex.y * m_xSectors;
+	m_minimumThreatToSector[startIndex] = 0.0f;
+	m_sectorsToVisit.push_back( std::pair<float, int>(0.0f, startIndex) );
 
-		if((SectorIndex(x, y) == targetSectorIndex) || (step > dx+dy))
-			targetSectorReached = true;
+	while(m_sectorsToVisit.empty() == false)
+	{
+		std::pop_heap(m_sectorsToVisit.begin(), m_sectorsToVisit.end(), lowestThreatFirst);
+		const float threat = m_sectorsToVisit.back().first;
+		const int   index  = m_sectorsToVisit.back().second;
+		m_sectorsToVisit.pop_back();
 
-		++step;
-	}
+		// skip outdated entries (sector has already been reached with lower threat)
+		if(threat > m_minimumThreatToSector[index])
+			continue;
 
-	//fprintf(file, "Final combat power: %f\n", combatPower);
-	//fclose(file);
+		const int x = index % m_xSectors;
+		const int y = index / m_xSectors;
 
-	return totalThreat;
-}
\ No newline at end of file
+		for(int neighbourY = std::max(y-1, 0); neighbourY <= std::min(y+1, m_ySectors-1); ++neighbourY)
+		{
+			for(int neighbourX = std::max(x-1, 0); neighbourX <= std::min(x+1, m_xSectors-1); ++neighbourX)
+			{
+				const int   neighbourIndex  = neighbourX + neighbourY * m_xSectors;
+				const float neighbourThreat = threat + GetThreatOfSector<threatTypeToConsider>(targetType, neighbourX, neighbourY, sectors);
+
+				if(neighbourThreat < m_minimumThreatToSector[neighbourIndex])
+				{
+					m_minimumThreatToSector[neighbourIndex] = neighbourThreat;
+					m_sectorsToVisit.push_back( std::pair<float, int>(neighbourThreat, neighbourIndex) );
+					std::push_heap(m_sectorsToVisit.begin(), m_sectorsToVisit.end(), lowestThreatFirst);
+				}
+			}
+		}
+	}
+}
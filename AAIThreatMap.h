@@ -30,7 +30,7 @@ public:
 	~AAIThreatMap(void);
 
 	//! @brief Calculates the combat power values for each sector assuming given position of own units
-	void UpdateLocalEnemyCombatPower(const AAITargetType& targetType, const SectorMap& sectors);
+	void UpdateLocalEnemyCombatPower(const AAITargetType& targetType, const AAISectorGrid& sectorGrid);
 
 	//! @brief Determines sector to attack (nullptr if none found)
 	const AAISector* DetermineSectorToAttack(const AAITargetType& attackerTargetType, const MapPos& position, const SectorMap& sectors) const;
@@ -39,11 +39,34 @@ public:
 	float CalculateEnemyDefencePower(const AAITargetType& targetType, const float3& startPosition, const float3& targetPosition, const SectorMap& sectors) const;
 
 private:
+	//! @brief Returns the threat units of the given target type face when entering the given sector
+	template<EThreatType threatTypeToConsider>
+	float GetThreatOfSector(const AAITargetType& targetType, int x, int y, const SectorMap& sectors) const;
+
+	//! @brief Determines the total threat of the sectors in a straight line from start to target sector (start sector not included)
 	template<EThreatType threatTypeToConsider>
 	float CalculateThreat(const AAITargetType& targetType, const SectorIndex& startSectorIndex, const SectorIndex& targetSectorIndex, const SectorMap& sectors) const;
 
-	//! Buffer to store the estimated enemy combat power available to defend each sector
-	std::vector< std::vector<MobileTargetTypeValues> > m_estimatedEnemyCombatPowerForSector;
+	//! @brief Determines the minimum total threat (sum over the entered sectors) of any path from the start sector to every sector of the map
+	//!        (Dijkstra search over the sector grid with 8 neighbours per sector) and stores it in m_minimumThreatToSector
+	template<EThreatType threatTypeToConsider>
+	void CalculateMinimumThreatToSectors(const AAITargetType& targetType, const SectorIndex& startSectorIndex, const SectorMap& sectors) const;
+
+	//! @brief Returns the given sector index clamped to the sectors of the map
+	SectorIndex ClampToMap(const SectorIndex& sectorIndex) const;
+
+	//! Number of sectors in x/y direction
+	int m_xSectors;
+	int m_ySectors;
+
+	//! Buffer to store the estimated enemy combat power available to defend each sector (one plane per mobile target type, index x + y * m_xSectors)
+	std::vector<float> m_estimatedEnemyCombatPowerForSector;
+
+	//! Buffer to store the minimum threat to reach each sector (index x + y * m_xSectors) from the start sector of the last query
+	mutable std::vector<float> m_minimumThreatToSector;
+
+	//! Buffer for the sectors (threat, index) to be visited during the last query (kept to avoid reallocation)
+	mutable std::vector< std::pair<float, int> > m_sectorsToVisit;
 };
 
 #endif
\ No newline at end of file
@@ -20,6 +20,8 @@ typedef unsigned int   uint32_t;
 #include "AAIUnitTypes.h"
 #include "AAIMapRelatedTypes.h"
 
+class AAITextBuffer;
+
 //! Movement types that are used to describe the movement type of every unit
 enum class EMovementType : uint32_t
 {
@@ -417,11 +419,7 @@ public:
 		fscanf(file, "%f %f %f %f", &m_values[0], &m_values[1], &m_values[2], &m_values[3]);	
 	}
 
-	void SaveToFile(FILE* file) const
-	{
-		static_assert(AAITargetType::numberOfMobileTargetTypes == 4, "Number of mobile target types does not fit to implementation");
-		fprintf(file, "%f %f %f %f ", m_values[0], m_values[1], m_values[2], m_values[3]);	
-	}
+	void SaveToBuffer(AAITextBuffer& buffer) const;
 
 private:
 	std::array<float, AAITargetType::numberOfMobileTargetTypes> m_values;
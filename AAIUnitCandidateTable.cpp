@@ -0,0 +1,118 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#include "AAIUnitCandidateTable.h"
+#include "AAIBuildTree.h"
+#include "AAIBuildTable.h"
+
+#include "LegacyCpp/UnitDef.h"
+
+void AAIUnitCandidateTable::Init(const AAIBuildTree& buildTree, const AAIBuildTable& buildTable, const AAIUnitCategory& category, int side)
+{
+	const std::list<UnitDefId>& unitList = buildTree.GetUnitsInCategory(category, side);
+
+	m_numberOfUnits = static_cast<int>(unitList.size());
+
+	m_unitDefIds.assign(unitList.begin(), unitList.end());
+	m_movementTypes.resize(m_numberOfUnits);
+	m_totalCosts.resize(m_numberOfUnits);
+	m_buildtimes.resize(m_numberOfUnits);
+	m_primaryAbilities.resize(m_numberOfUnits);
+	m_secondaryAbilities.resize(m_numberOfUnits);
+	m_armed.resize(m_numberOfUnits);
+	m_cloakable.resize(m_numberOfUnits);
+
+	for(int i = 0; i < m_numberOfUnits; ++i)
+	{
+		const UnitDefId unitDefId = m_unitDefIds[i];
+		const springLegacyAI::UnitDef& unitDef = buildTable.GetUnitDef(unitDefId.id);
+
+		m_movementTypes[i]      = buildTree.GetMovementType(unitDefId);
+		m_totalCosts[i]         = buildTree.GetTotalCost(unitDefId);
+		m_buildtimes[i]         = buildTree.GetBuildtime(unitDefId);
+		m_primaryAbilities[i]   = buildTree.GetPrimaryAbility(unitDefId);
+		m_secondaryAbilities[i] = buildTree.GetSecondaryAbility(unitDefId);
+		m_armed[i]              = unitDef.weapons.empty() ? 0.0f : 1.0f;
+		m_cloakable[i]          = unitDef.canCloak ? 1.0f : 0.0f;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// ratings based on the statistics of the category (do not change during the game)
+	//-----------------------------------------------------------------------------------------------------------------
+	const AAIUnitStatistics& unitStatistics = buildTree.GetUnitStatistics(side);
+	const StatisticalData& costs              = unitStatistics.GetUnitCostStatistics(category);
+	const StatisticalData& buildtimes         = unitStatistics.GetUnitBuildtimeStatistics(category);
+	const StatisticalData& primaryAbilities   = unitStatistics.GetUnitPrimaryAbilityStatistics(category);
+	const StatisticalData& secondaryAbilities = unitStatistics.GetUnitSecondaryAbilityStatistics(category);
+
+	m_costRatings.resize(m_numberOfUnits);
+	m_buildtimeRatings.resize(m_numberOfUnits);
+	m_primaryAbilityRatings.resize(m_numberOfUnits);
+	m_secondaryAbilityRatings.resize(m_numberOfUnits);
+
+	for(int i = 0; i < m_numberOfUnits; ++i)
+	{
+		m_costRatings[i]             = costs.GetDeviationFromMax(m_totalCosts[i]);
+		m_buildtimeRatings[i]        = buildtimes.GetDeviationFromMax(m_buildtimes[i]);
+		m_primaryAbilityRatings[i]   = primaryAbilities.GetDeviationFromZero(m_primaryAbilities[i]);
+		m_secondaryAbilityRatings[i] = secondaryAbilities.GetDeviationFromZero(m_secondaryAbilities[i]);
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// data that may change during the game
+	//-----------------------------------------------------------------------------------------------------------------
+	m_combatPower.resize(m_numberOfUnits);
+	m_combatPowerRatings.resize(AAITargetType::numberOfTargetTypes * m_numberOfUnits);
+	m_constructable.resize(m_numberOfUnits);
+
+	m_combatPowerVersion = buildTree.GetCombatPowerVersion() + 1u;
+	UpdateCombatPower(buildTree);
+
+	m_constructorAvailabilityVersion = buildTable.GetConstructorAvailabilityVersion() + 1u;
+	UpdateConstructable(buildTable, buildTable.GetConstructorAvailabilityVersion());
+}
+
+void AAIUnitCandidateTable::UpdateCombatPower(const AAIBuildTree& buildTree)
+{
+	if(m_combatPowerVersion == buildTree.GetCombatPowerVersion())
+		return;
+
+	m_combatPowerVersion = buildTree.GetCombatPowerVersion();
+
+	for(int i = 0; i < m_numberOfUnits; ++i)
+		m_combatPower[i] = buildTree.GetCombatPower(m_unitDefIds[i]);
+
+	for(int targetTypeIndex = 0; targetTypeIndex < AAITargetType::numberOfTargetTypes; ++targetTypeIndex)
+	{
+		const AAITargetType targetType(static_cast<ETargetType>(targetTypeIndex));
+
+		StatisticalData combatPowerStatistics;
+
+		for(int i = 0; i < m_numberOfUnits; ++i)
+			combatPowerStatistics.AddValue(m_combatPower[i].GetValue(targetType));
+
+		combatPowerStatistics.Finalize();
+
+		float* combatPowerRatings = &m_combatPowerRatings[targetTypeIndex * m_numberOfUnits];
+
+		for(int i = 0; i < m_numberOfUnits; ++i)
+			combatPowerRatings[i] = combatPowerStatistics.GetDeviationFromZero(m_combatPower[i].GetValue(targetType));
+	}
+}
+
+void AAIUnitCandidateTable::UpdateConstructable(const AAIBuildTable& buildTable, uint32_t constructorAvailabilityVersion)
+{
+	if(m_constructorAvailabilityVersion == constructorAvailabilityVersion)
+		return;
+
+	m_constructorAvailabilityVersion = constructorAvailabilityVersion;
+
+	for(int i = 0; i < m_numberOfUnits; ++i)
+		m_constructable[i] = (buildTable.GetNumberOfAvailableConstructorsForUnit(m_unitDefIds[i]) > 0) ? 1 : 0;
+}
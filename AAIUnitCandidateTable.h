@@ -0,0 +1,135 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#ifndef AAI_UNITCANDIDATETABLE_H
+#define AAI_UNITCANDIDATETABLE_H
+
+#include "AAITypes.h"
+#include "AAIUnitTypes.h"
+
+#include <cstdint>
+#include <vector>
+
+class AAIBuildTree;
+class AAIBuildTable;
+
+//! Stores the properties of all unit types of one category of a certain side as contiguous arrays (one element per unit type,
+//! same order as the list of the build tree) together with their ratings normalized by the statistics of the category. This
+//! allows selection of a unit type by a single scan of weighted sums over the arrays instead of looking up every candidate
+//! in the build tree and normalizing its properties on every call.
+//! Data that may change during the game (combat power, availability of constructors) are updated only if the corresponding
+//! version counter has changed since the last update.
+class AAIUnitCandidateTable
+{
+public:
+	AAIUnitCandidateTable() : m_numberOfUnits(0), m_combatPowerVersion(0u), m_constructorAvailabilityVersion(0u) {}
+
+	//! @brief Stores the properties of the unit types of the given category/side and calculates the (static) ratings
+	void Init(const AAIBuildTree& buildTree, const AAIBuildTable& buildTable, const AAIUnitCategory& category, int side);
+
+	//! @brief Recalculates combat power and its ratings if combat power of any unit type has changed since last update
+	void UpdateCombatPower(const AAIBuildTree& buildTree);
+
+	//! @brief Updates which unit types can be constructed by currently available constructors (if changed since last update)
+	void UpdateConstructable(const AAIBuildTable& buildTable, uint32_t constructorAvailabilityVersion);
+
+	//! @brief Returns the number of unit types in the table
+	int GetNumberOfUnits() const { return m_numberOfUnits; }
+
+	//! @brief Returns whether the given unit type is a building that can be constructed on land/water (and (if requested) by an available constructor)
+	bool IsBuildingSelectable(int index, bool water, bool mustBeConstructable) const
+	{
+		const bool constructablePassed = !mustBeConstructable || (m_constructable[index] != 0);
+		const bool terrainPassed       = water ? m_movementTypes[index].IsStaticSea() : m_movementTypes[index].IsStaticLand();
+
+		return constructablePassed && terrainPassed;
+	}
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// raw properties
+	//-----------------------------------------------------------------------------------------------------------------
+	const UnitDefId*         GetUnitDefIds()         const { return m_unitDefIds.data(); }
+	const AAIMovementType*   GetMovementTypes()      const { return m_movementTypes.data(); }
+	const uint8_t*           GetConstructable()      const { return m_constructable.data(); }
+	const float*             GetTotalCosts()         const { return m_totalCosts.data(); }
+	const float*             GetBuildtimes()         const { return m_buildtimes.data(); }
+	const float*             GetPrimaryAbilities()   const { return m_primaryAbilities.data(); }
+	const float*             GetSecondaryAbilities() const { return m_secondaryAbilities.data(); }
+
+	//! @brief 1.0f for armed units, 0.0f otherwise
+	const float*             GetArmed()              const { return m_armed.data(); }
+
+	//! @brief 1.0f for units that can cloak, 0.0f otherwise
+	const float*             GetCloakable()          const { return m_cloakable.data(); }
+
+	const TargetTypeValues*  GetCombatPower()        const { return m_combatPower.data(); }
+
+	//-----------------------------------------------------------------------------------------------------------------
+	// normalized ratings (interval [0:1]) with respect to all unit types of the table
+	//-----------------------------------------------------------------------------------------------------------------
+
+	//! @brief Deviation of the cost from max cost
+	const float* GetCostRatings()             const { return m_costRatings.data(); }
+
+	//! @brief Deviation of the buildtime from max buildtime
+	const float* GetBuildtimeRatings()        const { return m_buildtimeRatings.data(); }
+
+	//! @brief Deviation of the primary ability (e.g. range, generated energy, stored metal) from zero
+	const float* GetPrimaryAbilityRatings()   const { return m_primaryAbilityRatings.data(); }
+
+	//! @brief Deviation of the secondary ability (e.g. speed, stored energy) from zero
+	const float* GetSecondaryAbilityRatings() const { return m_secondaryAbilityRatings.data(); }
+
+	//! @brief Deviation of the combat power vs the given target type from zero
+	const float* GetCombatPowerRatings(const AAITargetType& targetType) const { return &m_combatPowerRatings[targetType.GetArrayIndex() * m_numberOfUnits]; }
+
+private:
+	//! Number of unit types in the table
+	int                           m_numberOfUnits;
+
+	//! Version of the combat power of the build tree the stored combat power belongs to
+	uint32_t                      m_combatPowerVersion;
+
+	//! Version of the constructor availability of the build table the constructable flags belong to
+	uint32_t                      m_constructorAvailabilityVersion;
+
+	std::vector<UnitDefId>        m_unitDefIds;
+
+	std::vector<AAIMovementType>  m_movementTypes;
+
+	//! 1 if at least one constructor for the unit type is available, 0 otherwise
+	std::vector<uint8_t>          m_constructable;
+
+	std::vector<float>            m_totalCosts;
+
+	std::vector<float>            m_buildtimes;
+
+	std::vector<float>            m_primaryAbilities;
+
+	std::vector<float>            m_secondaryAbilities;
+
+	std::vector<float>            m_armed;
+
+	std::vector<float>            m_cloakable;
+
+	std::vector<TargetTypeValues> m_combatPower;
+
+	std::vector<float>            m_costRatings;
+
+	std::vector<float>            m_buildtimeRatings;
+
+	std::vector<float>            m_primaryAbilityRatings;
+
+	std::vector<float>            m_secondaryAbilityRatings;
+
+	//! Combat power ratings (one plane of m_numberOfUnits values per target type)
+	std::vector<float>            m_combatPowerRatings;
+};
+
+#endif
@@ -0,0 +1,119 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#include <limits>
+
+#include "AAIUnitSnapshot.h"
+
+#include "LegacyCpp/IAICallback.h"
+#include "LegacyCpp/UnitDef.h"
+
+//! Frame assigned to values that have never been fetched
+static constexpr int invalidFrame = std::numeric_limits<int>::min();
+
+AAIUnitSnapshot::AAIUnitSnapshot(springLegacyAI::IAICallback* aiCallback, int maxUnits) :
+	m_aiCallback(aiCallback),
+	m_maxUnits(maxUnits),
+	m_frame(0),
+	m_positionFrame(maxUnits, invalidFrame),
+	m_unitDefFrame(maxUnits, invalidFrame),
+	m_teamFrame(maxUnits, invalidFrame),
+	m_beingBuiltFrame(maxUnits, invalidFrame),
+	m_positions(maxUnits, ZeroVector),
+	m_unitDefs(maxUnits, nullptr),
+	m_teams(maxUnits, -1),
+	m_allyTeams(maxUnits, -1),
+	m_beingBuilt(maxUnits, 0)
+{
+}
+
+void AAIUnitSnapshot::InvalidateUnit(UnitId unitId)
+{
+	if(IsCached(unitId))
+	{
+		m_positionFrame[unitId.id]   = invalidFrame;
+		m_unitDefFrame[unitId.id]    = invalidFrame;
+		m_teamFrame[unitId.id]       = invalidFrame;
+		m_beingBuiltFrame[unitId.id] = invalidFrame;
+	}
+}
+
+float3 AAIUnitSnapshot::GetUnitPos(UnitId unitId)
+{
+	if(IsCached(unitId) == false)
+		return m_aiCallback->GetUnitPos(unitId.id);
+
+	if(m_positionFrame[unitId.id] != m_frame)
+	{
+		m_positions[unitId.id]     = m_aiCallback->GetUnitPos(unitId.id);
+		m_positionFrame[unitId.id] = m_frame;
+	}
+
+	return m_positions[unitId.id];
+}
+
+const springLegacyAI::UnitDef* AAIUnitSnapshot::GetUnitDef(UnitId unitId)
+{
+	if(IsCached(unitId) == false)
+		return m_aiCallback->GetUnitDef(unitId.id);
+
+	if(m_unitDefFrame[unitId.id] != m_frame)
+	{
+		m_unitDefs[unitId.id]     = m_aiCallback->GetUnitDef(unitId.id);
+		m_unitDefFrame[unitId.id] = m_frame;
+	}
+
+	return m_unitDefs[unitId.id];
+}
+
+UnitDefId AAIUnitSnapshot::GetUnitDefId(UnitId unitId)
+{
+	const springLegacyAI::UnitDef* unitDef = GetUnitDef(unitId);
+
+	return (unitDef != nullptr) ? UnitDefId(unitDef->id) : UnitDefId();
+}
+
+int AAIUnitSnapshot::GetUnitTeam(UnitId unitId)
+{
+	if(IsCached(unitId) == false)
+		return m_aiCallback->GetUnitTeam(unitId.id);
+
+	if(m_teamFrame[unitId.id] != m_frame)
+	{
+		m_teams[unitId.id]     = m_aiCallback->GetUnitTeam(unitId.id);
+		m_allyTeams[unitId.id] = m_aiCallback->GetUnitAllyTeam(unitId.id);
+		m_teamFrame[unitId.id] = m_frame;
+	}
+
+	return m_teams[unitId.id];
+}
+
+int AAIUnitSnapshot::GetUnitAllyTeam(UnitId unitId)
+{
+	if(IsCached(unitId) == false)
+		return m_aiCallback->GetUnitAllyTeam(unitId.id);
+
+	GetUnitTeam(unitId);
+
+	return m_allyTeams[unitId.id];
+}
+
+bool AAIUnitSnapshot::UnitBeingBuilt(UnitId unitId)
+{
+	if(IsCached(unitId) == false)
+		return m_aiCallback->UnitBeingBuilt(unitId.id);
+
+	if(m_beingBuiltFrame[unitId.id] != m_frame)
+	{
+		m_beingBuilt[unitId.id]      = m_aiCallback->UnitBeingBuilt(unitId.id) ? 1 : 0;
+		m_beingBuiltFrame[unitId.id] = m_frame;
+	}
+
+	return (m_beingBuilt[unitId.id] != 0);
+}
@@ -0,0 +1,84 @@
+// -------------------------------------------------------------------------
+// AAI
+//
+// A skirmish AI for the Spring engine.
+// Copyright Alexander Seizinger
+//
+// Released under GPL license: see LICENSE.html for more information.
+// -------------------------------------------------------------------------
+
+#ifndef AAI_UNITSNAPSHOT_H
+#define AAI_UNITSNAPSHOT_H
+
+#include <vector>
+
+#include "aidef.h"
+
+namespace springLegacyAI {
+	class IAICallback;
+	struct UnitDef;
+}
+
+//! Caches the state of units (position, unit definition, team, build state) queried from the engine. Every value is fetched from the 
+//! engine at most once per unit between two calls of SetFrame(), i.e. subsequent queries for the same unit within a frame do not cause
+//! further engine callbacks. The values are stored as separate arrays indexed by unit id.
+class AAIUnitSnapshot
+{
+public:
+	AAIUnitSnapshot(springLegacyAI::IAICallback* aiCallback, int maxUnits);
+
+	//! @brief Sets the current frame (all values fetched in previous frames become outdated)
+	void SetFrame(int frame) { m_frame = frame; }
+
+	//! @brief Discards the cached values of the given unit (to be called if unit definition, team or build state may change within the current frame)
+	void InvalidateUnit(UnitId unitId);
+
+	//! @brief Returns the position of the given unit
+	float3 GetUnitPos(UnitId unitId);
+
+	//! @brief Returns the unit definition of the given unit (nullptr for enemy units outside of LOS)
+	const springLegacyAI::UnitDef* GetUnitDef(UnitId unitId);
+
+	//! @brief Returns the unit type of the given unit (invalid if unit definition is not available)
+	UnitDefId GetUnitDefId(UnitId unitId);
+
+	//! @brief Returns the team of the given unit
+	int GetUnitTeam(UnitId unitId);
+
+	//! @brief Returns the ally team of the given unit
+	int GetUnitAllyTeam(UnitId unitId);
+
+	//! @brief Returns whether the given unit is still under construction
+	bool UnitBeingBuilt(UnitId unitId);
+
+private:
+	//! @brief Returns true if the given unit id can be stored in the arrays (other ids are directly forwarded to the engine)
+	bool IsCached(UnitId unitId) const { return (unitId.id >= 0) && (unitId.id < m_maxUnits); }
+
+	springLegacyAI::IAICallback* m_aiCallback;
+
+	//! Size of the arrays (maximum unit id + 1)
+	int m_maxUnits;
+
+	//! The current frame
+	int m_frame;
+
+	//! For every unit, the frame when the corresponding value has been fetched from the engine
+	std::vector<int> m_positionFrame;
+	std::vector<int> m_unitDefFrame;
+	std::vector<int> m_teamFrame;
+	std::vector<int> m_beingBuiltFrame;
+
+	std::vector<float3>                         m_positions;
+
+	std::vector<const springLegacyAI::UnitDef*> m_unitDefs;
+
+	std::vector<int>                            m_teams;
+
+	std::vector<int>                            m_allyTeams;
+
+	//! Stored as char instead of bool to avoid std::vector<bool>
+	std::vector<char>                           m_beingBuilt;
+};
+
+#endif
@@ -115,6 +115,7 @@ void AAIUnitTable::AddConstructor(UnitId unitId, UnitDefId unitDefId)
 	AAIConstructor *cons = new AAIConstructor(ai, unitId, unitDefId, unitType.IsFactory(), unitType.IsBuilder(), unitType.IsConstructionAssist(), ai->BuildTable()->GetBuildqueueOfFactory(unitDefId));
 
 	m_constructors.insert(unitId);
+	m_constructorIndex.Invalidate();
 	units[unitId.id].cons = cons;
 
 	// commander has not been requested before -> increase "requested constructors" counter as it is decreased by ConstructorFinished(...)
@@ -144,6 +145,7 @@ void AAIUnitTable::RemoveConstructor(UnitId unitId, UnitDefId unitDefId)
 
 	// erase from builders list
 	m_constructors.erase(unitId);
+	m_constructorIndex.Invalidate();
 
 	// clean up memory
 	units[unitId.id].cons->Killed();
@@ -247,87 +249,54 @@ AAIConstructor* AAIUnitTable::FindBuilder(UnitDefId building, bool commander)
 
 AvailableConstructor AAIUnitTable::FindClosestBuilder(UnitDefId building, const float3& position, bool commander)
 {
-	const int continent = AAIMap::GetContinentID(position);
+	const std::vector<AvailableConstructor>& closestBuilders = FindClosestBuilders(building, position, commander, 1);
 
-	AvailableConstructor selectedBuilder;
-
-	// look for idle builder
-	for(auto constructor : m_constructors)
-	{
-		// check all builders
-		if(ai->s_buildTree.GetUnitType(units[constructor.id].cons->m_myDefId).IsBuilder())
-		{
-			AAIConstructor* builder = units[constructor.id].cons;
+	return closestBuilders.empty() ? AvailableConstructor() : closestBuilders.front();
+}
 
-			// find idle or assisting builder, who can build this building
-			if(    builder->IsAvailableForConstruction()
-				&& ai->s_buildTree.CanBuildUnitType(builder->m_myDefId, building) )
-			{
-				const float3 builderPosition = ai->GetAICallback()->GetUnitPos(builder->m_myUnitId.id);
+const std::vector<AvailableConstructor>& AAIUnitTable::FindClosestBuilders(UnitDefId building, const float3& position, bool commander, size_t maxNumberOfBuilders)
+{
+	m_constructorIndex.Update(ai, m_constructors, units);
 
-				const bool continentCheckPassed =    (ai->s_buildTree.GetMovementType(builder->m_myDefId).CannotMoveToOtherContinents() == false) 
-												  || (AAIMap::GetContinentID(builderPosition) == continent);
-				const bool commanderCheckPassed = commander
-												  || ! ai->s_buildTree.GetUnitCategory(builder->m_myDefId).IsCommander();
+	m_constructorIndex.FindClosestConstructors(m_closestConstructors, position, AAIMap::GetContinentID(position), true, maxNumberOfBuilders, GetSuitableBuilderFilter(building, commander));
 
-				// filter out commander
-				if(continentCheckPassed && commanderCheckPassed)
-				{
-					const float dx         = builderPosition.x - position.x;
-					const float dy         = builderPosition.z - position.z;
-					const float maxSpeed   = std::max(0.1f, ai->s_buildTree.GetMaxSpeed(builder->m_myDefId));
+	return m_closestConstructors;
+}
 
-					const float travelTime = fastmath::apxsqrt(  dx * dx + dy * dy ) / maxSpeed;
+void AAIUnitTable::DetermineContinentsOfAvailableBuilders(std::vector<int>& continents, UnitDefId building, bool commander)
+{
+	m_constructorIndex.Update(ai, m_constructors, units);
 
-					if( (travelTime < selectedBuilder.TravelTimeToBuildSite()) || (selectedBuilder.IsValid() == false))
-						selectedBuilder.SetAvailableConstructor(builder, travelTime);
-				}
-			}
-		}
-	}
+	m_constructorIndex.DetermineContinents(continents, GetSuitableBuilderFilter(building, commander));
+}
 
-	return selectedBuilder;
+ConstructorFilter AAIUnitTable::GetSuitableBuilderFilter(UnitDefId building, bool commander) const
+{
+	// idle or assisting builder, who can build this building (filter out commander if not allowed)
+	return [this, building, commander](const AAIConstructor* builder)
+	{
+		return     ai->s_buildTree.GetUnitType(builder->m_myDefId).IsBuilder()
+		        && builder->IsAvailableForConstruction()
+		        && ai->s_buildTree.CanBuildUnitType(builder->m_myDefId, building)
+		        && (commander || (ai->s_buildTree.GetUnitCategory(builder->m_myDefId).IsCommander() == false) );
+	};
 }
 
 AAIConstructor* AAIUnitTable::FindClosestAssistant(const float3& pos, int /*importance*/, bool commander)
 {
-	const int continent = AAIMap::GetContinentID(pos);
-	AAIConstructor *selectedAssistant(nullptr);
-	float maxDist(0.0f);
+	m_constructorIndex.Update(ai, m_constructors, units);
 
-	// find idle builder
-	for(auto constructor : m_constructors)
+	// find idle assister (filter out commander if not allowed)
+	const ConstructorFilter isSuitableAssistant = [this, commander](const AAIConstructor* assistant)
 	{
-		// check all assisters
-		if( ai->s_buildTree.GetUnitType(units[constructor.id].cons->m_myDefId).IsConstructionAssist() )
-		{
-			AAIConstructor* assistant = units[constructor.id].cons;
+		return     ai->s_buildTree.GetUnitType(assistant->m_myDefId).IsConstructionAssist()
+		        && assistant->IsIdle()
+		        && (commander || (ai->s_buildTree.GetUnitCategory(assistant->m_myDefId).IsCommander() == false) );
+	};
 
-			// find idle assister
-			if(assistant->IsIdle())
-			{
-				const float3 assistantPosition = ai->GetAICallback()->GetUnitPos(assistant->m_myUnitId.id);
-				const AAIMovementType& moveType = ai->s_buildTree.GetMovementType(assistant->m_myDefId.id);
-
-				const bool continentCheckPassed = (moveType.CannotMoveToOtherContinents() == false) || (AAIMap::GetContinentID(assistantPosition) == continent);
-				const bool commanderCheckPassed = (commander || (ai->s_buildTree.GetUnitCategory(assistant->m_myDefId).IsCommander() == false) );
-
-				// filter out commander
-				if(continentCheckPassed && commanderCheckPassed)
-				{
-					const float dx = (pos.x - assistantPosition.x);
-					const float dy = (pos.z - assistantPosition.z);
-					const float squaredDist = dx * dx + dy * dy;
-
-					if( (squaredDist < maxDist) || (maxDist == 0.0f) )
-					{
-						maxDist = squaredDist;
-						selectedAssistant = assistant;
-					}
-				}
-			}
-		}
-	}
+	m_constructorIndex.FindClosestConstructors(m_closestConstructors, pos, AAIMap::GetContinentID(pos), false, 1, isSuitableAssistant);
+
+	AAIConstructor *selectedAssistant = m_closestConstructors.empty() ? nullptr : m_closestConstructors.front().Constructor();
 
 	// no assister found -> request one
 	/*if(!best_assistant)
@@ -424,13 +393,17 @@ void AAIUnitTable::UpdateConstructors()
 	}
 }
 
-void AAIUnitTable::CheckBombTarget(UnitId unitId, UnitDefId defId, const AAIUnitCategory& category, const float3& position)
+bool AAIUnitTable::CheckBombTarget(UnitId unitId, UnitDefId defId, const AAIUnitCategory& category, const float3& position)
 {
-	if(category.IsBuilding() && (units[unitId.id].status != BOMB_TARGET) )
+	if(category.IsBuilding() && (units[unitId.id].status != BOMB_TARGET) && AAIAirForceManager::IsPossibleStaticBombTarget(category))
 	{
 		const bool addedToTargets = ai->AirForceMgr()->CheckIfStaticBombTarget(unitId, defId, position);
 
 		if(addedToTargets)
 			units[unitId.id].status = BOMB_TARGET;
+
+		return !addedToTargets;
 	}
+
+	return false;
 }
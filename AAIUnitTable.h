@@ -14,37 +14,12 @@
 
 #include "aidef.h"
 #include "AAIBuildTable.h"
+#include "AAIConstructorIndex.h"
 
 class AAI;
 class AAIExecute;
 class AAIConstructor;
 
-//! Used to store the information of a construction unit that is currently available
-class AvailableConstructor
-{
-public:
-	AvailableConstructor(AAIConstructor* constructor, float travelTimeToBuildSite) : m_constructor(constructor), m_travelTimeToBuildSite(travelTimeToBuildSite) {}
-
-	AvailableConstructor() : AvailableConstructor(nullptr, 0.0f) {}
-
-	void SetAvailableConstructor(AAIConstructor* constructor, float travelTimeToBuildSite) 
-	{
-		m_constructor           = constructor;
-		m_travelTimeToBuildSite = travelTimeToBuildSite;
-	}
-
-	bool            IsValid()               const { return m_constructor != nullptr; }
-
-	AAIConstructor* Constructor()           const { return m_constructor; }
-
-	float           TravelTimeToBuildSite() const { return m_travelTimeToBuildSite; }
-
-private:
-	AAIConstructor* m_constructor;
-
-	float           m_travelTimeToBuildSite;
-};
-
 class AAIUnitTable
 {
 public:
@@ -110,6 +85,12 @@ public:
 	//! @brief Finds the closest builder and stores the time it needs to reach the given positon
 	AvailableConstructor FindClosestBuilder(UnitDefId building, const float3& position, bool commander);
 
+	//! @brief Finds up to the given number of builders closest to the given position (sorted by ascending travel time; result only valid until next search)
+	const std::vector<AvailableConstructor>& FindClosestBuilders(UnitDefId building, const float3& position, bool commander, size_t maxNumberOfBuilders);
+
+	//! @brief Determines the continents on which builders available for the given building are located (-1 if such a builder may move to other continents)
+	void DetermineContinentsOfAvailableBuilders(std::vector<int>& continents, UnitDefId building, bool commander);
+
 	//! @brief Finds the closests assistance suitable to assist cosntruction at given position (nullptr if none found) 
 	AAIConstructor* FindClosestAssistant(const float3& pos, int importance, bool commander);
 
@@ -142,7 +123,8 @@ public:
 	void UpdateConstructors();
 
 	//! @brief Checks if a given enemy unit may be added as target for bombers (only enemy buildings will be considered)
-	void CheckBombTarget(UnitId unitId, UnitDefId defId, const AAIUnitCategory& category, const float3& position);
+	//!        Returns true if unit is a possible bomb target that has not been added (e.g. because target list is already full)
+	bool CheckBombTarget(UnitId unitId, UnitDefId defId, const AAIUnitCategory& category, const float3& position);
 
 	AAIUnit& GetUnit(UnitId unitId) { return units[unitId.id]; }
 
@@ -156,6 +138,9 @@ public:
 	int activeFactories, futureFactories;
 
 private:
+	//! @brief Returns a filter accepting builders that are available to construct the given building
+	ConstructorFilter GetSuitableBuilderFilter(UnitDefId building, bool commander) const;
+
 	//! Number of active (i.e. not under construction anymore) units of each unit category
 	std::vector<int> m_activeUnitsOfCategory;
 
@@ -173,6 +158,12 @@ private:
 	//! A list of all constructors (mobile and static)
 	std::set<UnitId> m_constructors;
 
+	//! Spatial index of all constructors (positions updated at most once per frame)
+	AAIConstructorIndex m_constructorIndex;
+
+	//! Buffer for the results of searches in the constructor index
+	std::vector<AvailableConstructor> m_closestConstructors;
+
 	//! A list of all static sensors (radar, seismic, jammer)
 	std::set<UnitId> m_staticSensors;
 
@@ -21,6 +21,7 @@
 #define MAP_LEARN_VERSION "MAP_LEARN_0_91"
 #define MOD_LEARN_VERSION "MOD_LEARN_0_92"
 #define CONTINENT_DATA_VERSION "MOVEMENT_MAPS_0_90"
+#define BUILD_TREE_CACHE_VERSION "BUILD_TREE_0_92"
 
 #define AILOG_PATH "log/"
 #define MAP_LEARN_PATH "learn/mod/"
@@ -99,12 +100,18 @@ public:
 	//! The minimum number of frames between two updates of the units in current LOS (to avoid too heavy CPU load)
 	static constexpr int   minFramesBetweenLOSUpdates = 10;
 
+	//! Allied units are determined by querying all friendly units from the engine every n-th update of the units in LOS (own units are known from events)
+	static constexpr int   alliedUnitsUpdateInterval = 4;
+
 	//! Number of data points used to calculate smoothed energy/metal income/surplus 
 	static constexpr int   incomeSamplePoints = 16;
 
 	//! Maximum number of parallel attacks
 	static constexpr int   maxNumberOfAttacks = 3;
 
+	//! Number of rows of sectors processed per call when updating the sectors (update is continued in the following frames)
+	static constexpr int   sectorRowsPerUpdate = 4;
+
 	//! Urgency of bombing run
 	static constexpr float bombingRunUrgency = 100.0f;
 
@@ -128,6 +135,39 @@ public:
 
 	//! Threshold for enemy AA power for air raid target to be removed from the list
 	static constexpr float maxEnemyAACombatPowerForTarget = 10.0f;
+
+	//! Time (in microseconds) per frame the scheduler may spend on periodic tasks before further due tasks are postponed to the next frame
+	static constexpr int   schedulerFrameBudgetInMicroseconds = 3000;
+
+	//! Maximum age (in frames) of a cached result of the engine's check whether a building can be constructed at a certain position
+	static constexpr int   maxBuildsiteValidationCacheAge = 30;
+
+	//! Maximum number of entries in the cache of engine build site checks (stale entries are removed when exceeded)
+	static constexpr int   maxBuildsiteValidationCacheSize = 4096;
+
+	//! Maximum number of (highest rated) build site candidates that are checked with the engine per search
+	static constexpr int   maxBuildsiteCandidatesCheckedByEngine = 8;
+
+	//! Maximum number of threads used to analyse the map at startup
+	static constexpr int   maxMapAnalysisThreads = 8;
+
+	//! Minimum number of rows of the map processed by a single thread during map analysis (smaller bands are not worth the overhead of a thread)
+	static constexpr int   minRowsPerMapAnalysisThread = 32;
+
+	//! Size (in unit coordinates) of the cells of the spatial index used to look up the closest constructors
+	static constexpr float constructorIndexCellSize = 1024.0f;
+
+	//! Size (in bytes) of the memory blocks of the arena used for transient containers within one update
+	static constexpr size_t frameArenaBlockSize = 64 * 1024;
+
+	//! Number of closest builders considered for every free metal spot when assigning builders to metal spots
+	static constexpr size_t maxBuildersPerMetalSpot = 3;
+
+	//! Maximum number of extractor construction orders (to different builders) given at once
+	static constexpr int   maxExtractorOrdersPerUpdate = 3;
+
+	//! Size (in unit coordinates) of the cells of the grid used to look up metal spots
+	static constexpr float metalSpotGridCellSize = 512.0f;
 };
 
 enum UnitTask {UNIT_IDLE, UNIT_ATTACKING, DEFENDING, GUARDING, MOVING, BUILDING, SCOUTING, ASSISTING, RECLAIMING, HEADING_TO_RALLYPOINT, UNIT_KILLED, ENEMY_UNIT, BOMB_TARGET};